@@ -0,0 +1,236 @@
+/*****************************************************************************/
+/*!
+\file   CallbackTelemetry.cpp
+\author Anthony Brigante
+\par    email: anthonypbrigante\@gmail.com
+\par    GitHub Repository: https://github.com/abrigante1/GranularSynth
+\brief
+  Implementation of the CallbackTelemetry Class.
+*/
+/*****************************************************************************/
+
+#include "CallbackTelemetry.h"
+
+// ------------------------------------------------------------------------------------
+// ------------------------------------------------------------------------------------
+// ------------------------------------------------------------------------------------
+
+CallbackTelemetry::CallbackTelemetry()
+  : Thread("Callback Telemetry Writer")
+{
+  mRecords.resize(static_cast<size_t>(RecordCapacity));
+  ClearStats();
+}
+
+// ------------------------------------------------------------------------------------
+
+CallbackTelemetry::~CallbackTelemetry()
+{
+  StopRecording();
+}
+
+// ------------------------------------------------------------------------------------
+
+void CallbackTelemetry::Prepare(double sampleRate)
+{
+  mTicksPerSample = (sampleRate > 0.0) ? static_cast<double>(Time::getHighResolutionTicksPerSecond()) / sampleRate : 0.0;
+  ClearStats();
+}
+
+// ------------------------------------------------------------------------------------
+
+void CallbackTelemetry::Record(int64 startTicks, int numSamples, int numClouds)
+{
+  const int64 elapsedTicks = Now() - startTicks;
+
+  if (mResetRequested.exchange(false))
+    ClearStats();
+
+  const double deadlineTicks = mTicksPerSample.load(std::memory_order_relaxed) * numSamples;
+  if (deadlineTicks <= 0.0)
+    return;
+
+  const double load = static_cast<double>(elapsedTicks) / deadlineTicks;
+
+  // Only this Thread Writes the Statistics, so Plain Loads and Stores are Enough
+  const int64 numCallbacks = mNumCallbacks.load(std::memory_order_relaxed);
+
+  mMinLoad.store((numCallbacks == 0) ? load : jmin(load, mMinLoad.load(std::memory_order_relaxed)), std::memory_order_relaxed);
+  mMaxLoad.store(jmax(load, mMaxLoad.load(std::memory_order_relaxed)), std::memory_order_relaxed);
+  mLoadSum.store(mLoadSum.load(std::memory_order_relaxed) + load, std::memory_order_relaxed);
+
+  std::atomic<uint32>& bin = mLoadBins[static_cast<size_t>(jmin(NumLoadBins - 1, static_cast<int>(load / LoadBinWidth)))];
+  bin.store(bin.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+
+  if (load > 1.0)
+    mNumOverruns.store(mNumOverruns.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+
+  mNumCallbacks.store(numCallbacks + 1, std::memory_order_release);
+
+  if (!mRecording.load(std::memory_order_acquire))
+    return;
+
+  // Queue the Block for the Writer, Dropping it if the Writer has Fallen Behind
+  int start1, size1, start2, size2;
+  mRecordFifo.prepareToWrite(1, start1, size1, start2, size2);
+
+  if (size1 + size2 == 0)
+  {
+    mNumDropped.store(mNumDropped.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    return;
+  }
+
+  BlockRecord& record = mRecords[static_cast<size_t>(size1 > 0 ? start1 : start2)];
+  record.mStartTicks = startTicks;
+  record.mElapsedTicks = elapsedTicks;
+  record.mNumSamples = numSamples;
+  record.mNumClouds = numClouds;
+  mRecordFifo.finishedWrite(1);
+}
+
+// ------------------------------------------------------------------------------------
+
+CallbackStats CallbackTelemetry::GetStats() const
+{
+  CallbackStats stats;
+  stats.mNumCallbacks = mNumCallbacks.load(std::memory_order_acquire);
+
+  if (stats.mNumCallbacks == 0)
+    return stats;
+
+  stats.mNumOverruns = mNumOverruns.load(std::memory_order_relaxed);
+  stats.mNumDropped = mNumDropped.load(std::memory_order_relaxed);
+  stats.mMinLoad = mMinLoad.load(std::memory_order_relaxed);
+  stats.mMaxLoad = mMaxLoad.load(std::memory_order_relaxed);
+  stats.mMeanLoad = mLoadSum.load(std::memory_order_relaxed) / static_cast<double>(stats.mNumCallbacks);
+
+  // The 99th Percentile is the Top of the Bin that Reaches 99% of the Callbacks
+  // (the Bins may be a Callback Ahead of the Count, so Count them Again)
+  int64 total = 0;
+  for (const std::atomic<uint32>& bin : mLoadBins)
+    total += bin.load(std::memory_order_relaxed);
+
+  const int64 target = (total * 99 + 99) / 100;
+  int64 count = 0;
+
+  for (int i = 0; i < NumLoadBins; ++i)
+  {
+    count += mLoadBins[static_cast<size_t>(i)].load(std::memory_order_relaxed);
+
+    if (count >= target)
+    {
+      stats.mP99Load = (i == NumLoadBins - 1) ? stats.mMaxLoad : jmin(stats.mMaxLoad, (i + 1) * LoadBinWidth);
+      break;
+    }
+  }
+
+  return stats;
+}
+
+// ------------------------------------------------------------------------------------
+
+bool CallbackTelemetry::StartRecording(const File& file)
+{
+  StopRecording();
+
+  file.deleteFile();
+  std::unique_ptr<FileOutputStream> csv(new FileOutputStream(file));
+
+  if (csv->failedToOpen())
+    return false;
+
+  *csv << "start_ms,elapsed_us,deadline_us,samples,clouds,load\n";
+
+  mCsv = std::move(csv);
+  mFirstTicks = 0;
+  mRecordStartTicks = Time::getHighResolutionTicks();
+
+  // The Audio Thread may Still be Queuing a Block from the Last Recording, so the FIFO is
+  // Only Ever Emptied from this Side. Blocks it Finishes Late are Skipped by their Start Time
+  mRecordFifo.finishedRead(mRecordFifo.getNumReady());
+  mRecording = true;
+
+  startThread();
+  return true;
+}
+
+// ------------------------------------------------------------------------------------
+
+void CallbackTelemetry::StopRecording()
+{
+  if (!mRecording)
+    return;
+
+  mRecording = false;
+  stopThread(-1);
+
+  // Write the Blocks Queued Before Recording Stopped
+  WriteQueuedRecords();
+  mCsv.reset();
+}
+
+// ------------------------------------------------------------------------------------
+
+void CallbackTelemetry::run()
+{
+  while (!threadShouldExit())
+  {
+    WriteQueuedRecords();
+    wait(100);
+  }
+}
+
+// ------------------------------------------------------------------------------------
+
+void CallbackTelemetry::WriteQueuedRecords()
+{
+  const double ticksPerSecond = static_cast<double>(Time::getHighResolutionTicksPerSecond());
+  const double ticksPerSample = mTicksPerSample.load(std::memory_order_relaxed);
+
+  int start1, size1, start2, size2;
+  mRecordFifo.prepareToRead(mRecordFifo.getNumReady(), start1, size1, start2, size2);
+
+  for (int run = 0; run < 2; ++run)
+  {
+    const int start = (run == 0) ? start1 : start2;
+    const int size = (run == 0) ? size1 : size2;
+
+    for (int i = start; i < start + size; ++i)
+    {
+      const BlockRecord& record = mRecords[static_cast<size_t>(i)];
+
+      if (record.mStartTicks < mRecordStartTicks)
+        continue;
+
+      if (mFirstTicks == 0)
+        mFirstTicks = record.mStartTicks;
+
+      const double deadlineTicks = ticksPerSample * record.mNumSamples;
+
+      *mCsv << String(1000.0 * (record.mStartTicks - mFirstTicks) / ticksPerSecond, 3) << ","
+            << String(1.0e6 * record.mElapsedTicks / ticksPerSecond, 1) << ","
+            << String(1.0e6 * deadlineTicks / ticksPerSecond, 1) << ","
+            << record.mNumSamples << ","
+            << record.mNumClouds << ","
+            << String((deadlineTicks > 0.0) ? record.mElapsedTicks / deadlineTicks : 0.0, 4) << "\n";
+    }
+  }
+
+  mRecordFifo.finishedRead(size1 + size2);
+  mCsv->flush();
+}
+
+// ------------------------------------------------------------------------------------
+
+void CallbackTelemetry::ClearStats()
+{
+  mNumCallbacks.store(0, std::memory_order_relaxed);
+  mNumOverruns.store(0, std::memory_order_relaxed);
+  mNumDropped.store(0, std::memory_order_relaxed);
+  mLoadSum.store(0.0, std::memory_order_relaxed);
+  mMinLoad.store(0.0, std::memory_order_relaxed);
+  mMaxLoad.store(0.0, std::memory_order_relaxed);
+
+  for (std::atomic<uint32>& bin : mLoadBins)
+    bin.store(0, std::memory_order_relaxed);
+}
@@ -0,0 +1,184 @@
+/*****************************************************************************/
+/*!
+\file   CallbackTelemetry.h
+\author Anthony Brigante
+\par    email: anthonypbrigante\@gmail.com
+\par    GitHub Repository: https://github.com/abrigante1/GranularSynth
+\brief
+  Definition of the CallbackStats Struct and the CallbackTelemetry Class.
+  The CallbackTelemetry times every audio callback against its deadline.
+*/
+/*****************************************************************************/
+#pragma once
+#include <JuceHeader.h>
+#include <array>
+#include <vector>
+
+/**
+ *\struct: CallbackStats
+ *\author: Anthony Brigante
+ *\brief:
+    The CallbackStats Struct Summarises the Callbacks Timed Since the Last Reset.
+    Loads are the Fraction of the Block's Duration the Callback Took (1 is the Deadline).
+ */
+struct CallbackStats
+{
+  int64 mNumCallbacks = 0;  //!< Number of Callbacks Timed
+  int64 mNumOverruns = 0;   //!< Number of Callbacks that Missed their Deadline
+  int64 mNumDropped = 0;    //!< Number of Block Records Lost because the CSV Writer Fell Behind
+  double mMinLoad = 0.0;    //!< Lightest Load
+  double mMeanLoad = 0.0;   //!< Mean Load
+  double mMaxLoad = 0.0;    //!< Heaviest Load
+  double mP99Load = 0.0;    //!< 99th Percentile Load (to the Nearest LoadBinWidth)
+};
+
+/**
+ *\class: CallbackTelemetry
+ *\author: Anthony Brigante
+ *\brief:
+    The CallbackTelemetry Class times the audio callback with the monotonic
+    high resolution clock and compares each callback with its deadline, the
+    duration of the block it renders.
+
+    The audio thread is the only writer of the statistics, which are kept in
+    atomics and a histogram of loads (for the 99th percentile), so any thread
+    can read them without blocking the callback. A reset is requested by the
+    reader and carried out by the audio thread.
+
+    While recording, every block is also queued in a lock-free FIFO, and the
+    telemetry's own thread writes the queue to a CSV file.
+ */
+class CallbackTelemetry : private Thread
+{
+public:
+
+  //! Width of Each Bin of the Load Histogram (1% of the Deadline)
+  static constexpr double LoadBinWidth = 0.01;
+
+  //! Number of Bins of the Load Histogram (the Last One Holds Every Load Past 2.55)
+  static constexpr int NumLoadBins = 256;
+
+  //! Blocks the FIFO Holds Before the CSV Writer Falls Behind (Several Seconds of Small Blocks)
+  static constexpr int RecordCapacity = 16384;
+
+  /**
+   *\fn: CallbackTelemetry
+   *\brief: Constructor for a CallbackTelemetry
+   */
+  CallbackTelemetry();
+
+  /**
+   *\fn: ~CallbackTelemetry
+   *\brief: Destructor for a CallbackTelemetry, Finishes Writing the CSV File
+   */
+  ~CallbackTelemetry();
+
+  /**
+   *\fn: Prepare
+   *\brief: Sets the Sample Rate the Deadlines are Measured at and Clears the Statistics.
+            Must not be Called During a Callback (e.g. call from prepareToPlay).
+   *\param: double sampleRate - Sample Rate of the Audio Device
+   */
+  void Prepare(double sampleRate);
+
+  /**
+   *\fn: Now
+   *\brief: Reads the Clock the Callbacks are Timed With (Call at the Start of a Callback)
+   *\return: int64 - High Resolution Ticks
+   */
+  static int64 Now() { return Time::getHighResolutionTicks(); }
+
+  /**
+   *\fn: Record
+   *\brief: Records a Callback that Started at a Time and has Just Finished (Audio Thread, Never Blocks)
+   *\param: int64 startTicks - Now() at the Start of the Callback
+   *\param: int numSamples - Number of Samples the Callback Rendered
+   *\param: int numClouds - Number of Clouds the Callback Rendered
+   */
+  void Record(int64 startTicks, int numSamples, int numClouds);
+
+  /**
+   *\fn: GetStats
+   *\brief: Summarises the Callbacks Timed Since the Last Reset (Any Thread)
+   *\return: CallbackStats - The Summary
+   */
+  CallbackStats GetStats() const;
+
+  /**
+   *\fn: Reset
+   *\brief: Asks the Audio Thread to Clear the Statistics at its Next Callback
+   */
+  void Reset() { mResetRequested = true; }
+
+  /**
+   *\fn: StartRecording
+   *\brief: Starts Writing a Line per Block to a CSV File (Message Thread)
+   *\param: const File& file - File to Write (Replaced if it Exists)
+   *\return: bool - False if the File could not be Opened
+   */
+  bool StartRecording(const File& file);
+
+  /**
+   *\fn: StopRecording
+   *\brief: Stops Recording, Writing the Blocks Still Queued (Message Thread)
+   */
+  void StopRecording();
+
+  /**
+   *\fn: IsRecording
+   *\brief: Checks if Blocks are Being Written to a CSV File
+   *\return: bool - True while Recording
+   */
+  bool IsRecording() const { return mRecording; }
+
+private:
+
+  /**
+   *\struct: BlockRecord
+   *\brief: One Callback, as Written to the CSV File
+   */
+  struct BlockRecord
+  {
+    int64 mStartTicks = 0;   //!< Clock at the Start of the Callback
+    int64 mElapsedTicks = 0; //!< Duration of the Callback (in ticks)
+    int mNumSamples = 0;     //!< Number of Samples Rendered
+    int mNumClouds = 0;      //!< Number of Clouds Rendered
+  };
+
+  /**
+   *\fn: run
+   *\brief: Writes the Queued Blocks to the CSV File Until Recording Stops (Writer Thread)
+   */
+  void run() override;
+
+  /**
+   *\fn: WriteQueuedRecords
+   *\brief: Writes and Dequeues Every Block in the FIFO (Writer Thread)
+   */
+  void WriteQueuedRecords();
+
+  /**
+   *\fn: ClearStats
+   *\brief: Clears the Statistics (Audio Thread, or Before the Callbacks Start)
+   */
+  void ClearStats();
+
+  std::atomic<double> mTicksPerSample{ 0.0 };  //!< Deadline of a Sample (in ticks)
+
+  std::atomic<int64> mNumCallbacks{ 0 };       //!< Number of Callbacks Timed
+  std::atomic<int64> mNumOverruns{ 0 };        //!< Number of Callbacks that Missed their Deadline
+  std::atomic<int64> mNumDropped{ 0 };         //!< Number of Block Records Lost to a Full FIFO
+  std::atomic<double> mLoadSum{ 0.0 };         //!< Sum of Every Load, for the Mean
+  std::atomic<double> mMinLoad{ 0.0 };         //!< Lightest Load
+  std::atomic<double> mMaxLoad{ 0.0 };         //!< Heaviest Load
+  std::array<std::atomic<uint32>, NumLoadBins> mLoadBins; //!< Histogram of the Loads
+
+  std::atomic<bool> mResetRequested{ false };  //!< Set by Reset, Cleared by the Audio Thread
+
+  std::atomic<bool> mRecording{ false };       //!< True while Blocks are Queued for the CSV File
+  AbstractFifo mRecordFifo{ RecordCapacity };  //!< Read and Write Positions of the Queued Blocks
+  std::vector<BlockRecord> mRecords;           //!< Queued Blocks
+  std::unique_ptr<FileOutputStream> mCsv;      //!< CSV File Being Written (Writer Thread while Recording)
+  int64 mFirstTicks = 0;                       //!< Clock at the First Recorded Block (Writer Thread)
+  int64 mRecordStartTicks = 0;                 //!< Clock when Recording Started, Older Blocks are Left Over and Skipped
+};
@@ -1,12 +1,142 @@
 /**************************************************************************
-filename Evelope.h
+filename Envelope.h
 author Anthony Brigante
-Brief Description: 
- 
+Brief Description:
+
 Implementation and Description File of a Grain Envelope
+
+  Envelope:
+    A precomputed grain window, indexed by the normalised position of a
+    grain within its lifetime [0, 1]. One table is shared by every grain
+    of a cloud, so shaping a grain costs a single table read per sample.
 **************************************************************************/
 
+#pragma once
+#define _USE_MATH_DEFINES
+#include <math.h>
+#include <vector>
+
+
+enum EnvelopeShape
+{
+  TRAPEZOID = 0,
+  HANN,
+  TUKEY,
+  GAUSSIAN,
+  EXPONENTIAL_DECAY,
+  NUMBER_OF_ENVELOPE_SHAPES
+};
+
+// Envelope class - A Grain Window Table Shared by Every Grain of a Cloud
 class Envelope
 {
+public:
+
+  static constexpr int MinTableSize = 16;     // Smallest Table (in entries)
+  static constexpr int MaxTableSize = 16384;  // Largest Table (in entries)
+
+  // Allocates the Largest Table Up Front, Update Never Allocates
+  Envelope()
+    : mTable(static_cast<size_t>(MaxTableSize), 0.0f)
+  {
+    Update(TRAPEZOID, MinTableSize, 0.5f, 0.5f);
+  }
+
+  // Refills the Table
+  //   shape   - Window Shape
+  //   size    - Number of Entries (clamped to [MinTableSize, MaxTableSize]),
+  //             normally the grain duration in samples
+  //   attack  - Fraction of the Window Spent Fading In  (Trapezoid, Tukey, Exponential Decay)
+  //   release - Fraction of the Window Spent Fading Out (Trapezoid, Tukey)
+  void Update(EnvelopeShape shape, int size, float attack, float release)
+  {
+    mShape = shape;
+    mSize = (size < MinTableSize) ? MinTableSize : ((size > MaxTableSize) ? MaxTableSize : size);
+
+    // The Fades can not Overlap
+    attack  = (attack > 0.0f) ? attack : 0.0f;
+    release = (release > 0.0f) ? release : 0.0f;
+    if (attack + release > 1.0f)
+    {
+      const float scale = 1.0f / (attack + release);
+      attack *= scale;
+      release *= scale;
+    }
+
+    const float step = 1.0f / static_cast<float>(mSize - 1);
+    for (int i = 0; i < mSize; ++i)
+      mTable[static_cast<size_t>(i)] = Evaluate(shape, static_cast<float>(i) * step, attack, release);
+  }
+
+  // Evaluates a Window at a Normalised Position x in [0, 1]
+  static float Evaluate(EnvelopeShape shape, float x, float attack, float release)
+  {
+    switch (shape)
+    {
+      case HANN:
+        return 0.5f - 0.5f * cosf(2.0f * static_cast<float>(M_PI) * x);
+
+      case TUKEY:
+        if (x < attack)
+          return 0.5f - 0.5f * cosf(static_cast<float>(M_PI) * x / attack);
+        if (x > 1.0f - release)
+          return 0.5f - 0.5f * cosf(static_cast<float>(M_PI) * (1.0f - x) / release);
+        return 1.0f;
+
+      case GAUSSIAN:
+      {
+        // Shifted and Rescaled so the Window Starts and Ends at Zero
+        const float sigma = 0.15f;
+        const float edge = expf(-0.5f * (0.5f / sigma) * (0.5f / sigma));
+        const float distance = (x - 0.5f) / sigma;
+        return (expf(-0.5f * distance * distance) - edge) / (1.0f - edge);
+      }
+
+      case EXPONENTIAL_DECAY:
+      {
+        if (x < attack)
+          return x / attack;
+
+        // Decays by 60 dB over the Rest of the Window, then Shifted to End at Zero
+        const float decay = 6.9077553f;
+        const float t = (attack < 1.0f) ? (x - attack) / (1.0f - attack) : 1.0f;
+        const float end = expf(-decay);
+        return (expf(-decay * t) - end) / (1.0f - end);
+      }
+
+      case TRAPEZOID:
+      default:
+      {
+        float level = 1.0f;
+        if (attack > 0.0f)
+          level = fminf(level, x / attack);
+        if (release > 0.0f)
+          level = fminf(level, (1.0f - x) / release);
+        return (level > 0.0f) ? level : 0.0f;
+      }
+    }
+  }
+
+  // Looks up the Window at a Normalised Position in [0, 1]
+  float operator()(float position) const
+  {
+    int index = static_cast<int>(position * static_cast<float>(mSize - 1));
+    index = (index < 0) ? 0 : ((index >= mSize) ? (mSize - 1) : index);
+    return mTable[static_cast<size_t>(index)];
+  }
+
+  const float* GetTable() const
+  { return mTable.data(); }
+
+  int GetSize() const
+  { return mSize; }
+
+  EnvelopeShape GetShape() const
+  { return mShape; }
+
+private:
 
-};
\ No newline at end of file
+  std::vector<float> mTable;     // Window Table (MaxTableSize entries, the first mSize are in use)
+  int mSize = 0;                 // Number of Entries in use
+  EnvelopeShape mShape = TRAPEZOID;
+};
@@ -10,255 +10,855 @@
 /*****************************************************************************/
 
 #include "Grain.h"
+#include "GrainKernel.h"
 #define LEFT_CHANNEL 0
 #define RIGHT_CHANNEL 1
 
+namespace
+{
+  //! Converts Decibels to Octaves of Gain (log2(10) / 20)
+  const double Log2TenOver20 = 0.16609640474436813;
+
+  /**
+   *\fn: FastExp2
+   *\brief: Computes 2^x Without Calling into the Math Library
+            (relative error below 2e-7, i.e. well under a thousandth of a cent)
+   *\param: double x - Exponent, in [-1022, 1023]
+   *\return: double - 2^x
+   */
+  inline double FastExp2(double x)
+  {
+    // 2^x = 2^whole * 2^fraction, with the Fraction in [-0.5, 0.5]
+    const double whole = std::floor(x + 0.5);
+    const double f = x - whole;
+
+    const double fraction = 1.0 + f * (0.6931471805599453 + f * (0.2402265069591007 + f * (0.05550410866482158
+                          + f * (0.009618129107628477 + f * (0.0013333558146428443 + f * 0.00015403530393381608)))));
+
+    // Build 2^whole Directly in the Exponent Bits
+    const uint64 bits = static_cast<uint64>(static_cast<int64>(whole) + 1023) << 52;
+    double scale;
+    std::memcpy(&scale, &bits, sizeof(scale));
+
+    return fraction * scale;
+  }
+
+  /**
+   *\fn: FastSin
+   *\brief: Computes sin(x) over a Quarter Turn Without Calling into the Math Library
+   *\param: float x - Angle in [0, pi/2]
+   *\return: float - sin(x) (absolute error below 3e-7)
+   */
+  inline float FastSin(float x)
+  {
+    const float x2 = x * x;
+    return x * (1.0f + x2 * (-1.0f / 6.0f + x2 * (1.0f / 120.0f + x2 * (-1.0f / 5040.0f
+             + x2 * (1.0f / 362880.0f + x2 * (-1.0f / 39916800.0f))))));
+  }
+}
+
 // ------------------------------------------------------------------------------------
 // ------------------------------------------------------------------------------------
 // ------------------------------------------------------------------------------------
 
-GrainCloud::GrainCloud(int startingSample_, int duration_)
+GrainCloud::GrainCloud(int startingSample_, int duration_, int maxCloudSize)
 { 
   mSamplingRate = 0;
-  SetDuration(duration_);
-  SetCentroidSample(startingSample_);
-  AddGrains();
+
+  // Unseeded Clouds Still Differ from Each Other
+  mSeed = Random::getSystemRandom().nextInt64();
+
+  // Publish the Initial Parameters and Apply them Immediately
+  GrainParameters& parameters = mParameterStore.Edit();
+  parameters.mDuration = duration_;
+  parameters.mCentroidSample = startingSample_ - 1;
+  mParameterStore.Publish();
+
+  // Build the Sinc Table Here, so the First Offline Quality Block does not Build it on the Audio Thread
+  Interpolators::Sinc::GetTable();
+
+  UpdateEnvelope();
+  Prepare(maxCloudSize);
+
+  mParameterStore.Update();
+  ApplyParameters(mParameterStore.Read());
+}
+
+
+// ------------------------------------------------------------------------------------
+
+GrainCloud::~GrainCloud()
+{
+  delete mPendingSource.exchange(nullptr);
+  CollectRetiredSource();
+}
+
+// ------------------------------------------------------------------------------------
+
+void GrainCloud::renderBlock(AudioBuffer<float>& buffer, int startSample, int numSamples)
+{
+  buffer.clear(startSample, numSamples);
+
+  // Render in Chunks that Fit the Partial Mix Buffers
+  for (int offset = 0; offset < numSamples; offset += mMaxBlockSize)
+  {
+    const int blockSize = jmin(mMaxBlockSize, numSamples - offset);
+    const int numPartitions = BeginBlock(blockSize);
+
+    for (int partition = 0; partition < numPartitions; ++partition)
+      RenderPartition(partition, blockSize);
+
+    EndBlock(buffer, startSample + offset, blockSize);
+  }
+}
+
+// ------------------------------------------------------------------------------------
+
+int GrainCloud::BeginBlock(int numSamples)
+{
+  jassert(numSamples <= mMaxBlockSize);
+  mBlockPartitions = 0;
+
+  if (!mBlockRespawn)
+    RemoveFinishedGrains();
+
+  // Pick up the Newest Parameters Published by the GUI Thread
+  if (mParameterStore.Update())
+    ApplyParameters(mParameterStore.Read());
+
+  // A Note-Off Waits for a Stolen Voice's Grains to Fade, as they Share the Release Rate
+  if (mStealFrames <= 0 && mReleaseRequested.exchange(false))
+  {
+    ReleaseGrains();
+    mScheduling = false;
+  }
+
+  const bool stealing = (mStealFrames > 0);
+  mStealFrames = jmax(0, mStealFrames - numSamples);
+
+  AdoptPendingSource();
+
+  const bool hasSource = (mActiveSource != nullptr && mActiveSource->GetSource().IsValid());
+
+  // Playback Starting Restarts the Envelope Modulators
+  const bool isPlaying = mIsPlaying;
+
+  if (isPlaying && !mWasPlaying)
+    mModulation.Restart();
+
+  mWasPlaying = isPlaying;
+
+  // Run the Modulators Through the Whole Block Before Any Grain Starts, Grains Read them at their Frame
+  if (hasSource)
+    mModulation.Process(mParameters.mModulators, numSamples, mSourceSampleRate);
+
+  // Continuous Clouds Keep Cloud Size Grains While Playing
+  if (mParameters.mSchedule == CONTINUOUS && mIsPlaying)
+    ResizeCloud();
+
+  // Density Driven Clouds Start their Grains Here, Each at its Onset Within the Block
+  if (mParameters.mSchedule != CONTINUOUS && hasSource && mIsPlaying)
+    StartScheduledGrains(numSamples);
+
+  mClock += numSamples;
+
+  if (!hasSource || mPool.mNumGrains == 0)
+    return 0;
+
+  // Mono Sources Already Feed Both Output Channels
+  mBlockSource = mActiveSource->GetSource();
+  mBlockLastSample = static_cast<double>(mWaveSize) - 1.0;
+
+  // Grains Overlap at Random, so they Add in Power: Scaling by 1 / sqrt(Grains)
+  // Keeps the Loudness Steady however Dense the Cloud Gets
+  mBlockGain = static_cast<float>(mParameters.mGlobalGain) * mNoteGain
+             / std::sqrt(static_cast<float>(mPool.mNumGrains));
+
+  mBlockInterpolation = mParameters.mInterpolation;
+  mBlockRespawn = (mParameters.mSchedule == CONTINUOUS && mIsPlaying);
+
+  // Release Rate (per frame), Used Once Grains are Released
+  const double releaseMs = stealing ? StealReleaseMs : mParameters.mEnvelopeRelease;
+  mBlockReleaseRate = static_cast<float>(1000.0 / jmax(1.0, releaseMs * mSourceSampleRate));
+
+  // Split the Active Lanes into Fixed Size Partitions, the Split Depends
+  // Only on the Cloud Size so the Output does not Depend on the Thread Count
+  mBlockLanes = mPool.GetNumLanes();
+  mBlockPartitions = (mBlockLanes + PartitionSize - 1) / PartitionSize;
+
+  return mBlockPartitions;
+}
+
+// ------------------------------------------------------------------------------------
+
+void GrainCloud::RenderPartition(int partition, int numSamples)
+{
+  // Pick the Kernel for the Source's Sample Format Once per Partition, Not per Sample
+  switch (mBlockSource.mFormat)
+  {
+    case INT_16: RenderPartitionWith<SourceReaders::Int16>(partition, numSamples);   break;
+    case INT_24: RenderPartitionWith<SourceReaders::Int24>(partition, numSamples);   break;
+    case INT_32: RenderPartitionWith<SourceReaders::Int32>(partition, numSamples);   break;
+    case FLOAT_32_GUARDED: RenderPartitionWith<SourceReaders::GuardedFloat32>(partition, numSamples); break;
+    case FLOAT_32:
+    default:     RenderPartitionWith<SourceReaders::Float32>(partition, numSamples); break;
+  }
 }
 
+// ------------------------------------------------------------------------------------
+
+template <typename SampleReader>
+void GrainCloud::RenderPartitionWith(int partition, int numSamples)
+{
+  // Likewise for the Interpolator
+  switch (mBlockInterpolation)
+  {
+    case HERMITE: MixPartition<SampleReader, Interpolators::Hermite>(partition, numSamples); break;
+    case SINC:    MixPartition<SampleReader, Interpolators::Sinc>(partition, numSamples);    break;
+    case LINEAR:
+    default:      MixPartition<SampleReader, Interpolators::Linear>(partition, numSamples);  break;
+  }
+}
 
 // ------------------------------------------------------------------------------------
 
-float GrainCloud::operator()(int channel)
+template <typename SampleReader, typename Interpolator>
+void GrainCloud::MixPartition(int partition, int numSamples)
 {
-  float sample = 0;
+  const int firstLane = partition * PartitionSize;
+  const int endLane = jmin(firstLane + PartitionSize, mBlockLanes);
 
-  for (GrainData& grain : grains)
+  float* partialLeft  = mPartials.getWritePointer(2 * partition + LEFT_CHANNEL);
+  float* partialRight = mPartials.getWritePointer(2 * partition + RIGHT_CHANNEL);
+
+  // Grains Only Finish Within their Own Partition, so Each Partition has its
+  // Own Slice of the Finished List and its Own Random Number Generator
+  int* finishedGrains = mFinishedGrains.data() + firstLane;
+  GrainRandom& random = mPartitionRandom[static_cast<size_t>(partition)];
+
+  for (int frame = 0; frame < numSamples; ++frame)
   {
-    // If the Current Grain Isn't Active, Randomize it and Play the Grain
-    if (!grain.envelope.isActive())
+    float left = 0.0f;
+    float right = 0.0f;
+
+    const int numFinished = GrainKernel::MixFrame<SampleReader, Interpolator>(mPool, firstLane, endLane, mBlockSource,
+                                                                              mBlockLastSample, mEnvelope, mBlockReleaseRate,
+                                                                              left, right, finishedGrains);
+
+    // Replay the Grains that Finished, or Silence them Until the Next Block Removes them
+    if (numFinished > 0)
     {
-      RandomizeGrain(grain);
-      grain.envelope.noteOn();
-      grain.mInRelease = false;
+      if (mBlockRespawn)
+        SpawnGrains(finishedGrains, numFinished, random, frame);
+      else
+      {
+        for (int k = 0; k < numFinished; ++k)
+          mPool.ClearLane(finishedGrains[k]);
+      }
     }
-    else if(!grain.mInRelease)
+
+    partialLeft[frame] = left;
+    partialRight[frame] = right;
+  }
+}
+
+// ------------------------------------------------------------------------------------
+
+void GrainCloud::EndBlock(AudioBuffer<float>& buffer, int startSample, int numSamples)
+{
+  if (mBlockPartitions == 0)
+    return;
+
+  // Sum the Partitions in Order, so the Mix is the Same whichever Thread Rendered Them
+  float* sumLeft  = mPartials.getWritePointer(LEFT_CHANNEL);
+  float* sumRight = mPartials.getWritePointer(RIGHT_CHANNEL);
+
+  for (int partition = 1; partition < mBlockPartitions; ++partition)
+  {
+    FloatVectorOperations::add(sumLeft,  mPartials.getReadPointer(2 * partition + LEFT_CHANNEL),  numSamples);
+    FloatVectorOperations::add(sumRight, mPartials.getReadPointer(2 * partition + RIGHT_CHANNEL), numSamples);
+  }
+
+  float* outputLeft  = buffer.getWritePointer(LEFT_CHANNEL, startSample);
+  float* outputRight = (buffer.getNumChannels() >= 2) ? buffer.getWritePointer(RIGHT_CHANNEL, startSample) : nullptr;
+
+  // Scale the Samples by the Gain and Add the Cloud to the Output, Ramping from the Last
+  // Block's Gain so a Changing Grain Count does not Step (the OutputStage Limits the Mix)
+  const bool gainModulated = mModulation.IsModulated(MOD_GLOBAL_GAIN);
+
+  if (gainModulated)
+  {
+    const float gainStep = (mBlockGain - mLastBlockGain) / static_cast<float>(numSamples);
+    const float* decibels = mModulation.GetTickValues(MOD_GLOBAL_GAIN);
+    const int numTicks = mModulation.GetNumTicks();
+
+    // The Modulation is Converted from dB Once per Interval, then Ramped Linearly Across Each
+    for (int tick = 0; tick <= numTicks; ++tick)
+      mModulationGains[static_cast<size_t>(tick)] = static_cast<float>(FastExp2(decibels[tick] * Log2TenOver20));
+
+    int frame = 0;
+
+    for (int tick = 0; tick < numTicks; ++tick)
     {
-      // Check if we are finished getting the current grain
-      if (mAudioSourceBuffer->getNumChannels() >= 2) // Stereo 
-      {
-        
-        if ((grain.mCurrentSample[LEFT_CHANNEL] >= grain.mEndSample) &&
-          (grain.mCurrentSample[RIGHT_CHANNEL] >= grain.mEndSample))
-        {
-          grain.envelope.noteOff();
-          grain.mInRelease = true;
-        }
+      const int tickEnd = jmin(numSamples, frame + ModulationMatrix::ControlInterval);
+      const float modulationStart = mModulationGains[static_cast<size_t>(tick)];
+      const float modulationStep = (mModulationGains[static_cast<size_t>(tick) + 1] - modulationStart)
+                                 / static_cast<float>(tickEnd - frame);
 
-      }
-      else if (grain.mCurrentSample[LEFT_CHANNEL] >= grain.mEndSample) // Mono
+      for (int step = 1; frame < tickEnd; ++frame, ++step)
       {
-        grain.envelope.noteOff();
-        grain.mInRelease = true;
+        const float gain = (mLastBlockGain + gainStep * static_cast<float>(frame + 1))
+                         * (modulationStart + modulationStep * static_cast<float>(step));
+        outputLeft[frame] += sumLeft[frame] * gain;
+
+        if (outputRight != nullptr)
+          outputRight[frame] += sumRight[frame] * gain;
       }
     }
+  }
+  else if (mBlockGain == mLastBlockGain)
+  {
+    FloatVectorOperations::addWithMultiply(outputLeft, sumLeft, mBlockGain, numSamples);
 
-    double randomPanValue = 1.0f;
-    if(mRandomPanning)
-      if (channel == 0)
-        randomPanValue = std::sin(grain.mPanningValue * (M_PI_2));
-      else
-        randomPanValue = std::sin((1.0 - grain.mPanningValue) * (M_PI_2));
-
-    // Get the Current Sample From the Audio Buffer
-    float currentSample = (mAudioSourceBuffer->getSample(channel, static_cast<int>(grain.mCurrentSample[channel])));
-    
-    //         currentSample             ADSR Grain                         Random Gain                            Random Panning Value
-    sample += (currentSample * grain.envelope.getNextSample() * static_cast<float>(grain.mGainScalar) * static_cast<float>(randomPanValue));
-   
-    grain.mCurrentSample[channel] += grain.mPitchScalar;
-    if(grain.mCurrentSample[channel] >= static_cast<double>(mWaveSize))
-      grain.mCurrentSample[channel] = (static_cast<double>(mWaveSize) - 1.0f);
-    
+    if (outputRight != nullptr)
+      FloatVectorOperations::addWithMultiply(outputRight, sumRight, mBlockGain, numSamples);
   }
+  else
+  {
+    const float gainStep = (mBlockGain - mLastBlockGain) / static_cast<float>(numSamples);
 
-  // Scale the Sample by the Gain
-  sample *= static_cast<float>(mGlobalGain);
+    for (int frame = 0; frame < numSamples; ++frame)
+    {
+      const float gain = mLastBlockGain + gainStep * static_cast<float>(frame + 1);
+      outputLeft[frame] += sumLeft[frame] * gain;
 
-  // If Polyphonic, Scale by 0.3f
-  if(grains.size() > 1)
-    sample *= 0.3f;
-  
-  // Clip Check
-  if(sample > 1.0f)
-    return 1.0f;
-  else if(sample < -1.0f)
-    return -1.0f;
+      if (outputRight != nullptr)
+        outputRight[frame] += sumRight[frame] * gain;
+    }
+  }
 
-  return sample;
+  mLastBlockGain = mBlockGain;
 }
 
 // ------------------------------------------------------------------------------------
 
-void GrainCloud::SetCentroidSample(int startingSample)
+void GrainCloud::ApplyParameters(const GrainParameters& parameters)
 {
-  // Update the Starting Sample, and Reset the Current Sample
-  mCentroidSample = startingSample - 1;
+  const bool centroidChanged = (parameters.mCentroidSample != mParameters.mCentroidSample);
+  const bool scheduleChanged = (parameters.mSchedule != mParameters.mSchedule);
+  const bool durationChanged = (parameters.mDuration != mParameters.mDuration);
+  const bool envelopeChanged = (parameters.mEnvelopeShape != mParameters.mEnvelopeShape)
+                            || (parameters.mEnvelopeAttack != mParameters.mEnvelopeAttack)
+                            || (parameters.mEnvelopeRelease != mParameters.mEnvelopeRelease);
 
-  for (GrainData& grain : grains)
+  mParameters = parameters;
+
+  // Update Duration and Calculate mSample Delta
+  if (durationChanged)
+    mSampleDelta = static_cast<int>(mSourceSampleRate * (static_cast<float>(mParameters.mDuration) / 1000.0f));
+
+  // Resize the Window to the New Duration and Stretch the Grains to Fit
+  if (durationChanged || envelopeChanged)
   {
-    RandomizeGrain(grain);
+    UpdateEnvelope();
+
+    for (int grain = 0; grain < mPool.mNumGrains; ++grain)
+      UpdateGrainLength(grain);
+  }
+
+  // Switching to a Density: the Continuous Grains Fade Out, and the Scheduler Starts from Now.
+  // Switching Back: the Density Driven Grains are Replaced by a Full Cloud.
+  if (scheduleChanged)
+  {
+    if (mParameters.mSchedule == CONTINUOUS)
+      RemoveGrains(mPool.mNumGrains);
+    else
+    {
+      ReleaseGrains();
+      mScheduling = false;
+    }
   }
+
+  // Restart the Grains from the New Centroid (Density Driven Grains Pick it up as they Start,
+  // and Released Grains Fade Out where they Are)
+  if (centroidChanged && mParameters.mSchedule == CONTINUOUS && mIsPlaying)
+    RetriggerGrains();
 }
 
 // ------------------------------------------------------------------------------------
 
-void GrainCloud::SetDuration(int duration)
+void GrainCloud::ResizeCloud()
 {
-  // Update Duration and Calculate mSample Delta
-  mDuration = duration;
-  mSampleDelta = static_cast<int>(mSamplingRate * (static_cast<float>(mDuration) / 1000.0f));
-  
-  for (GrainData& grain : grains)
-  {
-    // Clamp the End Sample
-    grain.mEndSample = grain.mStartingSample + mSampleDelta;
-    if (grain.mEndSample >= mWaveSize)
-      grain.mEndSample = (mWaveSize - 1);
-  }
+  // Resize the Cloud Within the Preallocated Pool
+  const int cloudSize = jlimit(0, mPool.mCapacity, mParameters.mCloudSize);
+
+  if (cloudSize > mPool.mNumGrains)
+    AddGrains(cloudSize - mPool.mNumGrains);
+  else if (cloudSize < mPool.mNumGrains)
+    RemoveGrains(mPool.mNumGrains - cloudSize);
 }
 
 // ------------------------------------------------------------------------------------
 
-void GrainCloud::SetAudioSource(AudioFormatReader& newAudioFile)
+void GrainCloud::SetAudioSource(std::unique_ptr<SourceAudio> audio)
+{
+  // Details the GUI Thread Reads
+  mLoadedSize = static_cast<int>(jmin(audio->GetLength(), static_cast<int64>(std::numeric_limits<int>::max())));
+  mLoadedMapped = audio->IsMapped();
+  mSamplingRate = audio->GetSampleRate();
+
+  // Free the Last Swapped Out Source First, so the Audio Thread has Somewhere to Put the Current One
+  CollectRetiredSource();
+
+  // A Source that was Never Swapped in can be Freed Here
+  delete mPendingSource.exchange(audio.release(), std::memory_order_acq_rel);
+}
+
+// ------------------------------------------------------------------------------------
+
+void GrainCloud::CollectRetiredSource()
+{
+  delete mRetiredSource.exchange(nullptr, std::memory_order_acq_rel);
+}
+
+// ------------------------------------------------------------------------------------
+
+void GrainCloud::AdoptPendingSource()
+{
+  // Hold the New Source Back Until the Last Swapped Out One is Collected,
+  // the Audio Thread Never Frees a Source Itself
+  if (mPendingSource.load(std::memory_order_acquire) == nullptr
+      || mRetiredSource.load(std::memory_order_acquire) != nullptr)
+    return;
+
+  std::unique_ptr<SourceAudio> incoming(mPendingSource.exchange(nullptr, std::memory_order_acq_rel));
+  if (incoming == nullptr)
+    return;
+
+  mRetiredSource.store(mSourceAudio.release(), std::memory_order_release);
+  mSourceAudio = std::move(incoming);
+
+  UseSource(mSourceAudio.get());
+}
+
+// ------------------------------------------------------------------------------------
+
+const SourceAudio* GrainCloud::UpdateAudioSource()
+{
+  AdoptPendingSource();
+  return mActiveSource;
+}
+
+// ------------------------------------------------------------------------------------
+
+void GrainCloud::ShareAudioSource(const SourceAudio* audio)
+{
+  if (audio != mActiveSource)
+    UseSource(audio);
+}
+
+// ------------------------------------------------------------------------------------
+
+void GrainCloud::UseSource(const SourceAudio* audio)
 {
+  mActiveSource = audio;
+
   // Update Grain Parameters
-  mWaveSize =  static_cast<int>(newAudioFile.lengthInSamples);
-  mSamplingRate = static_cast<int>(newAudioFile.sampleRate);
+  mWaveSize = (audio != nullptr) ? static_cast<int>(jmin(audio->GetLength(), static_cast<int64>(std::numeric_limits<int>::max()))) : 0;
+  mSourceSampleRate = (audio != nullptr) ? audio->GetSampleRate() : 0.0;
+  mSampleDelta = static_cast<int>(mSourceSampleRate * (static_cast<float>(mParameters.mDuration) / 1000.0f));
+  UpdateEnvelope();
+
+  // Restart the Grains Inside the New Source
+  RetriggerGrains();
+}
+
+// ------------------------------------------------------------------------------------
 
+void GrainCloud::SetAudioSource(AudioFormatReader& newAudioFile)
+{
   // Clear the Audio Source and Read the New WAV File
-  mAudioSourceBuffer.reset(new AudioSampleBuffer(newAudioFile.numChannels, static_cast<int>(newAudioFile.lengthInSamples)));
-  newAudioFile.read(mAudioSourceBuffer.get(), 0, static_cast<int>(newAudioFile.lengthInSamples), 0, true, true);
+  SetAudioSource(SourceAudio::Decode(newAudioFile));
+}
+
+// ------------------------------------------------------------------------------------
 
+void GrainCloud::SetAudioSource(const AudioBuffer<float>& audio, double sampleRate)
+{
+  // Copy the Audio into the Source
+  SetAudioSource(SourceAudio::Copy(audio, sampleRate));
 }
 
 // ------------------------------------------------------------------------------------
 
-void GrainCloud::SetCloudSize(int size)
+bool GrainCloud::MapAudioSource(const File& wavFile, String& error)
 {
-  if (size > mCloudSize)
-    AddGrains(size - mCloudSize);
-  else if (size < mCloudSize)
-    RemoveGrains(mCloudSize - size);
+  std::unique_ptr<SourceAudio> mapped = SourceAudio::Map(wavFile, error);
+
+  // Keep the Current Source if the File can not be Mapped
+  if (mapped == nullptr)
+    return false;
+
+  SetAudioSource(std::move(mapped));
+  return true;
 }
 
 // ------------------------------------------------------------------------------------
 
+void GrainCloud::RetriggerGrains()
+{
+  // Density Driven Clouds Drop their Grains, the Scheduler Starts New Ones.
+  // Stopped Clouds Drop them too, Playing Again Refills the Cloud.
+  if (mParameters.mSchedule != CONTINUOUS || !mIsPlaying)
+  {
+    RemoveGrains(mPool.mNumGrains);
+    return;
+  }
+
+  SpawnGrains(mGrainIndices.data(), mPool.mNumGrains, mRandom, 0);
+}
+
+// ------------------------------------------------------------------------------------
+void GrainCloud::RemoveFinishedGrains()
+{
+  // Finished Grains were Cleared, so they Never Finish Again. Walking Backwards,
+  // the Grain Moved into a Removed Grain's Place has Already been Checked.
+  for (int grain = mPool.mNumGrains - 1; grain >= 0; --grain)
+    if (mPool.mLifetime[static_cast<size_t>(grain)] == std::numeric_limits<float>::max())
+      mPool.DeactivateGrain(grain);
+}
 
-void GrainCloud::RandomizeGrain(GrainData& grain)
+// ------------------------------------------------------------------------------------
+void GrainCloud::StartScheduledGrains(int numSamples)
 {
-  Random rand = Random();
+  const int64 blockEnd = mClock + numSamples;
+
+  // Start from Now after a Release, Rather than Catching up on the Onsets Missed
+  if (!mScheduling)
+  {
+    mScheduler.Reset(mClock);
+    mScheduling = true;
+  }
+
+  const double density = jlimit(MinDensity, mSourceSampleRate, mParameters.mDensity);
 
-  // Ensure the Starting Smaple is non-negative
-  if (mStartingOffset == 0 || (mCentroidSample - mStartingOffset) <= 0)
-    grain.mStartingSample = mCentroidSample;
+  // A Modulated Density is Generated an Interval at a Time, Each at its Own Period
+  if (mModulation.IsModulated(MOD_DENSITY))
+  {
+    const float* octaves = mModulation.GetTickValues(MOD_DENSITY);
+
+    for (int tick = 0; tick < mModulation.GetNumTicks(); ++tick)
+    {
+      const double tickDensity = jlimit(MinDensity, mSourceSampleRate, density * FastExp2(octaves[tick + 1]));
+      const int64 tickStart = mClock + tick * ModulationMatrix::ControlInterval;
+      const int64 tickEnd = mClock + jmin(numSamples, (tick + 1) * ModulationMatrix::ControlInterval);
+
+      mScheduler.Generate(mParameters.mSchedule, mSourceSampleRate / tickDensity, mParameters.mJitter,
+                          tickStart, tickEnd, mRandom);
+    }
+  }
   else
+    mScheduler.Generate(mParameters.mSchedule, mSourceSampleRate / density, mParameters.mJitter,
+                        mClock, blockEnd, mRandom);
+
+  // Activate a Grain per Due Onset, Dropping Onsets while the Cloud is Full
+  const int maxGrains = jlimit(0, mPool.mCapacity, mParameters.mCloudSize);
+  int numOnsets = 0;
+  int64 onset = 0;
+
+  while (mScheduler.PopDue(blockEnd, onset))
+  {
+    if (mPool.mNumGrains >= maxGrains)
+      continue;
+
+    mOnsetGrains[static_cast<size_t>(numOnsets)] = mPool.ActivateGrain();
+    mOnsetDelays[static_cast<size_t>(numOnsets)] = static_cast<int>(jmax<int64>(0, onset - mClock));
+    ++numOnsets;
+  }
+
+  // Randomize them as One Batch, then Hold Each Back Until its Onset. While the Grains' Parameters
+  // are Modulated, Each Interval's Onsets are a Batch of their Own, Read at the Interval's First Onset.
+  const bool modulated = mModulation.IsModulated(MOD_CENTROID) || mModulation.IsModulated(MOD_STARTING_OFFSET)
+                      || mModulation.IsModulated(MOD_PITCH) || mModulation.IsModulated(MOD_GRAIN_GAIN);
+
+  for (int first = 0, end = 0; first < numOnsets; first = end)
   {
+    const int tick = mOnsetDelays[static_cast<size_t>(first)] / ModulationMatrix::ControlInterval;
 
-    // Randomize the Starting Sample
-    grain.mStartingSample = rand.nextInt(Range<int>(mCentroidSample - mStartingOffset,
-                                                    mCentroidSample + mStartingOffset));
+    for (end = first + 1; end < numOnsets; ++end)
+      if (modulated && mOnsetDelays[static_cast<size_t>(end)] / ModulationMatrix::ControlInterval != tick)
+        break;
 
-    // Clamp the Starting Sample to be Within the WaveTable Range
-    if(grain.mStartingSample < 0)
-      grain.mStartingSample = 0;
-    else if(grain.mStartingSample >= mWaveSize)
-      grain.mStartingSample = (mWaveSize - 1);
+    SpawnGrains(mOnsetGrains.data() + first, end - first, mRandom, mOnsetDelays[static_cast<size_t>(first)]);
   }
 
-  // Set Grain Envelope Parameters
-  grain.envelope.setParameters({});
-    
-  // Set the Current Sample to the Starting Sample
-  grain.mCurrentSample[LEFT_CHANNEL] = static_cast<double>(grain.mStartingSample);
-  grain.mCurrentSample[RIGHT_CHANNEL] = static_cast<double>(grain.mStartingSample);
+  for (int k = 0; k < numOnsets; ++k)
+    mPool.mEnvelopePosition[static_cast<size_t>(mOnsetGrains[static_cast<size_t>(k)])] =
+      -static_cast<float>(mOnsetDelays[static_cast<size_t>(k)]);
+}
 
-  // Clamp the End Sample to be Within the WaveTable Range
-  grain.mEndSample = grain.mStartingSample + mSampleDelta;
-  if (grain.mEndSample >= mWaveSize)
-    grain.mEndSample = (mWaveSize - 1);
-  
-  // Randomize the Pitch 
-  double randomPitch = 0.0;
-  if(mPitchOffsetMax != 0.0 || mPitchOffsetMin != 0.0)
-    randomPitch = mPitchOffsetMin + (mPitchOffsetMax - mPitchOffsetMin) * rand.nextDouble();
-  grain.mPitchScalar = std::pow(2.0f, randomPitch / 12.0f);
-
-  // Randomize the Grain Gain
-  double randomGain = 0.0;
-  if(mGainOffsetDbMin < 0 && (mGainOffsetDbMin != mGainOffsetDbMax))
-    randomGain = static_cast<double>(rand.nextInt(Range<int>(mGainOffsetDbMin, mGainOffsetDbMax)));
-  else if(mGainOffsetDbMin == mGainOffsetDbMax)
-    randomGain = mGainOffsetDbMax;
-
-  grain.mGainScalar = Decibels::decibelsToGain<double>(randomGain);
-
-  // Randomize the Pan Value
-  if(mRandomPanning)
-    grain.mPanningValue = rand.nextDouble();
-  else
-    grain.mPanningValue = 1.0f;
+// ------------------------------------------------------------------------------------
+
+void GrainCloud::SetSeed(int64 seed)
+{
+  mSeed = seed;
+  mRandom.SetSeed(static_cast<uint64>(seed));
+
+  // Give Each Partition its Own Sequence, and the Random Walks Theirs
+  for (size_t partition = 0; partition < mPartitionRandom.size(); ++partition)
+    mPartitionRandom[partition].SetSeed(static_cast<uint64>(seed) + 0x9e3779b97f4a7c15ull * (partition + 1));
+
+  mModulation.SetSeed(static_cast<uint64>(seed) ^ 0xd1b54a32d192ed03ull);
 }
 
 // ------------------------------------------------------------------------------------
 
-void GrainCloud::AddGrains(int count)
+void GrainCloud::Prepare(int maxCloudSize, int maxBlockSize)
+{
+  mPool.Allocate(maxCloudSize);
+  mFinishedGrains.resize(static_cast<size_t>(mPool.mCapacity));
+
+  // One Partial Mix (Left and Right) and Random Number Generator per Partition
+  const int maxPartitions = jmax(1, (mPool.mCapacity + PartitionSize - 1) / PartitionSize);
+  mMaxBlockSize = jmax(1, maxBlockSize);
+  mPartials.setSize(2 * maxPartitions, mMaxBlockSize);
+  mPartitionRandom.resize(static_cast<size_t>(maxPartitions));
+  SetSeed(mSeed);
+
+  mGrainIndices.resize(static_cast<size_t>(mPool.mCapacity));
+  for (int i = 0; i < mPool.mCapacity; ++i)
+    mGrainIndices[static_cast<size_t>(i)] = i;
+
+  // At Most One Onset per Sample (Plus the Scheduler's Look Ahead), and One Started Grain per Grain
+  mScheduler.Prepare(2 * mMaxBlockSize + 4);
+  mOnsetGrains.resize(static_cast<size_t>(mPool.mCapacity));
+  mOnsetDelays.resize(static_cast<size_t>(mPool.mCapacity));
+  mScheduling = false;
+  mStealFrames = 0;
+
+  // Offsets per Control Interval, and their Global Gains
+  mModulation.Prepare(mMaxBlockSize);
+  mModulationGains.resize(static_cast<size_t>(mMaxBlockSize / ModulationMatrix::ControlInterval + 2));
+
+  // The Pool Starts Empty, BeginBlock Refills a Playing Continuous Cloud
+  mBlockRespawn = false;
+}
+
+// ------------------------------------------------------------------------------------
+
+
+void GrainCloud::SpawnGrains(const int* grains, int count, GrainRandom& random, int frame)
 {
-  for (int i = 0; i < count; ++i)
+  // Each Property is Drawn for the Whole Batch in its Own Loop, so the
+  // Parameter Checks are Made Once per Batch Instead of Once per Grain
+
+  // Randomize the Starting Samples (Clamped to be Within the WaveTable Range, which
+  // the Centroid may not be for a Moment After the Source is Swapped, or once Modulated)
+  const int lastSample = jmax(0, mWaveSize - 1);
+  const int centroidSample = jlimit(0, lastSample, mParameters.mCentroidSample
+                                    + roundToInt(mModulation.GetValue(MOD_CENTROID, frame) * mWaveSize));
+  const int startingOffset = jmax(0, mParameters.mStartingOffset
+                                     + roundToInt(mModulation.GetValue(MOD_STARTING_OFFSET, frame) * mWaveSize));
+
+  if (startingOffset != 0 && (centroidSample - startingOffset) > 0)
   {
-      // Add a New Grain and Randomize it
-      grains.push_back(GrainData());
-      RandomizeGrain(grains.back());
+    for (int k = 0; k < count; ++k)
+      mPool.mStartingSample[static_cast<size_t>(grains[k])] =
+        jlimit(0, lastSample, random.NextInt(centroidSample - startingOffset, centroidSample + startingOffset));
+  }
+  else
+  {
+    for (int k = 0; k < count; ++k)
+      mPool.mStartingSample[static_cast<size_t>(grains[k])] = centroidSample;
+  }
 
-      // If are polyphonic and the user doesn't want randomized starting points
-      // ensure all voices are identical.
-      if ((mCloudSize >= 1) && (mStartingOffset == 0))
-      {
-        auto& newGrain = grains.back();
-        auto& masterGrain = grains.front();
-        newGrain.mStartingSample = masterGrain.mStartingSample;
-        newGrain.mCurrentSample[0] = masterGrain.mCurrentSample[0];
-        newGrain.mCurrentSample[1] = masterGrain.mCurrentSample[1];
-        newGrain.mEndSample = masterGrain.mEndSample;
-        newGrain.mInRelease = masterGrain.mInRelease;
-        newGrain.envelope = masterGrain.envelope;
-      }
+  // Randomize the Pitch (in Octaves, so the Increment is a Power of Two)
+  const double pitchMin = (mParameters.mPitchOffsetMin + mModulation.GetValue(MOD_PITCH, frame)) / 12.0 + mNoteOctaves;
+  const double pitchRange = (mParameters.mPitchOffsetMax - mParameters.mPitchOffsetMin) / 12.0;
+
+  for (int k = 0; k < count; ++k)
+    mPool.mIncrement[static_cast<size_t>(grains[k])] = FastExp2(pitchMin + pitchRange * random.NextDouble());
+
+  // Randomize the Grain Gain (in whole dB, then Shifted by the Modulation)
+  const double gainDbOffset = mModulation.GetValue(MOD_GRAIN_GAIN, frame);
+  int gainDbMin = 0;
+  int gainDbMax = 0;
+  if (mParameters.mGainOffsetDbMin < 0 && (mParameters.mGainOffsetDbMin != mParameters.mGainOffsetDbMax))
+  {
+    gainDbMin = mParameters.mGainOffsetDbMin;
+    gainDbMax = mParameters.mGainOffsetDbMax;
+  }
+  else if (mParameters.mGainOffsetDbMin == mParameters.mGainOffsetDbMax)
+  {
+    gainDbMin = gainDbMax = mParameters.mGainOffsetDbMax;
+  }
+
+  for (int k = 0; k < count; ++k)
+  {
+    const size_t i = static_cast<size_t>(grains[k]);
+    const float gain = static_cast<float>(FastExp2((random.NextInt(gainDbMin, gainDbMax) + gainDbOffset) * Log2TenOver20));
+
+    mPool.mGainLeft[i] = gain;
+    mPool.mGainRight[i] = gain;
+  }
+
+  // Randomize the Pan Value (Constant Power)
+  if (mParameters.mRandomPanning)
+  {
+    for (int k = 0; k < count; ++k)
+    {
+      const size_t i = static_cast<size_t>(grains[k]);
+      const float angle = random.NextFloat() * MathConstants<float>::halfPi;
+
+      mPool.mGainLeft[i]  *= FastSin(angle);
+      mPool.mGainRight[i] *= FastSin(MathConstants<float>::halfPi - angle);
+    }
   }
 
-  mCloudSize += count;
+  // Restart the Grains from their Starting Samples
+  for (int k = 0; k < count; ++k)
+  {
+    const size_t i = static_cast<size_t>(grains[k]);
+
+    mPool.mPosition[i] = static_cast<double>(mPool.mStartingSample[i]);
+    mPool.mEnvelopePosition[i] = 0.0f;
+    mPool.mReleaseStart[i] = std::numeric_limits<float>::max();
+    UpdateGrainLength(grains[k]);
+  }
 }
 
 // ------------------------------------------------------------------------------------
 
-void GrainCloud::RemoveGrains(int count)
+void GrainCloud::UpdateGrainLength(int grain)
 {
-  for(int i = 0; i < count; ++i)
-    grains.pop_back(); 
+  const size_t i = static_cast<size_t>(grain);
+
+  // Clamp the End Sample to be Within the WaveTable Range
+  int endSample = mPool.mStartingSample[i] + mSampleDelta;
+  if (endSample >= mWaveSize)
+    endSample = (mWaveSize - 1);
+
+  // The Window Spans the Frames the Grain Takes to Read up to its End Sample
+  const double windowFrames = jmax(1.0, (endSample - mPool.mStartingSample[i]) / mPool.mIncrement[i]);
 
-  mCloudSize -= count;
+  mPool.mLifetime[i] = static_cast<float>(windowFrames);
+  mPool.mEnvelopeScale[i] = static_cast<float>((mEnvelope.GetSize() - 1) / windowFrames);
 }
 
 // ------------------------------------------------------------------------------------
 
+void GrainCloud::UpdateEnvelope()
+{
+  // The Fades are Given in ms, the Window in Fractions of the Grain
+  const double duration = jmax(1.0, static_cast<double>(mParameters.mDuration));
 
-void GrainCloud::Reset()
+  mEnvelope.Update(mParameters.mEnvelopeShape, mSampleDelta,
+                   static_cast<float>(mParameters.mEnvelopeAttack / duration),
+                   static_cast<float>(mParameters.mEnvelopeRelease / duration));
+}
+
+// ------------------------------------------------------------------------------------
+
+void GrainCloud::AddGrains(int count)
 {
-  for (GrainData& grain : grains)
+  // Activate the New Grains (they are Packed after the Active Grains)
+  const int firstGrain = mPool.mNumGrains;
+  int numAdded = 0;
+
+  while (numAdded < count && mPool.ActivateGrain() >= 0)
+    ++numAdded;
+
+  // Randomize them as One Batch
+  SpawnGrains(mGrainIndices.data() + firstGrain, numAdded, mRandom, 0);
+
+  // If are polyphonic and the user doesn't want randomized starting points
+  // ensure all voices start together (each Keeps its own Pitch, Gain and Pan).
+  if (mParameters.mStartingOffset == 0)
   {
-    grain.envelope.noteOff();
-    grain.mInRelease = true;
+    for (int grain = jmax(1, firstGrain); grain < mPool.mNumGrains; ++grain)
+      mPool.CopyTiming(grain, 0);
   }
- 
+}
+
+// ------------------------------------------------------------------------------------
+
+void GrainCloud::RemoveGrains(int count)
+{
+  for (int i = 0; i < count && mPool.mNumGrains > 0; ++i)
+    mPool.DeactivateGrain(mPool.mNumGrains - 1);
+}
+
+// ------------------------------------------------------------------------------------
+
+
+void GrainCloud::Reset()
+{
+  mReleaseRequested = true;
   mIsPlaying = false;
 }
 
 // ------------------------------------------------------------------------------------
+
+void GrainCloud::StartNote(double semitones, float gain)
+{
+  // Start the Note with the Newest Parameters
+  if (mParameterStore.Update())
+    ApplyParameters(mParameterStore.Read());
+
+  mNoteOctaves = semitones / 12.0;
+  mNoteGain = gain;
+
+  mReleaseRequested = false;
+  mScheduling = false;
+  mIsPlaying = true;
+
+  // Every Note Runs its Envelope Modulators from the Start
+  mModulation.Restart();
+
+  // A Stolen Voice's Grains Fade Out Quickly, the Next Block Starts the New Note's Grains Alongside them
+  // (Continuous Clouds Respawn the Faded Grains as the New Note's)
+  if (mPool.mNumGrains > 0)
+    FadeOutStolenGrains();
+}
+
+// ------------------------------------------------------------------------------------
+
+void GrainCloud::ReleaseGrains()
+{
+  const float releaseFrames = static_cast<float>(jmax(1.0, mParameters.mEnvelopeRelease * mSourceSampleRate / 1000.0));
+
+  // Fade Every Grain Out from where it is, the Window Keeps Running Underneath
+  for (size_t i = 0; i < static_cast<size_t>(mPool.mNumGrains); ++i)
+  {
+    if (mPool.mEnvelopePosition[i] < mPool.mReleaseStart[i])
+    {
+      mPool.mReleaseStart[i] = mPool.mEnvelopePosition[i];
+      mPool.mLifetime[i] = jmin(mPool.mLifetime[i], mPool.mEnvelopePosition[i] + releaseFrames);
+    }
+  }
+}
+
+// ------------------------------------------------------------------------------------
+
+void GrainCloud::FadeOutStolenGrains()
+{
+  // Released Grains are Part Way Down their Release, at the Rate they Faded with Last Block
+  const double releaseMs = (mStealFrames > 0) ? StealReleaseMs : mParameters.mEnvelopeRelease;
+  const float releaseRate = static_cast<float>(1000.0 / jmax(1.0, releaseMs * mSourceSampleRate));
+  const float stealFrames = static_cast<float>(jmax(1.0, StealReleaseMs * mSourceSampleRate / 1000.0));
+
+  // Restart Each Release from the Grain's Current Level, so the Faster Rate does not Step it Down
+  for (size_t i = 0; i < static_cast<size_t>(mPool.mNumGrains); ++i)
+  {
+    const float position = mPool.mEnvelopePosition[i];
+    const float level = (position < mPool.mReleaseStart[i])
+                      ? 1.0f : jmax(0.0f, 1.0f - (position - mPool.mReleaseStart[i]) * releaseRate);
+
+    mPool.mReleaseStart[i] = position - (1.0f - level) * stealFrames;
+    mPool.mLifetime[i] = jmin(mPool.mLifetime[i], position + level * stealFrames);
+  }
+
+  mStealFrames = static_cast<int>(std::ceil(stealFrames));
+}
+
+// ------------------------------------------------------------------------------------
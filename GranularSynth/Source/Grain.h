@@ -10,8 +10,12 @@
 */
 /*****************************************************************************/
 #pragma once
-#include "../JuceLibraryCode/JuceHeader.h"
+#include <JuceHeader.h>
 #include "WaveGenerator.h"
+#include "GrainPool.h"
+#include "GrainParameters.h"
+#include "GrainRandom.h"
+#include "GrainSource.h"
 
 
 /**
@@ -37,37 +41,110 @@ public:
    *\brief: Generates a Grain from a waveform generator
    *\param: int StartingSample - Sample to Start the Grain
    *\param: int Duration - Duration of the Grain
+   *\param: int maxCloudSize - Capacity of the Grain Pool (Owners that Know their Size Avoid a Second Allocation)
    */
-  GrainCloud(int startingSample_ = 1, int duration = 0);
+  GrainCloud(int startingSample_ = 1, int duration = 0, int maxCloudSize = DefaultMaxCloudSize);
 
   /**
-   *\Grain () operator
-   *\brief: Plays a sample of the Grains (from WAV form)
-   *\param: int channel - Channel of an Audio Buffer to Play Sample From
-   *\return: float - Current Sample of the Grain
+   *\fn: ~GrainCloud
+   *\brief: Destructor for a GrainCloud, Frees any Source Still Waiting to be Swapped In or Out
    */
-  float operator()(int channel);
+  ~GrainCloud();
 
   /**
-   *\fn: SetStartingSample
-   *\brief: Sets the Starting Sample of a Grain
-   *\param: int startingSample - Sample to Start the Grain
+   *\fn: renderBlock
+   *\brief: Renders a Block of the Grain Cloud (from WAV form) into an Audio Buffer.
+            Frames are processed in order, every grain is advanced once per frame
+            and all of the output channels are written in the same pass. The Block
+            is not Clipped, Run the Mix through an OutputStage.
+   *\param: AudioBuffer<float>& buffer - Buffer to Render the Cloud Into
+   *\param: int startSample - First Sample in the Buffer to Write
+   *\param: int numSamples - Number of Samples to Render
    */
-  void SetCentroidSample(int startingSample);
+  void renderBlock(AudioBuffer<float>& buffer, int startSample, int numSamples);
+
+  /**
+   *\fn: BeginBlock
+   *\brief: Starts a Block Rendered in Partitions (see GrainEngine). Picks up the
+            Newest Parameters and Splits the Cloud into Partitions of at most
+            PartitionSize Grains, which can then be Rendered on Any Thread.
+   *\param: int numSamples - Number of Samples in the Block (at most GetMaxBlockSize())
+   *\return: int - Number of Partitions to Render (0 if the Cloud is Silent)
+   */
+  int BeginBlock(int numSamples);
+
+  /**
+   *\fn: RenderPartition
+   *\brief: Renders One Partition of the Block into its Own Partial Mix.
+            Different Partitions of the Same Block can be Rendered Concurrently.
+   *\param: int partition - Partition to Render, in [0, BeginBlock())
+   *\param: int numSamples - Number of Samples in the Block
+   */
+  void RenderPartition(int partition, int numSamples);
+
+  /**
+   *\fn: EndBlock
+   *\brief: Sums the Partial Mixes in Partition Order and Adds the Cloud to a Buffer
+   *\param: AudioBuffer<float>& buffer - Buffer to Add the Cloud Into
+   *\param: int startSample - First Sample in the Buffer to Write
+   *\param: int numSamples - Number of Samples in the Block
+   */
+  void EndBlock(AudioBuffer<float>& buffer, int startSample, int numSamples);
+
+  /**
+   *\fn: GetParameters
+   *\brief: Gets the GUI Thread's Copy of the Cloud Parameters. Changes made
+            to it are Picked up by the Audio Thread after PublishParameters.
+   *\return: GrainParameters& - Editable Parameters of the Cloud
+   */
+  GrainParameters& GetParameters() { return mParameterStore.Edit(); }
+
+  /**
+   *\fn: PublishParameters
+   *\brief: Publishes the GUI Thread's Copy of the Parameters to the Audio Thread
+   */
+  void PublishParameters() { mParameterStore.Publish(); }
 
   /*
-   *\fn: GetStartingSample
-   *\brief: Gets the Starting Sample of a Grain
-   *\return: int - Sample where the grain starts
+   *\fn: GetCentroidSample
+   *\brief: Gets the Centroid Sample of the Cloud (GUI Thread)
+   *\return: int - Sample where the grains are centred
    */
-  int GetCentroidSample() { return mCentroidSample; }
+  int GetCentroidSample() { return mParameterStore.Edit().mCentroidSample; }
 
   /**
-   *\fn: SetDuration
-   *\brief: Sets the Duration of the Grain, and updates the Sample Delta and Ending Sample
-   *\param: int duration - duration (in ms) of the Grain
+   *\fn: SetAudioSource
+   *\brief: Hands a New Audio Source to the Audio Thread, which Swaps it in at the Start
+            of its Next Block and Retriggers the Grains. Never Blocks the Audio Thread,
+            the Source it Replaces is Freed by CollectRetiredSource (GUI Thread).
+   *\param: std::unique_ptr<SourceAudio> audio - The New Audio Source
+   */
+  void SetAudioSource(std::unique_ptr<SourceAudio> audio);
+
+  /**
+   *\fn: CollectRetiredSource
+   *\brief: Frees the Audio Source Last Replaced by the Audio Thread (GUI Thread).
+            Call Periodically, the Audio Thread Holds a New Source Back Until the
+            Previous One has been Collected.
+   */
+  void CollectRetiredSource();
+
+  /**
+   *\fn: UpdateAudioSource
+   *\brief: Swaps in the Newest Source Handed Over by SetAudioSource, if any, Even while the
+            Cloud is not Rendering (Audio Thread). Clouds Sharing the Source must be Handed
+            the Result Before they Next Render, the Swapped Out Source may be Freed.
+   *\return: const SourceAudio* - Source the Grains Read (nullptr if there is None)
    */
-  void SetDuration(int duration);
+  const SourceAudio* UpdateAudioSource();
+
+  /**
+   *\fn: ShareAudioSource
+   *\brief: Reads the Grains from a Source Owned by Another Cloud, which must Outlive
+            its Use (Audio Thread). Restarts the Grains if the Source Changes.
+   *\param: const SourceAudio* audio - Source to Read (nullptr for None)
+   */
+  void ShareAudioSource(const SourceAudio* audio);
 
   /**
    *\fn: SetAudioSource
@@ -77,26 +154,99 @@ public:
   void SetAudioSource(AudioFormatReader& audioReader);
 
   /**
-   *\fn: SetCloudSize
-   *\brief: Sets the Cloud Size
-   *\param: int size - number of grains in the cloud
+   *\fn: SetAudioSource
+   *\brief: Sets the Audio Source of the Grain from Audio Already in Memory
+   *\param: const AudioBuffer<float>& audio - Audio to Copy into the Grain's Source
+   *\param: double sampleRate - Sample Rate of the Audio
    */
-  void SetCloudSize(int size);
-  
+  void SetAudioSource(const AudioBuffer<float>& audio, double sampleRate);
+
+  /**
+   *\fn: MapAudioSource
+   *\brief: Reads the Grains Straight from a Memory Mapped WAV File, Converting the
+            Samples as they are Read. Opens in Constant Time, and Only the Parts
+            of the File the Grains Play are Ever Loaded into Memory.
+   *\param: const File& wavFile - Uncompressed WAV File (16, 24 or 32 bit PCM, or 32 bit float)
+   *\param: String& error - Receives the Reason if the File can not be Mapped
+   *\return: bool - True if Mapped, False if the Current Source was Kept
+   */
+  bool MapAudioSource(const File& wavFile, String& error);
+
+  /**
+   *\fn: IsSourceMapped
+   *\brief: Checks if the Audio Source is Read from a Memory Mapped File
+   *\return: bool - True if Mapped, False if Decoded into Memory
+   */
+  bool IsSourceMapped() { return mLoadedMapped; }
+
+  /**
+   *\fn: RetriggerGrains
+   *\brief: Randomizes and Restarts Every Active Grain (Audio Thread)
+   */
+  void RetriggerGrains();
+
+  /**
+   *\fn: SetSeed
+   *\brief: Seeds the Random Number Generator Used to Randomize Grains.
+            Call Before Rendering to Make a Render Reproducible.
+   *\param: int64 seed - New Seed
+   */
+  void SetSeed(int64 seed);
+
+  /**
+   *\fn: Prepare
+   *\brief: Allocates the Grain Pool and the Partial Mixes. Must not be Called While
+            the Cloud is Rendering (e.g. call from prepareToPlay), renderBlock Never Allocates.
+   *\param: int maxCloudSize - Maximum Number of Grains the Cloud can Play
+   *\param: int maxBlockSize - Largest Block BeginBlock Accepts (renderBlock splits larger blocks)
+   */
+  void Prepare(int maxCloudSize, int maxBlockSize = DefaultMaxBlockSize);
+
+  /**
+   *\fn: GetMaxCloudSize
+   *\brief: Gets the Maximum Number of Grains the Cloud can Play
+   *\return: int - Capacity of the Grain Pool
+   */
+  int GetMaxCloudSize() { return mPool.mCapacity; }
+
+  /**
+   *\fn: GetMaxBlockSize
+   *\brief: Gets the Largest Block BeginBlock Accepts
+   *\return: int - Length of the Partial Mixes (in samples)
+   */
+  int GetMaxBlockSize() { return mMaxBlockSize; }
 
   /**
    *\fn: GetSize
-   *\brief: Get's the Size of the Grain in Samples
+   *\brief: Get's the Size of the Grain's Newest Audio Source in Samples (GUI Thread)
    *\return: int - Size of the Grain in Samples
    */
-  int GetSize() {  return mWaveSize; };
+  int GetSize() {  return mLoadedSize; };
 
   /**
    *\fn: Reset
-   *\brief: Resets the Grain to its inital state
+   *\brief: Stops Playback. The Grains are Moved into their Release
+            by the Audio Thread at the Start of the Next Block.
    */
   void Reset();
 
+  /**
+   *\fn: StartNote
+   *\brief: Starts Playing a Note (Audio Thread, Between Blocks). Grains Left from the Last One
+            Fade Out over StealReleaseMs Alongside the New Note's Grains, so a Stolen Voice
+            does not Click. The Note Transposes and Scales Every Grain the Cloud Starts.
+   *\param: double semitones - Transposition of the Note, Added to the Pitch Offset
+   *\param: float gain - Gain of the Note, on top of the Global Gain
+   */
+  void StartNote(double semitones, float gain);
+
+  /**
+   *\fn: IsSounding
+   *\brief: Checks if the Cloud is Playing, or has Grains Still Fading Out (Audio Thread)
+   *\return: bool - True Until the Last Released Grain Finishes
+   */
+  bool IsSounding() const { return mIsPlaying || mPool.mNumGrains > 0; }
+
   /**
    *\fn: HasValidWAVFile
    *\brief: Checks if the Grain Has a Valid WAV File
@@ -107,31 +257,23 @@ public:
     return mHasValidWAVFile;
   }
 
-  //! Boolean for if the Grain is currently being played
-  bool mIsPlaying = false;
+  //! Default Capacity of the Grain Pool
+  static constexpr int DefaultMaxCloudSize = 2048;
 
-   //! Boolean for Determining if we are Randomly Panning the Granular Synth
-  bool mRandomPanning = false;
-  
-  //! Offset of where a Grain can start from
-  int mStartingOffset = 0; 
+  //! Default Length of the Partial Mixes (in samples)
+  static constexpr int DefaultMaxBlockSize = 4096;
 
-  //! Pitch Offset (in semitones)
-  double mPitchOffsetMin = 0.0;
-  double mPitchOffsetMax = 0.0;
+  //! Grains per Partition, the Unit of Work Handed to the GrainEngine's Workers
+  static constexpr int PartitionSize = 256;
 
-  //! Pitch Offset Level is used to Properly Generate Random Doubles in the valid range.
-  double mPitchOffsetLevel = 0.0; 
+  //! Lowest Density of a Density Driven Cloud (Grains per Second)
+  static constexpr double MinDensity = 0.1;
 
-  //! Gain Offset for a Individual Grain (in dB)
-  int mGainOffsetDbMin = 0;
-  int mGainOffsetDbMax = 0;
+  //! Fade Out of the Grains Left Sounding when a Voice is Stolen (in ms)
+  static constexpr double StealReleaseMs = 3.0;
 
-  //! Scalar Value for the Global Gain of the Cloud (gain value)
-  double mGlobalGain = 1.0;   
-  
-  //! Scalar Value for the Release Duration of the ADSR (in ms)
-  double mEnvelopeRelease = 100.0;
+  //! Boolean for if the Grain is currently being played
+  std::atomic<bool> mIsPlaying{ false };
 
   //! Sampling Rate of the Active Grain
   double mSamplingRate = 0.0;
@@ -140,67 +282,202 @@ private:
   //================================VARIABLES=====================================
   
 
-  //! AudioSampleBuffer of the Grain's Audio Source WAV file.
-  std::unique_ptr<AudioSampleBuffer> mAudioSourceBuffer; 
+  //! Audio Source of the Grain, Decoded into Memory or Memory Mapped (Audio Thread)
+  std::unique_ptr<SourceAudio> mSourceAudio;
 
-  /**
-   *\struct: GrainData
-   *\author: AnthonyBrigante
-   *\brief:
-      The GrainData Struct contains data about a specific grain inside
-      a grain cloud. GrainData is used and managed by the GrainCloud class.
-   */
-  struct GrainData
-  {
-    //! Current Playing Sample of a Grain
-    double mCurrentSample[2] = { 0.0, 0.0 }; 
+  //! Source the Grains Read, mSourceAudio or One Shared by Another Cloud (Audio Thread)
+  const SourceAudio* mActiveSource = nullptr;
+
+  //! Newest Source Handed Over by SetAudioSource, not yet Swapped in by the Audio Thread
+  std::atomic<SourceAudio*> mPendingSource{ nullptr };
+
+  //! Source Swapped out by the Audio Thread, Waiting to be Freed by CollectRetiredSource
+  std::atomic<SourceAudio*> mRetiredSource{ nullptr };
+
+  //! Per-Grain Playback State of the Grains in the Grain Cloud (Structure of Arrays)
+  GrainPool mPool;
+
+  //! Scratch List of Grains that Finished During the Current Frame (Sized to the Pool Capacity)
+  std::vector<int> mFinishedGrains;
+
+  //! Parameters Shared Between the GUI Thread and the Audio Thread
+  GrainParameterStore mParameterStore;
+
+  //! Indices 0 to Capacity - 1, Used to Spawn Ranges of Grains as a Batch
+  std::vector<int> mGrainIndices;
+
+  //! Random Number Generator Used to Randomize Grains (Audio Thread)
+  GrainRandom mRandom;
+
+  //! Random Number Generators Used to Respawn the Grains of Each Partition
+  std::vector<GrainRandom> mPartitionRandom;
+
+  //! Partial Mix of Each Partition (Left and Right Channel per Partition)
+  AudioBuffer<float> mPartials;
+
+  //! Onsets of the Grains of a Density Driven Cloud
+  GrainScheduler mScheduler;
 
-    int mStartingSample = 0;     //!< Actual Starting Sample for a Specific Grain
-    int mEndSample = 0;          //!< Ending Sample of a Grain
-    
-    double mPitchScalar = 1.0f;  //!< Scalar Value for a Randomized Pitch Offset
-    double mGainScalar = 1.0f;   //!< Scalar Value for a Randomized Gain Offset (gain value)
-    double mPanningValue = 1.0f; //!< Scalar Value for a Random Pan
-    
-    bool mInRelease = true;     //!< Boolean for whether or not the Grain needs to be replayed.
+  //! Offsets the Modulators Add to the Parameters, per ModulationMatrix::ControlInterval Samples
+  ModulationMatrix mModulation;
 
-    juce::ADSR envelope;    //!< ADSR Envelope for a Grain
+  //! Control Rate Global Gain Modulation of the Block, as Gains Rather than dB (One per Interval, Plus the Start)
+  std::vector<float> mModulationGains;
 
-  };
+  //! Grains Started this Block, and the Frames Each Waits for its Onset
+  std::vector<int> mOnsetGrains;
+  std::vector<int> mOnsetDelays;
 
-  //! Vector Containing the Grains in the Grain Cloud
-  std::vector<GrainData> grains; 
+  int64 mClock = 0;         //!< Samples Rendered Since the Cloud was Created (the Scheduler's Time)
+  bool mScheduling = false; //!< True While the Scheduler is Starting Grains (Stopped by a Release)
+  bool mWasPlaying = false; //!< Whether the Cloud was Playing Last Block (Playback Starting Restarts the Envelopes)
+  int mStealFrames = 0;     //!< Frames Left of the Fade of a Stolen Voice's Grains (Released Grains Fade at its Rate)
 
-  int mCloudSize = 0;       //!< Size of the Grain Cloud (Number of Grains to Play)
+  int64 mSeed = 0;          //!< Seed of the Random Number Generators
+  int mMaxBlockSize = 0;    //!< Length of the Partial Mixes (in samples)
+
+  //! State of the Block Being Rendered, Set by BeginBlock
+  GrainSource mBlockSource;       //!< Audio Source the Grains Read From
+  double mBlockLastSample = 0.0;  //!< Last Readable Sample of the Audio Source
+  float mBlockReleaseRate = 0.0f; //!< Envelope Decrease per Frame After a Grain is Released
+  float mBlockGain = 0.0f;        //!< Output Gain of the Cloud
+  float mLastBlockGain = 0.0f;    //!< Output Gain of the Last Block Mixed, Ramped from to Avoid Steps
+  InterpolationQuality mBlockInterpolation = LINEAR; //!< Interpolator the Grains Read the Source With
+  bool mBlockRespawn = false;     //!< Whether Finished Grains are Restarted (Continuous and Playing) or Removed
+  int mBlockLanes = 0;            //!< Number of Lanes the Partitions Cover
+  int mBlockPartitions = 0;       //!< Number of Partitions in the Block
+
+  //! Parameters Currently Applied by the Audio Thread
+  GrainParameters mParameters;
+
+  //! Window Shared by Every Grain, Sized to the Grain Duration
+  Envelope mEnvelope;
+
+  //! Set by Reset, Tells the Audio Thread to Release Every Grain
+  std::atomic<bool> mReleaseRequested{ false };
+
+  double mNoteOctaves = 0.0; //!< Transposition of the Note Playing the Cloud (in octaves)
+  float mNoteGain = 1.0f;    //!< Gain of the Note Playing the Cloud
 
-  int mCentroidSample = 1;  //!< The Centroid Sample for a Grain Cloud
-  int mDuration = 0;        //!< Duration (in ms) of a Grain Cloud
   int mSampleDelta = 0;     //!< Delta Between the Starting Sample and the Ending Sample (determined by Duration)
 
 
   int mWaveSize = 0;        //!< The Size of the Audio Waveform being used
+  double mSourceSampleRate = 0.0; //!< Sampling Rate of the Audio Waveform being used (Audio Thread)
+
+  int mLoadedSize = 0;      //!< Size of the Newest Audio Source (GUI Thread)
+  bool mLoadedMapped = false; //!< Whether the Newest Audio Source is Memory Mapped (GUI Thread)
 
   bool mHasValidWAVFile;    //!< Boolean for whether or not the Grain has a valid WAV file.
 
   //================================FUNCTIONS=====================================
 
   /**
-   *\fn: RandomizeGrain
-   *\brief: Randomizes a Grain
-   *\param: GrainData& grain - Grain Parameters to Randomize
+   *\fn: AdoptPendingSource
+   *\brief: Swaps in the Newest Audio Source, if any, and Updates The Grain's Properties (Audio Thread)
+   */
+  void AdoptPendingSource();
+
+  /**
+   *\fn: UseSource
+   *\brief: Points the Grains at a Source and Updates The Grain's Properties (Audio Thread)
+   *\param: const SourceAudio* audio - Source to Read (nullptr for None)
+   */
+  void UseSource(const SourceAudio* audio);
+
+  /**
+   *\fn: RemoveFinishedGrains
+   *\brief: Removes the Grains that Finished Last Block without being Restarted, Keeping the Rest Packed
+   */
+  void RemoveFinishedGrains();
+
+  /**
+   *\fn: StartScheduledGrains
+   *\brief: Starts the Grains whose Onsets Fall in the Block, Each Delayed to its Onset Sample
+   *\param: int numSamples - Number of Samples in the Block
+   */
+  void StartScheduledGrains(int numSamples);
+
+  /**
+   *\fn: RenderPartitionWith
+   *\brief: Renders One Partition of the Block, Picking the Kernel for the Interpolation Quality
+   *\tparam: SampleReader - Reader for the Sample Format of the Source (see SourceReaders)
+   *\param: int partition - Partition to Render
+   *\param: int numSamples - Number of Samples in the Block
+   */
+  template <typename SampleReader>
+  void RenderPartitionWith(int partition, int numSamples);
+
+  /**
+   *\fn: MixPartition
+   *\brief: Renders One Partition of the Block with the Kernel for a Sample Format and Interpolator
+   *\tparam: SampleReader - Reader for the Sample Format of the Source (see SourceReaders)
+   *\tparam: Interpolator - Interpolator Reading the Source Between Samples (see Interpolators)
+   *\param: int partition - Partition to Render
+   *\param: int numSamples - Number of Samples in the Block
+   */
+  template <typename SampleReader, typename Interpolator>
+  void MixPartition(int partition, int numSamples);
+
+  /**
+   *\fn: ApplyParameters
+   *\brief: Applies a New Parameter Snapshot on the Audio Thread
+   *\param: const GrainParameters& parameters - Snapshot to Apply
+   */
+  void ApplyParameters(const GrainParameters& parameters);
+
+  /**
+   *\fn: ReleaseGrains
+   *\brief: Moves Every Grain into its Release
+   */
+  void ReleaseGrains();
+
+  /**
+   *\fn: FadeOutStolenGrains
+   *\brief: Fades Every Grain Out over StealReleaseMs, Continuing Released Grains from their Current Level
+   */
+  void FadeOutStolenGrains();
+
+  /**
+   *\fn: ResizeCloud
+   *\brief: Adds or Removes Grains to Match the Cloud Size (Continuous Clouds)
+   */
+  void ResizeCloud();
+
+  /**
+   *\fn: SpawnGrains
+   *\brief: Randomizes a Batch of Grains (Starting Sample, Pitch, Gain and Pan)
+            and Restarts their Envelopes
+   *\param: const int* grains - Indices of the Grains in the GrainPool to Randomize
+   *\param: int count - Number of Grains in the Batch
+   *\param: GrainRandom& random - Random Number Generator to Draw From
+   *\param: int frame - Frame of the Block the Grains Start at, where the Modulation is Read
+   */
+  void SpawnGrains(const int* grains, int count, GrainRandom& random, int frame);
+
+  /**
+   *\fn: UpdateEnvelope
+   *\brief: Rebuilds the Envelope Window from the Shape, Fades and Duration
+   */
+  void UpdateEnvelope();
+
+  /**
+   *\fn: UpdateGrainLength
+   *\brief: Updates the Window Length of a Grain from its Starting Sample and Pitch
+   *\param: int grain - Index of the Grain in the GrainPool to Update
    */
-  void RandomizeGrain(GrainData& grain);
+  void UpdateGrainLength(int grain);
 
   /**
    *\fn: AddGrains
-   *\brief: Adds Grains from the GrainCloud
+   *\brief: Activates Grains from the GrainPool (Never Allocates)
    *\param: int count - number of grains to add (default - 1)
    */
   void AddGrains(int count = 1);
 
   /**
    *\fn: RemoveGrains
-   *\brief: Removes Grains from the GrainCloud
+   *\brief: Deactivates Grains from the GrainPool (Never Allocates)
    *\param: int count - number of grains to remove (default - 1)
    */
   void RemoveGrains(int count = 1);
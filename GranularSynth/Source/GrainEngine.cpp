@@ -0,0 +1,188 @@
+/*****************************************************************************/
+/*!
+\file   GrainEngine.cpp
+\author Anthony Brigante
+\par    email: anthonypbrigante\@gmail.com
+\par    GitHub Repository: https://github.com/abrigante1/GranularSynth
+\brief
+  Implementation of the GrainEngine Class.
+*/
+/*****************************************************************************/
+
+#include "GrainEngine.h"
+
+// ------------------------------------------------------------------------------------
+// ------------------------------------------------------------------------------------
+// ------------------------------------------------------------------------------------
+
+GrainEngine::Worker::Worker(GrainEngine& engine, int index)
+  : Thread("Grain Worker " + String(index)), mEngine(engine)
+{
+}
+
+// ------------------------------------------------------------------------------------
+
+void GrainEngine::Worker::run()
+{
+  while (!threadShouldExit())
+  {
+    mWake.wait(-1);
+
+    if (threadShouldExit())
+      break;
+
+    mEngine.RunTasks();
+  }
+}
+
+// ------------------------------------------------------------------------------------
+// ------------------------------------------------------------------------------------
+// ------------------------------------------------------------------------------------
+
+GrainEngine::GrainEngine()
+{
+  mTasks.resize(static_cast<size_t>(DefaultMaxTasks));
+}
+
+// ------------------------------------------------------------------------------------
+
+GrainEngine::~GrainEngine()
+{
+  StopWorkers();
+}
+
+// ------------------------------------------------------------------------------------
+
+int GrainEngine::GetDefaultNumWorkers()
+{
+  return jlimit(0, MaxWorkers, SystemStats::getNumCpus() - 1);
+}
+
+// ------------------------------------------------------------------------------------
+
+void GrainEngine::Prepare(int numWorkers, int maxTasks)
+{
+  StopWorkers();
+
+  mTasks.resize(static_cast<size_t>(jlimit(1, static_cast<int>(MaxTasks), maxTasks)));
+
+  numWorkers = jlimit(0, MaxWorkers, numWorkers);
+  const int numCpus = SystemStats::getNumCpus();
+
+  for (int i = 0; i < numWorkers; ++i)
+  {
+    mWorkers.push_back(std::make_unique<Worker>(*this, i));
+
+    // Pin Each Worker to its Own Core, Leaving Core 0 to the Calling Thread
+    if (i + 1 < numCpus && i + 1 < 32)
+      mWorkers.back()->setAffinityMask(1u << (i + 1));
+
+    mWorkers.back()->startThread(9);
+  }
+}
+
+// ------------------------------------------------------------------------------------
+
+void GrainEngine::StopWorkers()
+{
+  for (auto& worker : mWorkers)
+  {
+    worker->signalThreadShouldExit();
+    worker->mWake.signal();
+  }
+
+  for (auto& worker : mWorkers)
+    worker->stopThread(1000);
+
+  mWorkers.clear();
+}
+
+// ------------------------------------------------------------------------------------
+
+void GrainEngine::Render(GrainCloud* const* clouds, int numClouds, AudioBuffer<float>& buffer, int startSample, int numSamples)
+{
+  buffer.clear(startSample, numSamples);
+
+  if (numClouds <= 0)
+    return;
+
+  // Every Cloud must Fit the Chunk in its Partial Mixes
+  int maxBlockSize = numSamples;
+  for (int i = 0; i < numClouds; ++i)
+    maxBlockSize = jmin(maxBlockSize, clouds[i]->GetMaxBlockSize());
+
+  maxBlockSize = jmax(1, maxBlockSize);
+
+  for (int offset = 0; offset < numSamples; offset += maxBlockSize)
+  {
+    const int blockSize = jmin(maxBlockSize, numSamples - offset);
+    const int maxTasks = static_cast<int>(mTasks.size());
+
+    int numTasks = 0;
+    for (int i = 0; i < numClouds; ++i)
+    {
+      const int numPartitions = clouds[i]->BeginBlock(blockSize);
+
+      for (int partition = 0; partition < numPartitions; ++partition)
+      {
+        // Partitions that do not Fit the Task List are Rendered Here
+        if (numTasks < maxTasks)
+          mTasks[static_cast<size_t>(numTasks++)] = { clouds[i], partition };
+        else
+          clouds[i]->RenderPartition(partition, blockSize);
+      }
+    }
+
+    if (numTasks > 0)
+    {
+      mBlockSize = blockSize;
+      mTasksRemaining.store(numTasks, std::memory_order_relaxed);
+
+      // The Block Number and Task Count are Published in the Same Word as the Index, so a Worker
+      // Late from the Last Block Fails its Claim Instead of Taking a Task of this One
+      const uint64 block = (mNextTask.load(std::memory_order_relaxed) >> 32) + 1;
+      mNextTask.store((block << 32) | (static_cast<uint64>(numTasks) << TaskBits), std::memory_order_release);
+
+      // Only Wake as Many Workers as there are Spare Tasks
+      const int numToWake = jmin(GetNumWorkers(), numTasks - 1);
+      for (int i = 0; i < numToWake; ++i)
+        mWorkers[static_cast<size_t>(i)]->mWake.signal();
+
+      // The Calling Thread Renders Too, then Waits for the Stragglers
+      RunTasks();
+
+      while (mTasksRemaining.load(std::memory_order_acquire) > 0)
+        Thread::yield();
+    }
+
+    // Sum the Partials, Cloud by Cloud
+    for (int i = 0; i < numClouds; ++i)
+      clouds[i]->EndBlock(buffer, startSample + offset, blockSize);
+  }
+}
+
+// ------------------------------------------------------------------------------------
+
+void GrainEngine::RunTasks()
+{
+  uint64 next = mNextTask.load(std::memory_order_acquire);
+
+  for (;;)
+  {
+    const int task = static_cast<int>(next & TaskMask);
+    const int numTasks = static_cast<int>((next >> TaskBits) & TaskMask);
+
+    if (task >= numTasks)
+      return;
+
+    // Claim the Task, Fails (and Reloads next) if Another Thread got there First
+    if (!mNextTask.compare_exchange_weak(next, next + 1, std::memory_order_acq_rel, std::memory_order_acquire))
+      continue;
+
+    const Task& current = mTasks[static_cast<size_t>(task)];
+    current.mCloud->RenderPartition(current.mPartition, mBlockSize);
+
+    mTasksRemaining.fetch_sub(1, std::memory_order_acq_rel);
+    next = mNextTask.load(std::memory_order_acquire);
+  }
+}
@@ -0,0 +1,149 @@
+/*****************************************************************************/
+/*!
+\file   GrainEngine.h
+\author Anthony Brigante
+\par    email: anthonypbrigante\@gmail.com
+\par    GitHub Repository: https://github.com/abrigante1/GranularSynth
+\brief
+  Definition of the GrainEngine Class.
+  The GrainEngine renders one or more GrainClouds per block, spreading the
+  partitions of every cloud over a pool of worker threads.
+*/
+/*****************************************************************************/
+#pragma once
+#include <JuceHeader.h>
+#include "Grain.h"
+
+/**
+ *\class: GrainEngine
+ *\author: Anthony Brigante
+ *\brief:
+    The GrainEngine Class renders GrainClouds on several cores. Every cloud
+    is split into partitions of GrainCloud::PartitionSize grains, and the
+    partitions of all of the clouds are handed out to the calling thread and
+    to the worker threads from a shared task list.
+
+    Each partition renders into its own partial mix, and the partial mixes
+    are summed in a fixed order once every partition has finished, so the
+    output is identical for any number of workers.
+
+    The workers are started by Prepare, each pinned to its own core, and
+    wait on an event between blocks. Render never allocates or locks.
+ */
+class GrainEngine
+{
+public:
+
+  /**
+   *\fn: GrainEngine
+   *\brief: Constructor for a GrainEngine. Renders on the Calling Thread Only
+            Until Prepare is Called.
+   */
+  GrainEngine();
+
+  /**
+   *\fn: ~GrainEngine
+   *\brief: Destructor for a GrainEngine, Stops the Worker Threads
+   */
+  ~GrainEngine();
+
+  /**
+   *\fn: Prepare
+   *\brief: Starts the Worker Threads and Allocates the Task List. Must not be
+            Called While Rendering (e.g. call from prepareToPlay).
+   *\param: int numWorkers - Number of Worker Threads (0 Renders on the Calling Thread Only)
+   *\param: int maxTasks - Largest Number of Partitions per Block (across every cloud)
+   */
+  void Prepare(int numWorkers, int maxTasks = DefaultMaxTasks);
+
+  /**
+   *\fn: Render
+   *\brief: Renders a Block of Several Clouds into an Audio Buffer.
+            The Clouds are Mixed in the Order they are Given.
+   *\param: GrainCloud* const* clouds - Clouds to Render
+   *\param: int numClouds - Number of Clouds
+   *\param: AudioBuffer<float>& buffer - Buffer to Render the Clouds Into
+   *\param: int startSample - First Sample in the Buffer to Write
+   *\param: int numSamples - Number of Samples to Render
+   */
+  void Render(GrainCloud* const* clouds, int numClouds, AudioBuffer<float>& buffer, int startSample, int numSamples);
+
+  /**
+   *\fn: GetNumWorkers
+   *\brief: Gets the Number of Worker Threads
+   *\return: int - Number of Running Workers
+   */
+  int GetNumWorkers() const { return static_cast<int>(mWorkers.size()); }
+
+  /**
+   *\fn: GetDefaultNumWorkers
+   *\brief: Gets the Number of Workers that Leaves One Core to the Calling Thread
+   *\return: int - Number of Cores - 1 (at most MaxWorkers)
+   */
+  static int GetDefaultNumWorkers();
+
+  //! Default Size of the Task List (Partitions per Block)
+  static constexpr int DefaultMaxTasks = 256;
+
+  //! Largest Task List Prepare Allocates (Partitions Past it are Rendered by the Calling Thread)
+  static constexpr int MaxTasks = 65535;
+
+  //! Upper Limit on the Number of Worker Threads
+  static constexpr int MaxWorkers = 31;
+
+private:
+
+  //! A Single Partition of a Cloud
+  struct Task
+  {
+    GrainCloud* mCloud;     //!< Cloud the Partition Belongs to
+    int mPartition;         //!< Index of the Partition Within the Cloud
+  };
+
+  /**
+   *\class: Worker
+   *\brief: Thread that Renders Tasks Whenever a Block is Started
+   */
+  class Worker : public Thread
+  {
+  public:
+    Worker(GrainEngine& engine, int index);
+    void run() override;
+
+    WaitableEvent mWake;    //!< Signalled When a Block is Started (or the Thread Should Exit)
+
+  private:
+    GrainEngine& mEngine;
+  };
+
+  //================================VARIABLES=====================================
+
+  std::vector<std::unique_ptr<Worker>> mWorkers; //!< Worker Threads
+  std::vector<Task> mTasks;                      //!< Partitions of the Current Block
+
+  //! Bits of mNextTask Holding the Task Count, and Again the Index of the Next Task
+  static constexpr int TaskBits = 16;
+
+  //! Mask of the Task Count and of the Task Index
+  static constexpr uint64 TaskMask = (static_cast<uint64>(1) << TaskBits) - 1;
+
+  //! Block Number (High 32 Bits), Task Count (Next 16) and Index of the Next Task (Low 16), Swapped as One
+  std::atomic<uint64> mNextTask{ 0 };
+  std::atomic<int> mTasksRemaining{ 0 };         //!< Number of Tasks not yet Finished
+
+  int mBlockSize = 0;                            //!< Number of Samples in the Current Block
+
+  //================================FUNCTIONS=====================================
+
+  /**
+   *\fn: StopWorkers
+   *\brief: Stops and Destroys Every Worker Thread
+   */
+  void StopWorkers();
+
+  /**
+   *\fn: RunTasks
+   *\brief: Renders Tasks from the Current Block Until None are Left to Hand Out
+   */
+  void RunTasks();
+};
@@ -0,0 +1,181 @@
+/*****************************************************************************/
+/*!
+\file   GrainInterpolation.h
+\author Anthony Brigante
+\par    email: anthonypbrigante\@gmail.com
+\par    GitHub Repository: https://github.com/abrigante1/GranularSynth
+\brief
+  The Interpolators Used by the Grain Mixing Kernel to Read the Source
+  Between Samples. Each Interpolator is a Policy the Kernel is Instantiated
+  With, so every quality level gets its own branch-free inner loop.
+*/
+/*****************************************************************************/
+#pragma once
+#include "GrainSimd.h"
+#include <cmath>
+#include <vector>
+
+//! Interpolation Quality of a Grain Cloud (Chosen Once per Block, Not per Sample)
+enum InterpolationQuality
+{
+  LINEAR = 0,
+  HERMITE,
+  SINC,
+  NUMBER_OF_INTERPOLATION_QUALITIES
+};
+
+/**
+ *\brief:
+    Interpolator Policies. An Interpolator Reads NumTaps Samples Starting
+    FirstTap Samples from the Truncated Read Position, and Weights them by
+    the Fraction of the Position Past the Truncated Sample:
+
+      Output = Sum(Weight[tap] * Source[index + FirstTap + tap])
+ */
+namespace Interpolators
+{
+  /**
+   *\struct: Linear
+   *\brief: Straight Line Between the Two Nearest Samples. Cheapest, for Live Use.
+   */
+  struct Linear
+  {
+    static constexpr int FirstTap = 0;
+    static constexpr int NumTaps = 2;
+
+    static void Weights(float fraction, float* weights)
+    {
+      weights[0] = 1.0f - fraction;
+      weights[1] = fraction;
+    }
+
+#if GRAIN_KERNEL_USE_SSE2
+    static void Weights(__m128 fraction, __m128* weights)
+    {
+      weights[0] = _mm_sub_ps(_mm_set1_ps(1.0f), fraction);
+      weights[1] = fraction;
+    }
+#endif
+  };
+
+  /**
+   *\struct: Hermite
+   *\brief: 4-Point, 3rd-Order Hermite (Catmull-Rom) Spline Through the Four Nearest Samples
+   */
+  struct Hermite
+  {
+    static constexpr int FirstTap = -1;
+    static constexpr int NumTaps = 4;
+
+    static void Weights(float t, float* weights)
+    {
+      const float t2 = t * t;
+      const float t3 = t2 * t;
+
+      weights[0] = -0.5f * t3 + t2 - 0.5f * t;
+      weights[1] =  1.5f * t3 - 2.5f * t2 + 1.0f;
+      weights[2] = -1.5f * t3 + 2.0f * t2 + 0.5f * t;
+      weights[3] =  0.5f * t3 - 0.5f * t2;
+    }
+
+#if GRAIN_KERNEL_USE_SSE2
+    static void Weights(__m128 t, __m128* weights)
+    {
+      const __m128 t2 = _mm_mul_ps(t, t);
+      const __m128 t3 = _mm_mul_ps(t2, t);
+      const __m128 half = _mm_set1_ps(0.5f);
+      const __m128 oneAndHalf = _mm_set1_ps(1.5f);
+
+      weights[0] = _mm_sub_ps(_mm_add_ps(_mm_mul_ps(_mm_set1_ps(-0.5f), t3), t2), _mm_mul_ps(half, t));
+      weights[1] = _mm_add_ps(_mm_sub_ps(_mm_mul_ps(oneAndHalf, t3), _mm_mul_ps(_mm_set1_ps(2.5f), t2)), _mm_set1_ps(1.0f));
+      weights[2] = _mm_add_ps(_mm_add_ps(_mm_mul_ps(_mm_set1_ps(-1.5f), t3), _mm_add_ps(t2, t2)), _mm_mul_ps(half, t));
+      weights[3] = _mm_mul_ps(half, _mm_sub_ps(t3, t2));
+    }
+#endif
+  };
+
+  /**
+   *\struct: Sinc
+   *\brief: 8-Tap Blackman Windowed Sinc. Highest Quality, for Offline Renders.
+            The Weights are Read from a Table of Phases, Normalised to Unity Gain.
+   */
+  struct Sinc
+  {
+    static constexpr int FirstTap = -3;
+    static constexpr int NumTaps = 8;
+    static constexpr int NumPhases = 1024;
+
+    /**
+     *\fn: GetTable
+     *\brief: Gets the Weight Table, (NumPhases + 1) Rows of NumTaps Weights.
+              Built on First Use, the GrainCloud Constructor Builds it Off the Audio Thread.
+     *\return: const float* - The Weight Table
+     */
+    static const float* GetTable()
+    {
+      static const std::vector<float> table = BuildTable();
+      return table.data();
+    }
+
+    static void Weights(float fraction, float* weights)
+    {
+      const float* row = GetTable() + static_cast<int>(fraction * NumPhases + 0.5f) * NumTaps;
+
+      for (int tap = 0; tap < NumTaps; ++tap)
+        weights[tap] = row[tap];
+    }
+
+#if GRAIN_KERNEL_USE_SSE2
+    static void Weights(__m128 fraction, __m128* weights)
+    {
+      const float* table = GetTable();
+
+      alignas(16) int phase[4];
+      _mm_store_si128(reinterpret_cast<__m128i*>(phase),
+                      _mm_cvttps_epi32(_mm_add_ps(_mm_mul_ps(fraction, _mm_set1_ps(static_cast<float>(NumPhases))),
+                                                  _mm_set1_ps(0.5f))));
+
+      const float* row0 = table + phase[0] * NumTaps;
+      const float* row1 = table + phase[1] * NumTaps;
+      const float* row2 = table + phase[2] * NumTaps;
+      const float* row3 = table + phase[3] * NumTaps;
+
+      for (int tap = 0; tap < NumTaps; ++tap)
+        weights[tap] = _mm_setr_ps(row0[tap], row1[tap], row2[tap], row3[tap]);
+    }
+#endif
+
+  private:
+
+    static std::vector<float> BuildTable()
+    {
+      const double pi = 3.14159265358979323846;
+      std::vector<float> table(static_cast<size_t>((NumPhases + 1) * NumTaps));
+
+      for (int phase = 0; phase <= NumPhases; ++phase)
+      {
+        const double fraction = static_cast<double>(phase) / NumPhases;
+        double weights[NumTaps];
+        double sum = 0.0;
+
+        for (int tap = 0; tap < NumTaps; ++tap)
+        {
+          // Distance from the Read Position, and Position Within the Window (Centred on the Read Position)
+          const double x = (FirstTap + tap) - fraction;
+          const double w = (x + 0.5 * NumTaps) / NumTaps;
+
+          const double sinc = (std::abs(x) < 1e-9) ? 1.0 : std::sin(pi * x) / (pi * x);
+          const double window = 0.42 - 0.5 * std::cos(2.0 * pi * w) + 0.08 * std::cos(4.0 * pi * w);
+
+          weights[tap] = sinc * window;
+          sum += weights[tap];
+        }
+
+        for (int tap = 0; tap < NumTaps; ++tap)
+          table[static_cast<size_t>(phase * NumTaps + tap)] = static_cast<float>(weights[tap] / sum);
+      }
+
+      return table;
+    }
+  };
+}
@@ -0,0 +1,317 @@
+/*****************************************************************************/
+/*!
+\file   GrainKernel.h
+\author Anthony Brigante
+\par    email: anthonypbrigante\@gmail.com
+\par    GitHub Repository: https://github.com/abrigante1/GranularSynth
+\brief
+  The Grain Mixing Kernel. Mixes one frame of every grain in a GrainPool,
+  processing GrainPool::LaneWidth grains per instruction when SSE2 is
+  available, with a scalar fallback for other targets. The kernel is
+  instantiated per source sample format and per interpolator.
+*/
+/*****************************************************************************/
+#pragma once
+#include "GrainPool.h"
+#include "Envelope.h"
+#include "GrainSource.h"
+#include "GrainInterpolation.h"
+#include "GrainSimd.h"
+
+namespace GrainKernel
+{
+#if GRAIN_KERNEL_USE_SSE2
+  /**
+   *\fn: HorizontalSum
+   *\brief: Sums the Four Lanes of a Vector
+   *\param: __m128 value - Vector to Sum
+   *\return: float - Sum of the Lanes
+   */
+  inline float HorizontalSum(__m128 value)
+  {
+    __m128 shuffled = _mm_shuffle_ps(value, value, _MM_SHUFFLE(2, 3, 0, 1));
+    __m128 sums = _mm_add_ps(value, shuffled);
+    shuffled = _mm_movehl_ps(shuffled, sums);
+    sums = _mm_add_ss(sums, shuffled);
+    return _mm_cvtss_f32(sums);
+  }
+
+  /**
+   *\fn: EvaluateEnvelope
+   *\brief: Evaluates the Envelopes of Four Grains
+   *\param: __m128 envelopeFrame - Envelope Positions of the Grains
+   *\param: __m128 envelopeScale - Envelope Table Entries per Frame of the Grains
+   *\param: __m128 releaseStart - Envelope Positions where the Grains are Released
+   *\param: const float* table - Envelope Window Table
+   *\param: __m128 lastEntry - Index of the Last Entry of the Table
+   *\param: __m128 release - Release Rate (per frame)
+   *\return: __m128 - Envelope = Window(Position) * clamp(Release Ramp, 0, 1), 0 Before a Grain Starts
+   */
+  inline __m128 EvaluateEnvelope(__m128 envelopeFrame, __m128 envelopeScale, __m128 releaseStart,
+                                 const float* table, __m128 lastEntry, __m128 release)
+  {
+    const __m128 one = _mm_set1_ps(1.0f);
+    const __m128 zero = _mm_setzero_ps();
+
+    // Look up the Window, the Table Reads Themselves are a Scalar Gather
+    alignas(16) int index[GrainPool::LaneWidth];
+    _mm_store_si128(reinterpret_cast<__m128i*>(index),
+                    _mm_cvttps_epi32(_mm_max_ps(_mm_min_ps(_mm_mul_ps(envelopeFrame, envelopeScale), lastEntry), zero)));
+
+    // Grains Waiting for their Onset (a Negative Position) are Silent
+    const __m128 window = _mm_and_ps(_mm_cmpge_ps(envelopeFrame, zero),
+                                     _mm_setr_ps(table[index[0]], table[index[1]], table[index[2]], table[index[3]]));
+
+    // Fade Out Grains that have been Released
+    __m128 level = _mm_sub_ps(one, _mm_mul_ps(_mm_sub_ps(envelopeFrame, releaseStart), release));
+    level = _mm_max_ps(_mm_min_ps(level, one), zero);
+
+    return _mm_mul_ps(window, level);
+  }
+#else
+  /**
+   *\fn: EvaluateEnvelope
+   *\brief: Evaluates the Envelope of a Single Grain
+   *\param: float envelopeFrame - Envelope Position of the Grain
+   *\param: float envelopeScale - Envelope Table Entries per Frame of the Grain
+   *\param: float releaseStart - Envelope Position where the Grain is Released
+   *\param: const float* table - Envelope Window Table
+   *\param: float lastEntry - Index of the Last Entry of the Table
+   *\param: float releaseRate - Release Rate (per frame)
+   *\return: float - Envelope = Window(Position) * clamp(Release Ramp, 0, 1), 0 Before the Grain Starts
+   */
+  inline float EvaluateEnvelope(float envelopeFrame, float envelopeScale, float releaseStart,
+                                const float* table, float lastEntry, float releaseRate)
+  {
+    // Grains Waiting for their Onset (a Negative Position) are Silent
+    if (envelopeFrame < 0.0f)
+      return 0.0f;
+
+    const float entry = envelopeFrame * envelopeScale;
+    const float window = table[static_cast<int>((entry < lastEntry) ? entry : lastEntry)];
+
+    float level = 1.0f - (envelopeFrame - releaseStart) * releaseRate;
+    level = (level < 1.0f) ? level : 1.0f;
+    return window * ((level > 0.0f) ? level : 0.0f);
+  }
+#endif
+
+  /**
+   *\fn: EvaluateEnvelopes
+   *\brief: Evaluates the Current Envelope Level of Every Lane in the Pool
+   *\param: const GrainPool& pool - Grains to Evaluate
+   *\param: const Envelope& envelope - Envelope Window Shared by the Grains
+   *\param: float releaseRate - Envelope Decrease per Frame After a Grain is Released
+   *\param: float* envelopes - Receives One Level per Lane (GetNumLanes() Elements)
+   */
+  inline void EvaluateEnvelopes(const GrainPool& pool, const Envelope& envelope, float releaseRate, float* envelopes)
+  {
+    const int numLanes = pool.GetNumLanes();
+    const float* envelopePosition = pool.mEnvelopePosition.data();
+    const float* envelopeScale = pool.mEnvelopeScale.data();
+    const float* releaseStart = pool.mReleaseStart.data();
+    const float* table = envelope.GetTable();
+
+#if GRAIN_KERNEL_USE_SSE2
+    const __m128 lastEntry = _mm_set1_ps(static_cast<float>(envelope.GetSize() - 1));
+    const __m128 release   = _mm_set1_ps(releaseRate);
+
+    for (int lane = 0; lane < numLanes; lane += GrainPool::LaneWidth)
+      _mm_storeu_ps(envelopes + lane, EvaluateEnvelope(_mm_loadu_ps(envelopePosition + lane), _mm_loadu_ps(envelopeScale + lane),
+                                                       _mm_loadu_ps(releaseStart + lane), table, lastEntry, release));
+#else
+    const float lastEntry = static_cast<float>(envelope.GetSize() - 1);
+
+    for (int lane = 0; lane < numLanes; ++lane)
+      envelopes[lane] = EvaluateEnvelope(envelopePosition[lane], envelopeScale[lane], releaseStart[lane],
+                                         table, lastEntry, releaseRate);
+#endif
+  }
+
+  /**
+   *\fn: ReadTap
+   *\brief: Reads One Interpolator Tap from a Channel of the Source. Guarded Sources are Read
+            Directly, Others Hold their First and Last Samples for Taps Outside the Source.
+   *\tparam: SampleReader - Reader for the Sample Format of the Source (see SourceReaders)
+   *\param: const char* channel - First Sample of the Channel
+   *\param: std::ptrdiff_t stride - Bytes Between Consecutive Samples of the Channel
+   *\param: int index - Sample to Read
+   *\param: int lastIndex - Last Readable Sample of the Source
+   *\return: float - The Sample
+   */
+  template <typename SampleReader>
+  inline float ReadTap(const char* channel, std::ptrdiff_t stride, int index, int lastIndex)
+  {
+    if (!SampleReader::IsGuarded)
+      index = (index < 0) ? 0 : ((index > lastIndex) ? lastIndex : index);
+
+    return SampleReader::Read(channel + index * stride);
+  }
+
+  /**
+   *\fn: MixFrame
+   *\brief: Mixes a Single Frame of a Range of Lanes in the Pool and Advances Each Grain by One Frame.
+            Each Grain is Shaped by the Shared Envelope Window, and Faded Out Once Released.
+            Grains with a Negative Envelope Position Wait Silently for their Onset.
+            Disjoint Lane Ranges can be Mixed Concurrently.
+   *\param: GrainPool& pool - Grains to Mix
+   *\param: int firstLane - First Lane to Mix (a Multiple of GrainPool::LaneWidth)
+   *\param: int endLane - One Past the Last Lane to Mix (a Multiple of GrainPool::LaneWidth)
+   *\tparam: SampleReader - Reader for the Sample Format of the Source (see SourceReaders)
+   *\tparam: Interpolator - Interpolator Reading the Source Between Samples (see Interpolators)
+   *\param: const GrainSource& source - Audio Source the Grains Read From
+   *\param: double lastSample - Last Readable Sample of the Audio Source (Unguarded Sources are Clamped to it)
+   *\param: const Envelope& envelope - Envelope Window Shared by the Grains
+   *\param: float releaseRate - Envelope Decrease per Frame After a Grain is Released
+   *\param: float& outputLeft - Mixed Left Sample
+   *\param: float& outputRight - Mixed Right Sample
+   *\param: int* finishedGrains - Receives the Indices of Grains that Finished this Frame
+   *\return: int - Number of Grains Written to finishedGrains
+   */
+  template <typename SampleReader, typename Interpolator>
+  inline int MixFrame(GrainPool& pool, int firstLane, int endLane, const GrainSource& source,
+                      double lastSample, const Envelope& envelope, float releaseRate,
+                      float& outputLeft, float& outputRight, int* finishedGrains)
+  {
+    static_assert(!SampleReader::IsGuarded || (-Interpolator::FirstTap <= SourceBuffer::GuardSamples
+                                               && Interpolator::FirstTap + Interpolator::NumTaps <= SourceBuffer::GuardSamples),
+                  "The Interpolator Reads Past the Source's Guard Samples");
+
+    int numFinished = 0;
+
+    double* position       = pool.mPosition.data();
+    const double* increment = pool.mIncrement.data();
+    const float* gainLeft  = pool.mGainLeft.data();
+    const float* gainRight = pool.mGainRight.data();
+    float* envelopePosition = pool.mEnvelopePosition.data();
+    const float* envelopeScale = pool.mEnvelopeScale.data();
+    const float* releaseStart = pool.mReleaseStart.data();
+    const float* lifetime  = pool.mLifetime.data();
+    const float* table     = envelope.GetTable();
+
+    const char* sourceLeft  = source.mLeft;
+    const char* sourceRight = source.mRight;
+    const std::ptrdiff_t stride = source.mFrameStride;
+    const int lastIndex = static_cast<int>(lastSample);
+
+#if GRAIN_KERNEL_USE_SSE2
+    const __m128 one       = _mm_set1_ps(1.0f);
+    const __m128 lastEntry = _mm_set1_ps(static_cast<float>(envelope.GetSize() - 1));
+    const __m128 release   = _mm_set1_ps(releaseRate);
+
+    __m128 sumLeft  = _mm_setzero_ps();
+    __m128 sumRight = _mm_setzero_ps();
+
+    for (int lane = firstLane; lane < endLane; lane += GrainPool::LaneWidth)
+    {
+      // Split the Read Positions into Whole Samples and Fractions
+      __m128d positionLow  = _mm_loadu_pd(position + lane);
+      __m128d positionHigh = _mm_loadu_pd(position + lane + 2);
+
+      const __m128i indexLow  = _mm_cvttpd_epi32(positionLow);
+      const __m128i indexHigh = _mm_cvttpd_epi32(positionHigh);
+
+      alignas(16) int index[GrainPool::LaneWidth];
+      _mm_store_si128(reinterpret_cast<__m128i*>(index), _mm_unpacklo_epi64(indexLow, indexHigh));
+
+      const __m128 fraction = _mm_movelh_ps(_mm_cvtpd_ps(_mm_sub_pd(positionLow,  _mm_cvtepi32_pd(indexLow))),
+                                            _mm_cvtpd_ps(_mm_sub_pd(positionHigh, _mm_cvtepi32_pd(indexHigh))));
+
+      __m128 weights[Interpolator::NumTaps];
+      Interpolator::Weights(fraction, weights);
+
+      // Weight the Taps, the Source Reads Themselves are a Scalar Gather
+      __m128 left  = _mm_setzero_ps();
+      __m128 right = _mm_setzero_ps();
+
+      for (int tap = 0; tap < Interpolator::NumTaps; ++tap)
+      {
+        const int offset = Interpolator::FirstTap + tap;
+        const int i0 = index[0] + offset;
+        const int i1 = index[1] + offset;
+        const int i2 = index[2] + offset;
+        const int i3 = index[3] + offset;
+
+        left  = _mm_add_ps(left,  _mm_mul_ps(weights[tap], _mm_setr_ps(ReadTap<SampleReader>(sourceLeft, stride, i0, lastIndex),
+                                                                         ReadTap<SampleReader>(sourceLeft, stride, i1, lastIndex),
+                                                                         ReadTap<SampleReader>(sourceLeft, stride, i2, lastIndex),
+                                                                         ReadTap<SampleReader>(sourceLeft, stride, i3, lastIndex))));
+        right = _mm_add_ps(right, _mm_mul_ps(weights[tap], _mm_setr_ps(ReadTap<SampleReader>(sourceRight, stride, i0, lastIndex),
+                                                                         ReadTap<SampleReader>(sourceRight, stride, i1, lastIndex),
+                                                                         ReadTap<SampleReader>(sourceRight, stride, i2, lastIndex),
+                                                                         ReadTap<SampleReader>(sourceRight, stride, i3, lastIndex))));
+      }
+
+      __m128 envelopeFrame = _mm_loadu_ps(envelopePosition + lane);
+      const __m128 level = EvaluateEnvelope(envelopeFrame, _mm_loadu_ps(envelopeScale + lane),
+                                            _mm_loadu_ps(releaseStart + lane), table, lastEntry, release);
+
+      sumLeft  = _mm_add_ps(sumLeft,  _mm_mul_ps(left,  _mm_mul_ps(level, _mm_loadu_ps(gainLeft + lane))));
+      sumRight = _mm_add_ps(sumRight, _mm_mul_ps(right, _mm_mul_ps(level, _mm_loadu_ps(gainRight + lane))));
+
+      // Advance the Grains that have Started (a Grain's Lifetime Ends Before it Reads Past its End Sample)
+      const __m128 started = _mm_cmpge_ps(envelopeFrame, _mm_setzero_ps());
+      positionLow  = _mm_add_pd(positionLow,  _mm_and_pd(_mm_castps_pd(_mm_unpacklo_ps(started, started)), _mm_loadu_pd(increment + lane)));
+      positionHigh = _mm_add_pd(positionHigh, _mm_and_pd(_mm_castps_pd(_mm_unpackhi_ps(started, started)), _mm_loadu_pd(increment + lane + 2)));
+      _mm_storeu_pd(position + lane,     positionLow);
+      _mm_storeu_pd(position + lane + 2, positionHigh);
+
+      envelopeFrame = _mm_add_ps(envelopeFrame, one);
+      _mm_storeu_ps(envelopePosition + lane, envelopeFrame);
+
+      // Report Grains that have Finished their Window (or their Release)
+      const int finishedMask = _mm_movemask_ps(_mm_cmpge_ps(envelopeFrame, _mm_loadu_ps(lifetime + lane)));
+
+      if (finishedMask != 0)
+      {
+        for (int i = 0; i < GrainPool::LaneWidth; ++i)
+          if (finishedMask & (1 << i))
+            finishedGrains[numFinished++] = lane + i;
+      }
+    }
+
+    outputLeft  = HorizontalSum(sumLeft);
+    outputRight = HorizontalSum(sumRight);
+#else
+    const float lastEntry = static_cast<float>(envelope.GetSize() - 1);
+
+    float sumLeft = 0.0f;
+    float sumRight = 0.0f;
+
+    for (int lane = firstLane; lane < endLane; ++lane)
+    {
+      const int index = static_cast<int>(position[lane]);
+
+      float weights[Interpolator::NumTaps];
+      Interpolator::Weights(static_cast<float>(position[lane] - index), weights);
+
+      float left = 0.0f;
+      float right = 0.0f;
+
+      for (int tap = 0; tap < Interpolator::NumTaps; ++tap)
+      {
+        left  += weights[tap] * ReadTap<SampleReader>(sourceLeft,  stride, index + Interpolator::FirstTap + tap, lastIndex);
+        right += weights[tap] * ReadTap<SampleReader>(sourceRight, stride, index + Interpolator::FirstTap + tap, lastIndex);
+      }
+
+      const float level = EvaluateEnvelope(envelopePosition[lane], envelopeScale[lane], releaseStart[lane],
+                                           table, lastEntry, releaseRate);
+
+      sumLeft  += left  * level * gainLeft[lane];
+      sumRight += right * level * gainRight[lane];
+
+      if (envelopePosition[lane] >= 0.0f)
+        position[lane] += increment[lane];
+
+      envelopePosition[lane] += 1.0f;
+      if (envelopePosition[lane] >= lifetime[lane])
+        finishedGrains[numFinished++] = lane;
+    }
+
+    outputLeft  = sumLeft;
+    outputRight = sumRight;
+#endif
+
+    return numFinished;
+  }
+}
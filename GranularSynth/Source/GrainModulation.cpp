@@ -0,0 +1,171 @@
+/*****************************************************************************/
+/*!
+\file   GrainModulation.cpp
+\author Anthony Brigante
+\par    email: anthonypbrigante\@gmail.com
+\par    GitHub Repository: https://github.com/abrigante1/GranularSynth
+\brief
+  Implementation of the ModulationMatrix Class.
+*/
+/*****************************************************************************/
+
+#include "GrainModulation.h"
+#include <cmath>
+
+namespace
+{
+  //! Offset a Full Scale Modulator Adds to Each Target (see ModulationTarget)
+  const float TargetRanges[NUMBER_OF_MODULATION_TARGETS] = { 0.0f, 1.0f, 0.5f, 24.0f, 24.0f, 24.0f, 3.0f };
+}
+
+// ------------------------------------------------------------------------------------
+// ------------------------------------------------------------------------------------
+// ------------------------------------------------------------------------------------
+
+void ModulationMatrix::Prepare(int maxBlockSize)
+{
+  mStride = (jmax(1, maxBlockSize) + ControlInterval - 1) / ControlInterval + 1;
+  mValues.assign(static_cast<size_t>(mStride) * NUMBER_OF_MODULATION_TARGETS, 0.0f);
+  mNumTicks = 0;
+  mNumSamples = 0;
+
+  for (bool& modulated : mModulated)
+    modulated = false;
+
+  for (int modulator = 0; modulator < NumModulators; ++modulator)
+  {
+    mPhase[modulator] = 0.0;
+    mEnvelope[modulator] = 0.0;
+    mWalk[modulator] = 0.0f;
+  }
+}
+
+// ------------------------------------------------------------------------------------
+
+void ModulationMatrix::Restart()
+{
+  // LFOs Run Freely, Only the Envelopes Start Over
+  for (double& envelope : mEnvelope)
+    envelope = 0.0;
+}
+
+// ------------------------------------------------------------------------------------
+
+void ModulationMatrix::Process(const ModulatorParameters* modulators, int numSamples, double sampleRate)
+{
+  jassert(numSamples <= (mStride - 1) * ControlInterval);
+
+  // Each Target Ramps from where the Last Block Ended
+  for (int target = 0; target < NUMBER_OF_MODULATION_TARGETS; ++target)
+  {
+    float* values = mValues.data() + target * mStride;
+    values[0] = values[mNumTicks];
+    mModulated[target] = (values[0] != 0.0f);
+  }
+
+  mNumSamples = numSamples;
+  mNumTicks = (numSamples + ControlInterval - 1) / ControlInterval;
+
+  for (int tick = 1; tick <= mNumTicks; ++tick)
+    for (int target = 0; target < NUMBER_OF_MODULATION_TARGETS; ++target)
+      mValues[static_cast<size_t>(target * mStride + tick)] = 0.0f;
+
+  for (int modulator = 0; modulator < NumModulators; ++modulator)
+  {
+    const ModulatorParameters& parameters = modulators[modulator];
+
+    if (parameters.mTarget <= MOD_NONE || parameters.mTarget >= NUMBER_OF_MODULATION_TARGETS || parameters.mDepth == 0.0)
+      continue;
+
+    const float scale = static_cast<float>(jlimit(0.0, 1.0, parameters.mDepth)) * TargetRanges[parameters.mTarget];
+    float* values = mValues.data() + parameters.mTarget * mStride;
+
+    for (int tick = 1; tick <= mNumTicks; ++tick)
+    {
+      const int tickLength = jmin(ControlInterval, numSamples - (tick - 1) * ControlInterval);
+      values[tick] += scale * Advance(modulator, parameters, tickLength / sampleRate);
+    }
+
+    mModulated[parameters.mTarget] = true;
+  }
+}
+
+// ------------------------------------------------------------------------------------
+
+float ModulationMatrix::GetValue(ModulationTarget target, int frame) const
+{
+  const float* values = GetTickValues(target);
+
+  if (!mModulated[target] || mNumTicks == 0)
+    return values[mNumTicks];
+
+  // Ramp Across the Interval Holding the Frame, Reaching its End Value on its Last Frame
+  const int tick = jlimit(0, mNumTicks - 1, frame / ControlInterval);
+  const int tickStart = tick * ControlInterval;
+  const int tickLength = jmin(ControlInterval, mNumSamples - tickStart);
+  const float fraction = static_cast<float>(frame - tickStart + 1) / static_cast<float>(tickLength);
+
+  return values[tick] + (values[tick + 1] - values[tick]) * fraction;
+}
+
+// ------------------------------------------------------------------------------------
+
+float ModulationMatrix::Advance(int modulator, const ModulatorParameters& parameters, double seconds)
+{
+  const double rate = jmax(0.0, parameters.mRate);
+  double& phase = mPhase[modulator];
+
+  switch (parameters.mShape)
+  {
+    case RANDOM_WALK:
+    {
+      // Uniform Steps of Variance rate * seconds Add up to a Unit Variance Every 1 / Rate Seconds,
+      // Reflected Back off the Ends
+      float& walk = mWalk[modulator];
+      walk += static_cast<float>((2.0 * mRandom.NextDouble() - 1.0) * std::sqrt(3.0 * rate * seconds));
+
+      if (walk > 1.0f)
+        walk = 2.0f - walk;
+      else if (walk < -1.0f)
+        walk = -2.0f - walk;
+
+      walk = jlimit(-1.0f, 1.0f, walk);
+      return walk;
+    }
+
+    case ENVELOPE_RISE:
+    case ENVELOPE_FALL:
+    {
+      // Envelopes Stop at the End of their Single Cycle
+      double& envelope = mEnvelope[modulator];
+      envelope = jmin(1.0, envelope + rate * seconds);
+      return static_cast<float>(parameters.mShape == ENVELOPE_RISE ? envelope : 1.0 - envelope);
+    }
+
+    default:
+      break;
+  }
+
+  phase += rate * seconds;
+  phase -= std::floor(phase);
+
+  switch (parameters.mShape)
+  {
+    case LFO_TRIANGLE:
+    {
+      // Starts at 0 Rising, like the Sine
+      const double shifted = phase + 0.75;
+      return static_cast<float>(4.0 * std::abs(shifted - std::floor(shifted) - 0.5) - 1.0);
+    }
+
+    case LFO_SAW:
+      return static_cast<float>(2.0 * phase - 1.0);
+
+    case LFO_SQUARE:
+      return (phase < 0.5) ? 1.0f : -1.0f;
+
+    case LFO_SINE:
+    default:
+      return static_cast<float>(std::sin(MathConstants<double>::twoPi * phase));
+  }
+}
@@ -0,0 +1,166 @@
+/*****************************************************************************/
+/*!
+\file   GrainModulation.h
+\author Anthony Brigante
+\par    email: anthonypbrigante\@gmail.com
+\par    GitHub Repository: https://github.com/abrigante1/GranularSynth
+\brief
+  Definition of the Modulation Enums, the ModulatorParameters Struct and
+  the ModulationMatrix Class, which Moves a GrainCloud's Parameters with
+  LFOs, Random Walks and Envelopes at Control Rate.
+*/
+/*****************************************************************************/
+#pragma once
+#include <JuceHeader.h>
+#include <vector>
+#include "GrainRandom.h"
+
+//! Signal a Modulator Produces
+enum ModulationShape
+{
+  LFO_SINE = 0,    //!< Bipolar Sine, Rate Cycles per Second
+  LFO_TRIANGLE,    //!< Bipolar Triangle, Rate Cycles per Second
+  LFO_SAW,         //!< Bipolar Rising Ramp, Rate Cycles per Second
+  LFO_SQUARE,      //!< Bipolar Square, Rate Cycles per Second
+  RANDOM_WALK,     //!< Bipolar Random Walk, Wandering About Full Scale Every 1 / Rate Seconds
+  ENVELOPE_RISE,   //!< Unipolar Ramp from 0 to 1 over 1 / Rate Seconds, then Held (Restarts with Each Note)
+  ENVELOPE_FALL,   //!< Unipolar Ramp from 1 to 0 over 1 / Rate Seconds, then Held (Restarts with Each Note)
+  NUMBER_OF_MODULATION_SHAPES
+};
+
+//! Parameter a Modulator Moves, with the Offset a Full Scale Modulator Adds
+enum ModulationTarget
+{
+  MOD_NONE = 0,        //!< Modulator Switched Off
+  MOD_CENTROID,        //!< Centroid Sample, by the Length of the Source
+  MOD_STARTING_OFFSET, //!< Starting Offset, by Half the Length of the Source
+  MOD_PITCH,           //!< Pitch Offset Range, by 24 Semitones
+  MOD_GRAIN_GAIN,      //!< Grain Gain Offset Range, by 24 dB
+  MOD_GLOBAL_GAIN,     //!< Global Gain, by 24 dB
+  MOD_DENSITY,         //!< Density, by 3 Octaves
+  NUMBER_OF_MODULATION_TARGETS
+};
+
+/**
+ *\struct: ModulatorParameters
+ *\author: Anthony Brigante
+ *\brief:
+    The ModulatorParameters Struct routes one modulator to a parameter.
+ */
+struct ModulatorParameters
+{
+  ModulationShape mShape = LFO_SINE;   //!< Signal the Modulator Produces
+  ModulationTarget mTarget = MOD_NONE; //!< Parameter the Modulator Moves
+  double mRate = 1.0;                  //!< Speed of the Modulator (in Hz)
+  double mDepth = 0.0;                 //!< Fraction of the Target's Full Scale Offset (0 to 1)
+};
+
+/**
+ *\class: ModulationMatrix
+ *\author: Anthony Brigante
+ *\brief:
+    The ModulationMatrix Class runs a GrainCloud's modulators once per
+    ControlInterval samples and sums them into an offset per target, in
+    the target's own units. Offsets are ramped linearly across each
+    interval, from the value at its start to the value at its end, so
+    moving a parameter costs one evaluation per interval rather than per
+    sample, and gain never steps.
+
+    Process runs the intervals of a whole block up front, so the block's
+    partitions can then read any frame's offset concurrently.
+ */
+class ModulationMatrix
+{
+public:
+
+  //! Modulators per Cloud
+  static constexpr int NumModulators = 4;
+
+  //! Samples Between Modulator Evaluations
+  static constexpr int ControlInterval = 32;
+
+  /**
+   *\fn: Prepare
+   *\brief: Allocates the Offsets of a Block and Restarts Every Modulator
+   *\param: int maxBlockSize - Largest Block Process Accepts
+   */
+  void Prepare(int maxBlockSize);
+
+  /**
+   *\fn: SetSeed
+   *\brief: Seeds the Random Walks, so a Render is Reproducible
+   *\param: uint64 seed - New Seed
+   */
+  void SetSeed(uint64 seed) { mRandom.SetSeed(seed); }
+
+  /**
+   *\fn: Restart
+   *\brief: Restarts the Envelopes (when Playback or a Note Starts)
+   */
+  void Restart();
+
+  /**
+   *\fn: Process
+   *\brief: Runs the Modulators Through a Block, One Evaluation per ControlInterval
+   *\param: const ModulatorParameters* modulators - The NumModulators Modulators
+   *\param: int numSamples - Number of Samples in the Block (at most the Prepared Size)
+   *\param: double sampleRate - Sample Rate of the Block (in Hz)
+   */
+  void Process(const ModulatorParameters* modulators, int numSamples, double sampleRate);
+
+  /**
+   *\fn: GetValue
+   *\brief: Gets the Ramped Offset of a Target at a Frame of the Last Processed Block
+   *\param: ModulationTarget target - Target
+   *\param: int frame - Frame of the Block
+   *\return: float - Offset, in the Target's Units (Fraction of the Source, Semitones, dB or Octaves)
+   */
+  float GetValue(ModulationTarget target, int frame) const;
+
+  /**
+   *\fn: GetTickValues
+   *\brief: Gets the Offsets of a Target at the Start of the Block and the End of Each Interval
+   *\param: ModulationTarget target - Target
+   *\return: const float* - GetNumTicks() + 1 Offsets
+   */
+  const float* GetTickValues(ModulationTarget target) const { return mValues.data() + target * mStride; }
+
+  /**
+   *\fn: GetNumTicks
+   *\brief: Gets the Number of Intervals in the Last Processed Block (the Last may be Short)
+   *\return: int - Number of Intervals
+   */
+  int GetNumTicks() const { return mNumTicks; }
+
+  /**
+   *\fn: IsModulated
+   *\brief: Checks if Any Modulator Moved a Target During the Last Processed Block
+   *\param: ModulationTarget target - Target
+   *\return: bool - True if the Target's Offset is not Zero Throughout
+   */
+  bool IsModulated(ModulationTarget target) const { return mModulated[target]; }
+
+private:
+
+  /**
+   *\fn: Advance
+   *\brief: Advances a Modulator by an Interval and Gets its Output at the End
+   *\param: int modulator - Index of the Modulator
+   *\param: const ModulatorParameters& parameters - Routing of the Modulator
+   *\param: double seconds - Length of the Interval
+   *\return: float - Output (-1 to 1 for LFOs and Random Walks, 0 to 1 for Envelopes)
+   */
+  float Advance(int modulator, const ModulatorParameters& parameters, double seconds);
+
+  std::vector<float> mValues;      //!< Tick Offsets of Every Target, mStride per Target
+  int mStride = 0;                 //!< Offsets per Target (Most Intervals in a Block + 1)
+  int mNumTicks = 0;               //!< Intervals in the Last Processed Block
+  int mNumSamples = 0;             //!< Samples in the Last Processed Block
+
+  bool mModulated[NUMBER_OF_MODULATION_TARGETS] = {}; //!< Targets Moved During the Last Block
+
+  double mPhase[NumModulators] = {};     //!< Position of Each LFO (in cycles)
+  double mEnvelope[NumModulators] = {};  //!< Position of Each Envelope (0 to 1)
+  float mWalk[NumModulators] = {};       //!< Position of Each Random Walk
+  GrainRandom mRandom;                   //!< Steps of the Random Walks
+};
@@ -0,0 +1,120 @@
+/*****************************************************************************/
+/*!
+\file   GrainParameters.h
+\author Anthony Brigante
+\par    email: anthonypbrigante\@gmail.com
+\par    GitHub Repository: https://github.com/abrigante1/GranularSynth
+\brief
+  Definition of the GrainParameters Struct and the GrainParameterStore Class.
+  The GrainParameterStore hands immutable snapshots of a GrainCloud's
+  parameters from the GUI thread to the audio thread without locking.
+*/
+/*****************************************************************************/
+#pragma once
+#include <atomic>
+#include "Envelope.h"
+#include "GrainInterpolation.h"
+#include "GrainModulation.h"
+#include "GrainScheduler.h"
+
+/**
+ *\struct: GrainParameters
+ *\author: Anthony Brigante
+ *\brief:
+    The GrainParameters Struct contains the user controlled parameters
+    of a GrainCloud.
+ */
+struct GrainParameters
+{
+  int mCentroidSample = 0;      //!< The Centroid Sample for a Grain Cloud (0 based)
+  int mDuration = 0;            //!< Duration (in ms) of a Grain
+  int mStartingOffset = 0;      //!< Offset of where a Grain can start from (in samples)
+  int mCloudSize = 1;           //!< Size of the Grain Cloud (Number of Grains to Play, at most when Density Driven)
+
+  GrainSchedule mSchedule = CONTINUOUS; //!< How Grains are Started
+  double mDensity = 50.0;       //!< Grains Started per Second (Synchronous and Asynchronous Schedules)
+  double mJitter = 0.0;         //!< Random Shift of Synchronous Onsets (Fraction of the Period, 0 to 1)
+
+  double mPitchOffsetMin = 0.0; //!< Minimum Pitch Offset (in semitones)
+  double mPitchOffsetMax = 0.0; //!< Maximum Pitch Offset (in semitones)
+
+  int mGainOffsetDbMin = 0;     //!< Minimum Gain Offset for an Individual Grain (in dB)
+  int mGainOffsetDbMax = 0;     //!< Maximum Gain Offset for an Individual Grain (in dB)
+
+  double mGlobalGain = 1.0;     //!< Scalar Value for the Global Gain of the Cloud (gain value)
+
+  EnvelopeShape mEnvelopeShape = HANN; //!< Window Shape of Every Grain
+  double mEnvelopeAttack = 100.0;  //!< Fade In of the Grain Window (in ms, Trapezoid/Tukey/Exponential Decay)
+  double mEnvelopeRelease = 100.0; //!< Fade Out of the Grain Window and Note-Off Release Time (in ms)
+
+  bool mRandomPanning = false;  //!< Boolean for Determining if we are Randomly Panning the Grains
+
+  InterpolationQuality mInterpolation = LINEAR; //!< How Pitched Grains Read the Source Between Samples
+
+  ModulatorParameters mModulators[ModulationMatrix::NumModulators]; //!< LFOs, Random Walks and Envelopes Moving the Parameters Above
+};
+
+/**
+ *\class: GrainParameterStore
+ *\author: Anthony Brigante
+ *\brief:
+    The GrainParameterStore is a Triple Buffer of GrainParameters.
+    A single writer (the GUI thread) edits its own copy and publishes it,
+    and a single reader (the audio thread) picks up the newest published
+    snapshot once per block. Neither side ever blocks, and the reader never
+    sees a partially written snapshot.
+ */
+class GrainParameterStore
+{
+public:
+
+  /**
+   *\fn: Edit
+   *\brief: Gets the Writer's Copy of the Parameters (Writer Thread Only)
+   *\return: GrainParameters& - Parameters to Edit Before Publishing
+   */
+  GrainParameters& Edit() { return mPending; }
+
+  /**
+   *\fn: Publish
+   *\brief: Publishes the Writer's Copy of the Parameters (Writer Thread Only)
+   */
+  void Publish()
+  {
+    mBuffers[mWriteIndex] = mPending;
+    mWriteIndex = mBackIndex.exchange(mWriteIndex | NewDataFlag, std::memory_order_acq_rel) & IndexMask;
+  }
+
+  /**
+   *\fn: Update
+   *\brief: Picks up the Newest Published Snapshot, if any (Reader Thread Only)
+   *\return: bool - True if a New Snapshot was Picked Up
+   */
+  bool Update()
+  {
+    if ((mBackIndex.load(std::memory_order_relaxed) & NewDataFlag) == 0)
+      return false;
+
+    mReadIndex = mBackIndex.exchange(mReadIndex, std::memory_order_acq_rel) & IndexMask;
+    return true;
+  }
+
+  /**
+   *\fn: Read
+   *\brief: Gets the Current Snapshot (Reader Thread Only)
+   *\return: const GrainParameters& - The Snapshot Picked up by the Last Update
+   */
+  const GrainParameters& Read() const { return mBuffers[mReadIndex]; }
+
+private:
+
+  static constexpr int IndexMask = 0x3;   //!< Mask for the Buffer Index in mBackIndex
+  static constexpr int NewDataFlag = 0x4; //!< Flag Set in mBackIndex when it Holds Unread Data
+
+  GrainParameters mBuffers[3];    //!< The Three Snapshot Buffers
+  GrainParameters mPending;       //!< Writer's Working Copy
+
+  int mWriteIndex = 0;            //!< Buffer Owned by the Writer
+  int mReadIndex = 1;             //!< Buffer Owned by the Reader
+  std::atomic<int> mBackIndex{ 2 }; //!< Buffer Exchanged Between the Writer and Reader
+};
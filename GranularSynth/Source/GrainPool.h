@@ -0,0 +1,179 @@
+/*****************************************************************************/
+/*!
+\file   GrainPool.h
+\author Anthony Brigante
+\par    email: anthonypbrigante\@gmail.com
+\par    GitHub Repository: https://github.com/abrigante1/GranularSynth
+\brief
+  Definition of the GrainPool Struct.
+  The GrainPool stores the per-grain playback state of a GrainCloud as a
+  Structure of Arrays, so the mixing kernel only touches the fields it needs.
+*/
+/*****************************************************************************/
+#pragma once
+#include <vector>
+#include <limits>
+
+/**
+ *\struct: GrainPool
+ *\author: Anthony Brigante
+ *\brief:
+    The GrainPool Struct stores every grain of a cloud as separate contiguous
+    arrays (one element per grain). All of the storage is allocated up front
+    by Allocate, after which grains are activated and deactivated without
+    allocating.
+
+    Active grains are kept packed at the front of the arrays, so the active
+    list is the range [0, mNumGrains) and the mixing kernel runs in O(active)
+    over contiguous memory. The range is padded to a multiple of
+    GrainPool::LaneWidth so the kernel can always process full lanes;
+    inactive lanes are silent and never finish.
+ */
+struct GrainPool
+{
+  //! Number of Grains the Mixing Kernel Processes per Instruction
+  static constexpr int LaneWidth = 4;
+
+  std::vector<double> mPosition;         //!< Current Read Position in the Audio Source (in samples)
+  std::vector<double> mIncrement;        //!< Read Position Increment per Frame (Pitch Scalar)
+
+  std::vector<float> mGainLeft;          //!< Grain Gain with the Left Pan Applied (gain value)
+  std::vector<float> mGainRight;         //!< Grain Gain with the Right Pan Applied (gain value)
+
+  std::vector<float> mEnvelopePosition;  //!< Frames Elapsed Since the Grain Started (Negative Until its Onset)
+  std::vector<float> mEnvelopeScale;     //!< Envelope Table Entries per Frame (Table Size - 1 / Window Length)
+  std::vector<float> mReleaseStart;      //!< Envelope Position where the Note-Off Release Begins (never, until Released)
+  std::vector<float> mLifetime;          //!< Envelope Position where the Grain Finishes
+
+  std::vector<int> mStartingSample;      //!< Starting Sample of the Grain in the Audio Source
+
+  int mNumGrains = 0;                    //!< Number of Active Grains in the Pool (excluding padding)
+  int mCapacity = 0;                     //!< Maximum Number of Grains the Pool can Hold
+
+  /**
+   *\fn: GetNumLanes
+   *\brief: Gets the Number of Grains Rounded up to a Multiple of the Lane Width
+   *\return: int - Number of Lanes the Mixing Kernel Processes
+   */
+  int GetNumLanes() const
+  {
+    return (mNumGrains + LaneWidth - 1) & ~(LaneWidth - 1);
+  }
+
+  /**
+   *\fn: Allocate
+   *\brief: Allocates Storage for a Number of Grains and Deactivates Every Grain.
+            This is the Only Function that Allocates, Call it Before Playback.
+   *\param: int capacity - Maximum Number of Grains (rounded up to the Lane Width)
+   */
+  void Allocate(int capacity)
+  {
+    mCapacity = (capacity + LaneWidth - 1) & ~(LaneWidth - 1);
+    mNumGrains = 0;
+
+    const size_t numLanes = static_cast<size_t>(mCapacity);
+
+    mPosition.resize(numLanes);
+    mIncrement.resize(numLanes);
+    mGainLeft.resize(numLanes);
+    mGainRight.resize(numLanes);
+    mEnvelopePosition.resize(numLanes);
+    mEnvelopeScale.resize(numLanes);
+    mReleaseStart.resize(numLanes);
+    mLifetime.resize(numLanes);
+    mStartingSample.resize(numLanes);
+
+    for (int i = 0; i < mCapacity; ++i)
+      ClearLane(i);
+  }
+
+  /**
+   *\fn: ActivateGrain
+   *\brief: Activates a Silent Grain at the End of the Active Range
+   *\return: int - Index of the New Grain, or -1 if the Pool is Full
+   */
+  int ActivateGrain()
+  {
+    if (mNumGrains >= mCapacity)
+      return -1;
+
+    return mNumGrains++;
+  }
+
+  /**
+   *\fn: DeactivateGrain
+   *\brief: Deactivates a Grain, Moving the Last Active Grain into its Place
+   *\param: int grain - Index of the Grain to Deactivate
+   */
+  void DeactivateGrain(int grain)
+  {
+    const int lastGrain = --mNumGrains;
+
+    if (grain != lastGrain)
+      CopyGrain(grain, lastGrain);
+
+    ClearLane(lastGrain);
+  }
+
+  /**
+   *\fn: ClearLane
+   *\brief: Makes a Lane Silent and Prevents it from Ever Finishing
+   *\param: int lane - Index of the Lane to Clear
+   */
+  void ClearLane(int lane)
+  {
+    const size_t i = static_cast<size_t>(lane);
+
+    mPosition[i] = 0.0;
+    mIncrement[i] = 0.0;
+    mGainLeft[i] = 0.0f;
+    mGainRight[i] = 0.0f;
+    mEnvelopePosition[i] = 0.0f;
+    mEnvelopeScale[i] = 0.0f;
+    mReleaseStart[i] = std::numeric_limits<float>::max();
+    mLifetime[i] = std::numeric_limits<float>::max();
+    mStartingSample[i] = 0;
+  }
+
+  /**
+   *\fn: CopyGrain
+   *\brief: Copies the State of One Grain into Another
+   *\param: int destination - Grain to Copy Into
+   *\param: int source - Grain to Copy From
+   */
+  void CopyGrain(int destination, int source)
+  {
+    const size_t d = static_cast<size_t>(destination);
+    const size_t s = static_cast<size_t>(source);
+
+    mPosition[d] = mPosition[s];
+    mIncrement[d] = mIncrement[s];
+    mGainLeft[d] = mGainLeft[s];
+    mGainRight[d] = mGainRight[s];
+    mEnvelopePosition[d] = mEnvelopePosition[s];
+    mEnvelopeScale[d] = mEnvelopeScale[s];
+    mReleaseStart[d] = mReleaseStart[s];
+    mLifetime[d] = mLifetime[s];
+    mStartingSample[d] = mStartingSample[s];
+  }
+
+  /**
+   *\fn: CopyTiming
+   *\brief: Copies where One Grain Reads and where its Envelope is into Another,
+            Leaving the Pitch, Gain and Pan of the Destination Alone
+   *\param: int destination - Grain to Copy Into
+   *\param: int source - Grain to Copy From
+   */
+  void CopyTiming(int destination, int source)
+  {
+    const size_t d = static_cast<size_t>(destination);
+    const size_t s = static_cast<size_t>(source);
+
+    mPosition[d] = mPosition[s];
+    mStartingSample[d] = mStartingSample[s];
+    mEnvelopePosition[d] = mEnvelopePosition[s];
+    mEnvelopeScale[d] = mEnvelopeScale[s];
+    mReleaseStart[d] = mReleaseStart[s];
+    mLifetime[d] = mLifetime[s];
+  }
+};
@@ -0,0 +1,130 @@
+/*****************************************************************************/
+/*!
+\file   GrainRandom.h
+\author Anthony Brigante
+\par    email: anthonypbrigante\@gmail.com
+\par    GitHub Repository: https://github.com/abrigante1/GranularSynth
+\brief
+  Definition of the GrainRandom Class, the Random Number Generator used
+  to spawn grains. It is a xoshiro256** generator: 32 bytes of state, no
+  locks, no allocation and no system calls, so it is safe to use on the
+  audio thread, and a given seed always produces the same sequence.
+*/
+/*****************************************************************************/
+#pragma once
+#include <cstdint>
+
+/**
+ *\class: GrainRandom
+ *\author: Anthony Brigante
+ *\brief:
+    The GrainRandom Class is a small-state, seedable pseudo random number
+    generator (xoshiro256**, by Blackman and Vigna). Each GrainCloud owns
+    one, so seeded clouds render reproducibly regardless of what other
+    clouds are doing.
+ */
+class GrainRandom
+{
+public:
+
+  /**
+   *\fn: GrainRandom
+   *\brief: Constructor for a GrainRandom
+   *\param: uint64_t seed - Initial Seed
+   */
+  explicit GrainRandom(uint64_t seed = 1) { SetSeed(seed); }
+
+  /**
+   *\fn: SetSeed
+   *\brief: Restarts the Sequence from a Seed (any value, including 0, is valid)
+   *\param: uint64_t seed - New Seed
+   */
+  void SetSeed(uint64_t seed)
+  {
+    // Expand the Seed into the Four State Words with SplitMix64
+    for (uint64_t& word : mState)
+    {
+      seed += 0x9e3779b97f4a7c15ull;
+
+      uint64_t z = seed;
+      z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ull;
+      z = (z ^ (z >> 27)) * 0x94d049bb133111ebull;
+      word = z ^ (z >> 31);
+    }
+  }
+
+  /**
+   *\fn: NextUInt64
+   *\brief: Gets the Next 64 Random Bits
+   *\return: uint64_t - Uniformly Distributed Bits
+   */
+  uint64_t NextUInt64()
+  {
+    const uint64_t result = RotateLeft(mState[1] * 5, 7) * 9;
+    const uint64_t shifted = mState[1] << 17;
+
+    mState[2] ^= mState[0];
+    mState[3] ^= mState[1];
+    mState[1] ^= mState[2];
+    mState[0] ^= mState[3];
+    mState[2] ^= shifted;
+    mState[3] = RotateLeft(mState[3], 45);
+
+    return result;
+  }
+
+  /**
+   *\fn: NextDouble
+   *\brief: Gets a Uniformly Distributed Double
+   *\return: double - Value in [0, 1)
+   */
+  double NextDouble()
+  {
+    return static_cast<double>(NextUInt64() >> 11) * (1.0 / 9007199254740992.0);
+  }
+
+  /**
+   *\fn: NextFloat
+   *\brief: Gets a Uniformly Distributed Float
+   *\return: float - Value in [0, 1)
+   */
+  float NextFloat()
+  {
+    return static_cast<float>(NextUInt64() >> 40) * (1.0f / 16777216.0f);
+  }
+
+  /**
+   *\fn: NextInt
+   *\brief: Gets a Uniformly Distributed Integer in a Range
+   *\param: int start - Lowest Value that can be Returned
+   *\param: int end - One Past the Highest Value that can be Returned
+   *\return: int - Value in [start, end), or start if the Range is Empty
+   */
+  int NextInt(int start, int end)
+  {
+    if (end <= start)
+      return start;
+
+    // Multiply-Shift Maps 32 Random Bits onto the Range Without a Division
+    const uint64_t range = static_cast<uint64_t>(static_cast<int64_t>(end) - start);
+    const uint64_t offset = ((NextUInt64() >> 32) * range) >> 32;
+
+    return static_cast<int>(start + static_cast<int64_t>(offset));
+  }
+
+private:
+
+  /**
+   *\fn: RotateLeft
+   *\brief: Rotates the Bits of a Word Left
+   *\param: uint64_t value - Word to Rotate
+   *\param: int bits - Number of Bits to Rotate By (1 to 63)
+   *\return: uint64_t - The Rotated Word
+   */
+  static uint64_t RotateLeft(uint64_t value, int bits)
+  {
+    return (value << bits) | (value >> (64 - bits));
+  }
+
+  uint64_t mState[4]; //!< Generator State (Never all Zero)
+};
@@ -0,0 +1,98 @@
+/*****************************************************************************/
+/*!
+\file   GrainScheduler.cpp
+\author Anthony Brigante
+\par    email: anthonypbrigante\@gmail.com
+\par    GitHub Repository: https://github.com/abrigante1/GranularSynth
+\brief
+  Implementation of the GrainScheduler Class.
+*/
+/*****************************************************************************/
+
+#include "GrainScheduler.h"
+#include <algorithm>
+#include <cmath>
+#include <functional>
+
+// ------------------------------------------------------------------------------------
+// ------------------------------------------------------------------------------------
+// ------------------------------------------------------------------------------------
+
+void GrainScheduler::Prepare(int capacity)
+{
+  mHeap.resize(static_cast<size_t>(jmax(1, capacity)));
+  Reset(0);
+}
+
+// ------------------------------------------------------------------------------------
+
+void GrainScheduler::Reset(int64 now)
+{
+  mNumPending = 0;
+  mNextOnset = static_cast<double>(now);
+  mPeriod = 0.0;
+}
+
+// ------------------------------------------------------------------------------------
+
+void GrainScheduler::Generate(GrainSchedule schedule, double period, double jitter, int64 now, int64 end,
+                              GrainRandom& random)
+{
+  period = jmax(1.0, period);
+
+  // Wait Out the Rest of the Pending Gap at the New Period, Rather than the One it was Drawn With
+  const double time = static_cast<double>(now);
+
+  if (mPeriod > 0.0 && period != mPeriod && mNextOnset > time)
+    mNextOnset = time + (mNextOnset - time) * period / mPeriod;
+
+  mPeriod = period;
+
+  if (schedule == SYNCHRONOUS)
+  {
+    // Jittered Onsets Move up to a Period Either Way (Overtaking their Neighbours), so Look that Far Ahead
+    jitter = jlimit(0.0, 1.0, jitter) * period;
+    const double horizon = static_cast<double>(end) + jitter;
+
+    while (mNextOnset < horizon)
+    {
+      const double shift = (jitter > 0.0) ? (2.0 * random.NextDouble() - 1.0) * jitter : 0.0;
+      Push(static_cast<int64>(std::floor(mNextOnset + shift)));
+      mNextOnset += period;
+    }
+  }
+  else
+  {
+    // Exponentially Distributed Gaps make a Poisson Process
+    while (mNextOnset < static_cast<double>(end))
+    {
+      Push(static_cast<int64>(std::floor(mNextOnset)));
+      mNextOnset += -std::log(1.0 - random.NextDouble()) * period;
+    }
+  }
+}
+
+// ------------------------------------------------------------------------------------
+
+bool GrainScheduler::Push(int64 onset)
+{
+  if (mNumPending >= static_cast<int>(mHeap.size()))
+    return false;
+
+  mHeap[static_cast<size_t>(mNumPending++)] = onset;
+  std::push_heap(mHeap.begin(), mHeap.begin() + mNumPending, std::greater<int64>());
+  return true;
+}
+
+// ------------------------------------------------------------------------------------
+
+bool GrainScheduler::PopDue(int64 end, int64& onset)
+{
+  if (mNumPending == 0 || mHeap[0] >= end)
+    return false;
+
+  onset = mHeap[0];
+  std::pop_heap(mHeap.begin(), mHeap.begin() + mNumPending, std::greater<int64>());
+  --mNumPending;
+  return true;
+}
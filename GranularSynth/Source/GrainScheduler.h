@@ -0,0 +1,107 @@
+/*****************************************************************************/
+/*!
+\file   GrainScheduler.h
+\author Anthony Brigante
+\par    email: anthonypbrigante\@gmail.com
+\par    GitHub Repository: https://github.com/abrigante1/GranularSynth
+\brief
+  Definition of the GrainSchedule Enum and the GrainScheduler Class.
+  The GrainScheduler decides when a density driven GrainCloud starts each
+  of its grains, to the sample.
+*/
+/*****************************************************************************/
+#pragma once
+#include <JuceHeader.h>
+#include <vector>
+#include "GrainRandom.h"
+
+//! How a GrainCloud Starts its Grains
+enum GrainSchedule
+{
+  CONTINUOUS = 0,  //!< Cloud Size Grains, Each Restarted as Soon as it Finishes
+  SYNCHRONOUS,     //!< Grains Start Periodically at the Density (Optionally Jittered)
+  ASYNCHRONOUS,    //!< Grains Start at Random (Poisson) Times, Averaging the Density
+  NUMBER_OF_GRAIN_SCHEDULES
+};
+
+/**
+ *\class: GrainScheduler
+ *\author: Anthony Brigante
+ *\brief:
+    The GrainScheduler Class generates grain onsets (in samples, on the
+    cloud's own clock) and keeps the pending ones in a time-ordered queue,
+    a binary min-heap. Jittered onsets can land out of order, and the
+    queue hands them back in time order regardless.
+
+    Onsets are only generated up to the end of the block being rendered,
+    so the queue never holds more than a block's worth of onsets. All of
+    the storage is allocated by Prepare.
+
+    The next onset is drawn with the period in force when the one before
+    it was queued, so when the period changes the wait still ahead of it
+    is scaled by the new period over the old. A density raised from 1 gr/s
+    then takes effect at once, rather than after the second already drawn
+    (for the Poisson process this is exact, as its gaps are memoryless).
+ */
+class GrainScheduler
+{
+public:
+
+  /**
+   *\fn: Prepare
+   *\brief: Allocates the Queue and Clears it. Call Before Playback.
+   *\param: int capacity - Maximum Number of Pending Onsets (Later Onsets are Dropped)
+   */
+  void Prepare(int capacity);
+
+  /**
+   *\fn: Reset
+   *\brief: Clears the Queue and Restarts Generating Onsets from a Time
+   *\param: int64 now - Time of the First Onset (in samples)
+   */
+  void Reset(int64 now);
+
+  /**
+   *\fn: Generate
+   *\brief: Queues Every Onset Due Before a Time
+   *\param: GrainSchedule schedule - SYNCHRONOUS or ASYNCHRONOUS
+   *\param: double period - Mean Time Between Onsets (in samples)
+   *\param: double jitter - Largest Random Shift of Synchronous Onsets, Either Way (as a Fraction of the Period, 0 to 1)
+   *\param: int64 now - Time the Period Takes Effect From (in samples)
+   *\param: int64 end - Time up to which Onsets are Generated (in samples)
+   *\param: GrainRandom& random - Random Number Generator of the Cloud
+   */
+  void Generate(GrainSchedule schedule, double period, double jitter, int64 now, int64 end, GrainRandom& random);
+
+  /**
+   *\fn: Push
+   *\brief: Queues an Onset
+   *\param: int64 onset - Time of the Onset (in samples)
+   *\return: bool - False if the Queue was Full and the Onset was Dropped
+   */
+  bool Push(int64 onset);
+
+  /**
+   *\fn: PopDue
+   *\brief: Takes the Earliest Onset if it is Due Before a Time
+   *\param: int64 end - Time the Onset must be Due Before (in samples)
+   *\param: int64& onset - Receives the Onset
+   *\return: bool - True if an Onset was Taken
+   */
+  bool PopDue(int64 end, int64& onset);
+
+  /**
+   *\fn: GetNumPending
+   *\brief: Gets the Number of Onsets in the Queue
+   *\return: int - Number of Pending Onsets
+   */
+  int GetNumPending() const { return mNumPending; }
+
+private:
+
+  std::vector<int64> mHeap;   //!< Pending Onsets, a Min-Heap in [0, mNumPending)
+  int mNumPending = 0;        //!< Number of Pending Onsets
+
+  double mNextOnset = 0.0;    //!< Time of the Next Onset to Generate, Before Jitter (in samples)
+  double mPeriod = 0.0;       //!< Period the Next Onset was Drawn With (0 Until the First is Drawn)
+};
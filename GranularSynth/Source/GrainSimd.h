@@ -0,0 +1,20 @@
+/*****************************************************************************/
+/*!
+\file   GrainSimd.h
+\author Anthony Brigante
+\par    email: anthonypbrigante\@gmail.com
+\par    GitHub Repository: https://github.com/abrigante1/GranularSynth
+\brief
+  Detects the SIMD Instruction Sets the Grain Kernels can Use.
+  GRAIN_KERNEL_USE_SSE2 is 1 when SSE2 is available (every x64 target),
+  otherwise the kernels fall back to scalar code.
+*/
+/*****************************************************************************/
+#pragma once
+
+#if defined(__SSE2__) || defined(_M_X64) || defined(_M_AMD64) || (defined(_M_IX86_FP) && (_M_IX86_FP >= 2))
+  #define GRAIN_KERNEL_USE_SSE2 1
+  #include <emmintrin.h>
+#else
+  #define GRAIN_KERNEL_USE_SSE2 0
+#endif
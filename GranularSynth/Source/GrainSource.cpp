@@ -0,0 +1,213 @@
+/*****************************************************************************/
+/*!
+\file   GrainSource.cpp
+\author Anthony Brigante
+\par    email: anthonypbrigante\@gmail.com
+\par    GitHub Repository: https://github.com/abrigante1/GranularSynth
+\brief
+  Implementation of the SourceAudio Class.
+*/
+/*****************************************************************************/
+
+#include "GrainSource.h"
+#include "PolyphaseResampler.h"
+
+namespace
+{
+  /**
+   *\struct: MappedReaderAccess
+   *\brief: Exposes the Address of a Mapped Sample, which JUCE Keeps Protected.
+            Never Instantiated, Only Used to Name the Protected Member.
+   */
+  struct MappedReaderAccess : public MemoryMappedAudioFormatReader
+  {
+    static const char* GetSamplePointer(const MemoryMappedAudioFormatReader& reader, int64 sample)
+    {
+      return static_cast<const char*>((reader.*(&MappedReaderAccess::sampleToPointer))(sample));
+    }
+  };
+
+  /**
+   *\fn: ReadChannel
+   *\brief: Converts One Channel of a GrainSource to Floats
+   *\tparam: SampleReader - Reader for the Sample Format of the Source (see SourceReaders)
+   *\param: const char* channel - First Sample of the Channel
+   *\param: int stride - Bytes Between Consecutive Samples of the Channel
+   *\param: int64 length - Number of Samples to Convert
+   *\param: float* destination - Receives the Samples
+   */
+  template <typename SampleReader>
+  void ReadChannel(const char* channel, int stride, int64 length, float* destination)
+  {
+    for (int64 i = 0; i < length; ++i)
+      destination[i] = SampleReader::Read(channel + i * stride);
+  }
+}
+
+// ------------------------------------------------------------------------------------
+// ------------------------------------------------------------------------------------
+// ------------------------------------------------------------------------------------
+
+std::unique_ptr<SourceAudio> SourceAudio::Decode(AudioFormatReader& reader)
+{
+  std::unique_ptr<SourceAudio> audio(new SourceAudio());
+
+  audio->mSampleRate = reader.sampleRate;
+  audio->mNumChannels = static_cast<int>(reader.numChannels);
+
+  const int numChannels = (reader.numChannels >= 2) ? 2 : 1;
+  const int length = static_cast<int>(reader.lengthInSamples);
+
+  if (reader.numChannels == 0 || length <= 0)
+    return audio;
+
+  // Decode Straight Between the Guards (Only the First Two Channels are Played)
+  audio->mBuffer.Allocate(numChannels, length);
+
+  float* channels[] = { audio->mBuffer.GetWritePointer(0), audio->mBuffer.GetWritePointer(1) };
+  AudioBuffer<float> destination(channels, numChannels, length);
+  reader.read(&destination, 0, length, 0, true, numChannels >= 2);
+
+  audio->ViewBuffer();
+  return audio;
+}
+
+// ------------------------------------------------------------------------------------
+
+std::unique_ptr<SourceAudio> SourceAudio::Copy(const AudioBuffer<float>& buffer, double sampleRate)
+{
+  std::unique_ptr<SourceAudio> audio(new SourceAudio());
+
+  audio->mSampleRate = sampleRate;
+  audio->mNumChannels = buffer.getNumChannels();
+
+  if (buffer.getNumChannels() == 0 || buffer.getNumSamples() == 0)
+    return audio;
+
+  const int numChannels = (buffer.getNumChannels() >= 2) ? 2 : 1;
+  audio->mBuffer.Allocate(numChannels, buffer.getNumSamples());
+
+  for (int channel = 0; channel < numChannels; ++channel)
+    FloatVectorOperations::copy(audio->mBuffer.GetWritePointer(channel), buffer.getReadPointer(channel), buffer.getNumSamples());
+
+  audio->ViewBuffer();
+  return audio;
+}
+
+// ------------------------------------------------------------------------------------
+
+std::unique_ptr<SourceAudio> SourceAudio::Map(const File& file, String& error)
+{
+  std::unique_ptr<MemoryMappedAudioFormatReader> reader(WavAudioFormat().createMemoryMappedReader(file));
+
+  if (reader == nullptr || reader->lengthInSamples <= 0 || reader->numChannels == 0)
+  {
+    error = "Not a WAV file: " + file.getFullPathName();
+    return nullptr;
+  }
+
+  // Only Formats the Kernel can Read Directly
+  SourceSampleFormat format;
+
+  if (reader->usesFloatingPointData && reader->bitsPerSample == 32)
+    format = FLOAT_32;
+  else if (!reader->usesFloatingPointData && reader->bitsPerSample == 16)
+    format = INT_16;
+  else if (!reader->usesFloatingPointData && reader->bitsPerSample == 24)
+    format = INT_24;
+  else if (!reader->usesFloatingPointData && reader->bitsPerSample == 32)
+    format = INT_32;
+  else
+  {
+    error = String(static_cast<int>(reader->bitsPerSample)) + " bit WAV files can not be memory mapped: " + file.getFullPathName();
+    return nullptr;
+  }
+
+  // Map the Address Space Only, Pages are Read in as Grains Touch Them
+  if (!reader->mapEntireFile())
+  {
+    error = "Unable to memory map " + file.getFullPathName();
+    return nullptr;
+  }
+
+  std::unique_ptr<SourceAudio> audio(new SourceAudio());
+
+  const int bytesPerSample = static_cast<int>(reader->bitsPerSample / 8);
+  const char* firstFrame = MappedReaderAccess::GetSamplePointer(*reader, 0);
+
+  audio->mSampleRate = reader->sampleRate;
+  audio->mNumChannels = static_cast<int>(reader->numChannels);
+
+  // WAV Data is Interleaved, so the Channels are Offset within Each Frame
+  audio->mSource.mLeft = firstFrame;
+  audio->mSource.mRight = firstFrame + ((reader->numChannels >= 2) ? bytesPerSample : 0);
+  audio->mSource.mFrameStride = bytesPerSample * static_cast<int>(reader->numChannels);
+  audio->mSource.mFormat = format;
+  audio->mSource.mLength = reader->lengthInSamples;
+
+  audio->mMappedReader = std::move(reader);
+  return audio;
+}
+
+// ------------------------------------------------------------------------------------
+
+std::unique_ptr<SourceAudio> SourceAudio::Resample(const SourceAudio& audio, double sampleRate)
+{
+  const PolyphaseResampler resampler(audio.mSampleRate, sampleRate);
+  const GrainSource& source = audio.mSource;
+
+  const int padding = resampler.GetPadding();
+  const int numChannels = (audio.mNumChannels >= 2) ? 2 : 1;
+  const int64 outputLength = resampler.GetOutputLength(source.mLength);
+
+  std::unique_ptr<SourceAudio> resampled(new SourceAudio());
+
+  resampled->mSampleRate = sampleRate;
+  resampled->mNumChannels = numChannels;
+
+  if (!source.IsValid())
+    return resampled;
+
+  resampled->mBuffer.Allocate(numChannels, outputLength);
+
+  // One Channel at a Time, Converted to Floats Between the Zero Padding the Resampler Reads
+  std::vector<float> input(static_cast<size_t>(source.mLength + 2 * padding), 0.0f);
+  float* samples = input.data() + padding;
+
+  for (int channel = 0; channel < numChannels; ++channel)
+  {
+    const char* first = (channel == 0) ? source.mLeft : source.mRight;
+
+    switch (source.mFormat)
+    {
+      case INT_16: ReadChannel<SourceReaders::Int16>(first, source.mFrameStride, source.mLength, samples);   break;
+      case INT_24: ReadChannel<SourceReaders::Int24>(first, source.mFrameStride, source.mLength, samples);   break;
+      case INT_32: ReadChannel<SourceReaders::Int32>(first, source.mFrameStride, source.mLength, samples);   break;
+      case FLOAT_32_GUARDED: ReadChannel<SourceReaders::GuardedFloat32>(first, source.mFrameStride, source.mLength, samples); break;
+      case FLOAT_32:
+      default:     ReadChannel<SourceReaders::Float32>(first, source.mFrameStride, source.mLength, samples); break;
+    }
+
+    resampler.Process(samples, source.mLength, resampled->mBuffer.GetWritePointer(channel));
+  }
+
+  resampled->ViewBuffer();
+  return resampled;
+}
+
+// ------------------------------------------------------------------------------------
+
+void SourceAudio::ViewBuffer()
+{
+  mSource = GrainSource();
+
+  if (mBuffer.GetNumChannels() == 0 || mBuffer.GetLength() == 0)
+    return;
+
+  // Mono Buffers Already Return their One Channel for Both Output Channels
+  mSource.mLeft = reinterpret_cast<const char*>(mBuffer.GetReadPointer(0));
+  mSource.mRight = reinterpret_cast<const char*>(mBuffer.GetReadPointer(1));
+  mSource.mFrameStride = static_cast<int>(sizeof(float));
+  mSource.mFormat = FLOAT_32_GUARDED;
+  mSource.mLength = mBuffer.GetLength();
+}
@@ -0,0 +1,219 @@
+/*****************************************************************************/
+/*!
+\file   GrainSource.h
+\author Anthony Brigante
+\par    email: anthonypbrigante\@gmail.com
+\par    GitHub Repository: https://github.com/abrigante1/GranularSynth
+\brief
+  Definition of the GrainSource Struct and the SourceAudio Class.
+  A SourceAudio owns the audio a GrainCloud granulates, either decoded into
+  memory or memory mapped straight from an uncompressed WAV file, and the
+  GrainSource is the view of it the mixing kernel reads from.
+*/
+/*****************************************************************************/
+#pragma once
+#include <JuceHeader.h>
+#include <cstring>
+#include "SourceBuffer.h"
+
+//! Sample Format of a GrainSource (Mapped WAV Data is Read in its File Format)
+enum SourceSampleFormat
+{
+  FLOAT_32 = 0,
+  INT_16,
+  INT_24,
+  INT_32,
+  FLOAT_32_GUARDED,
+  NUMBER_OF_SOURCE_FORMATS
+};
+
+/**
+ *\brief:
+    Sample Readers, One per SourceSampleFormat. The Mixing Kernel is
+    Instantiated per Reader, so the Conversion to Float is Inlined into
+    the Inner Loop Instead of Switching per Sample. Mapped Samples are
+    Little Endian, as Stored in WAV Files. Only Guarded Sources (a
+    SourceBuffer) may be Read Past their Ends, the Others are Clamped.
+ */
+namespace SourceReaders
+{
+  struct GuardedFloat32
+  {
+    static constexpr bool IsGuarded = true;
+
+    static float Read(const char* sample)
+    {
+      return *reinterpret_cast<const float*>(sample);
+    }
+  };
+
+  struct Float32
+  {
+    static constexpr bool IsGuarded = false;
+
+    static float Read(const char* sample)
+    {
+      const uint32 bits = ByteOrder::littleEndianInt(sample);
+      float value;
+      std::memcpy(&value, &bits, sizeof(value));
+      return value;
+    }
+  };
+
+  struct Int16
+  {
+    static constexpr bool IsGuarded = false;
+
+    static float Read(const char* sample)
+    {
+      return static_cast<float>(static_cast<int16>(ByteOrder::littleEndianShort(sample))) * (1.0f / 32768.0f);
+    }
+  };
+
+  struct Int24
+  {
+    static constexpr bool IsGuarded = false;
+
+    static float Read(const char* sample)
+    {
+      return static_cast<float>(ByteOrder::littleEndian24Bit(sample)) * (1.0f / 8388608.0f);
+    }
+  };
+
+  struct Int32
+  {
+    static constexpr bool IsGuarded = false;
+
+    static float Read(const char* sample)
+    {
+      return static_cast<float>(static_cast<int32>(ByteOrder::littleEndianInt(sample))) * (1.0f / 2147483648.0f);
+    }
+  };
+}
+
+/**
+ *\struct: GrainSource
+ *\author: Anthony Brigante
+ *\brief:
+    The GrainSource Struct is a non-owning view of a SourceAudio. Sample i
+    of a channel is at (channel pointer + i * mFrameStride), in mFormat.
+    Mono sources point both channels at the same samples. FLOAT_32_GUARDED
+    sources have SourceBuffer::GuardSamples silent samples past both ends.
+ */
+struct GrainSource
+{
+  const char* mLeft = nullptr;            //!< First Sample of the Left Channel
+  const char* mRight = nullptr;           //!< First Sample of the Right Channel
+  int mFrameStride = 0;                   //!< Bytes Between Consecutive Samples of a Channel
+  SourceSampleFormat mFormat = FLOAT_32;  //!< Format of the Samples
+  int64 mLength = 0;                      //!< Number of Samples per Channel
+
+  /**
+   *\fn: IsValid
+   *\brief: Checks if the View Refers to Any Samples
+   *\return: bool - True if there are Samples to Read
+   */
+  bool IsValid() const { return mLeft != nullptr && mLength > 0; }
+};
+
+/**
+ *\class: SourceAudio
+ *\author: Anthony Brigante
+ *\brief:
+    The SourceAudio Class owns the audio of a GrainCloud. Decoded sources
+    cost 4 bytes per sample up front and are held in a guarded SourceBuffer,
+    while memory mapped WAV files open in constant time and only the pages
+    grains actually read are ever loaded.
+ */
+class SourceAudio
+{
+public:
+
+  /**
+   *\fn: Decode
+   *\brief: Decodes a Whole File into Memory
+   *\param: AudioFormatReader& reader - Reader of the File to Decode
+   *\return: std::unique_ptr<SourceAudio> - The Decoded Audio
+   */
+  static std::unique_ptr<SourceAudio> Decode(AudioFormatReader& reader);
+
+  /**
+   *\fn: Copy
+   *\brief: Copies Audio that is Already in Memory
+   *\param: const AudioBuffer<float>& audio - Audio to Copy
+   *\param: double sampleRate - Sample Rate of the Audio
+   *\return: std::unique_ptr<SourceAudio> - The Copied Audio
+   */
+  static std::unique_ptr<SourceAudio> Copy(const AudioBuffer<float>& audio, double sampleRate);
+
+  /**
+   *\fn: Map
+   *\brief: Memory Maps an Uncompressed WAV File (16, 24 or 32 bit PCM, or 32 bit float)
+   *\param: const File& file - WAV File to Map
+   *\param: String& error - Receives the Reason if the File can not be Mapped
+   *\return: std::unique_ptr<SourceAudio> - The Mapped Audio, or nullptr on Failure
+   */
+  static std::unique_ptr<SourceAudio> Map(const File& file, String& error);
+
+  /**
+   *\fn: Resample
+   *\brief: Converts Audio to Another Sample Rate (see PolyphaseResampler). Slow for Long
+            Sources, so Call Once, Off the Audio Thread. The Result is Always in Memory.
+   *\param: const SourceAudio& audio - Audio to Convert (Decoded or Mapped)
+   *\param: double sampleRate - Sample Rate to Convert to
+   *\return: std::unique_ptr<SourceAudio> - The Converted Audio
+   */
+  static std::unique_ptr<SourceAudio> Resample(const SourceAudio& audio, double sampleRate);
+
+  /**
+   *\fn: GetSource
+   *\brief: Gets the View of the Samples Read by the Mixing Kernel
+   *\return: const GrainSource& - View of the Samples
+   */
+  const GrainSource& GetSource() const { return mSource; }
+
+  /**
+   *\fn: GetSampleRate
+   *\brief: Gets the Sample Rate of the Audio
+   *\return: double - Sample Rate (in Hz)
+   */
+  double GetSampleRate() const { return mSampleRate; }
+
+  /**
+   *\fn: GetLength
+   *\brief: Gets the Length of the Audio
+   *\return: int64 - Number of Samples per Channel
+   */
+  int64 GetLength() const { return mSource.mLength; }
+
+  /**
+   *\fn: GetNumChannels
+   *\brief: Gets the Number of Channels in the Audio
+   *\return: int - Number of Channels (Only the First Two are Played)
+   */
+  int GetNumChannels() const { return mNumChannels; }
+
+  /**
+   *\fn: IsMapped
+   *\brief: Checks if the Audio is Read Straight from a Memory Mapped File
+   *\return: bool - True if Mapped, False if Decoded into Memory
+   */
+  bool IsMapped() const { return mMappedReader != nullptr; }
+
+private:
+
+  SourceAudio() = default;
+
+  SourceBuffer mBuffer;                                         //!< Decoded Samples (Unused when Mapped)
+  std::unique_ptr<MemoryMappedAudioFormatReader> mMappedReader; //!< Owner of the Mapping (nullptr when Decoded)
+
+  GrainSource mSource;          //!< View of the Samples
+  double mSampleRate = 0.0;     //!< Sample Rate of the Audio
+  int mNumChannels = 0;         //!< Number of Channels in the File
+
+  /**
+   *\fn: ViewBuffer
+   *\brief: Points the View at the Decoded Samples
+   */
+  void ViewBuffer();
+};
@@ -0,0 +1,173 @@
+/*****************************************************************************/
+/*!
+\file   GrainVoices.cpp
+\author Anthony Brigante
+\par    email: anthonypbrigante\@gmail.com
+\par    GitHub Repository: https://github.com/abrigante1/GranularSynth
+\brief
+  Implementation of the GrainVoiceManager Class.
+*/
+/*****************************************************************************/
+
+#include "GrainVoices.h"
+
+// ------------------------------------------------------------------------------------
+// ------------------------------------------------------------------------------------
+// ------------------------------------------------------------------------------------
+
+GrainVoiceManager::GrainVoiceManager(int numVoices, int maxCloudSize)
+{
+  mVoices.resize(static_cast<size_t>(jlimit(1, MaxVoices, numVoices)));
+
+  // Voices are Sized for their Own Pools, not a Full Cloud's
+  for (GrainVoice& voice : mVoices)
+    voice.mCloud.reset(new GrainCloud(1, 0, maxCloudSize));
+}
+
+// ------------------------------------------------------------------------------------
+
+void GrainVoiceManager::Prepare(int maxCloudSize, int maxBlockSize)
+{
+  for (GrainVoice& voice : mVoices)
+  {
+    voice.mCloud->mIsPlaying = false;
+    voice.mCloud->Prepare(maxCloudSize, maxBlockSize);
+
+    voice.mNote = -1;
+    voice.mHeld = false;
+  }
+}
+
+// ------------------------------------------------------------------------------------
+
+void GrainVoiceManager::SetParameters(const GrainParameters& parameters)
+{
+  for (GrainVoice& voice : mVoices)
+  {
+    voice.mCloud->GetParameters() = parameters;
+    voice.mCloud->PublishParameters();
+  }
+}
+
+// ------------------------------------------------------------------------------------
+
+bool GrainVoiceManager::PostMidiMessage(const MidiMessage& message)
+{
+  NoteEvent event;
+
+  if (message.isNoteOn())
+    event = { message.getNoteNumber(), message.getFloatVelocity() };
+  else if (message.isNoteOff())
+    event = { message.getNoteNumber(), 0.0f };
+  else if (message.isAllNotesOff() || message.isAllSoundOff())
+    event = { -1, 0.0f };
+  else
+    return true;
+
+  int start1, size1, start2, size2;
+  mEventFifo.prepareToWrite(1, start1, size1, start2, size2);
+
+  if (size1 + size2 == 0)
+    return false;
+
+  mEvents[static_cast<size_t>(size1 > 0 ? start1 : start2)] = event;
+  mEventFifo.finishedWrite(1);
+  return true;
+}
+
+// ------------------------------------------------------------------------------------
+
+int GrainVoiceManager::BeginBlock(const SourceAudio* source, GrainCloud** voices)
+{
+  // Free the Voices whose Release has Finished
+  for (GrainVoice& voice : mVoices)
+  {
+    if (voice.mNote >= 0 && !voice.mHeld && !voice.mCloud->IsSounding())
+      voice.mNote = -1;
+  }
+
+  // Every Voice Reads the Same Source, a New One Restarts the Voices Inside it
+  for (GrainVoice& voice : mVoices)
+    voice.mCloud->ShareAudioSource(source);
+
+  // Play the Notes Queued Since the Last Block
+  int start1, size1, start2, size2;
+  mEventFifo.prepareToRead(mEventFifo.getNumReady(), start1, size1, start2, size2);
+
+  HandleEvents(start1, size1);
+  HandleEvents(start2, size2);
+  mEventFifo.finishedRead(size1 + size2);
+
+  int numVoices = 0;
+  for (GrainVoice& voice : mVoices)
+  {
+    if (voice.mNote >= 0)
+      voices[numVoices++] = voice.mCloud.get();
+  }
+
+  return numVoices;
+}
+
+// ------------------------------------------------------------------------------------
+
+void GrainVoiceManager::HandleEvents(int start, int count)
+{
+  for (int i = start; i < start + count; ++i)
+  {
+    const NoteEvent& event = mEvents[static_cast<size_t>(i)];
+
+    if (event.mVelocity > 0.0f)
+      NoteOn(event.mNote, event.mVelocity);
+    else
+      NoteOff(event.mNote);
+  }
+}
+
+// ------------------------------------------------------------------------------------
+
+void GrainVoiceManager::NoteOn(int note, float velocity)
+{
+  GrainVoice& voice = FindVoice();
+
+  voice.mNote = note;
+  voice.mHeld = true;
+  voice.mStartOrder = ++mNumNotesStarted;
+
+  // The Velocity Sweeps the Gain over VelocityRangeDb, the Loudest Note at Unity
+  const float gain = Decibels::decibelsToGain((velocity - 1.0f) * VelocityRangeDb);
+  voice.mCloud->StartNote(static_cast<double>(note - RootNote), gain);
+}
+
+// ------------------------------------------------------------------------------------
+
+void GrainVoiceManager::NoteOff(int note)
+{
+  for (GrainVoice& voice : mVoices)
+  {
+    if (voice.mHeld && (note < 0 || voice.mNote == note))
+    {
+      voice.mHeld = false;
+      voice.mCloud->Reset();
+    }
+  }
+}
+
+// ------------------------------------------------------------------------------------
+
+GrainVoice& GrainVoiceManager::FindVoice()
+{
+  GrainVoice* oldestReleased = nullptr;
+  GrainVoice* oldestHeld = nullptr;
+
+  for (GrainVoice& voice : mVoices)
+  {
+    if (voice.mNote < 0)
+      return voice;
+
+    GrainVoice*& oldest = voice.mHeld ? oldestHeld : oldestReleased;
+    if (oldest == nullptr || voice.mStartOrder < oldest->mStartOrder)
+      oldest = &voice;
+  }
+
+  return (oldestReleased != nullptr) ? *oldestReleased : *oldestHeld;
+}
@@ -0,0 +1,168 @@
+/*****************************************************************************/
+/*!
+\file   GrainVoices.h
+\author Anthony Brigante
+\par    email: anthonypbrigante\@gmail.com
+\par    GitHub Repository: https://github.com/abrigante1/GranularSynth
+\brief
+  Definition of the GrainVoice Struct and the GrainVoiceManager Class.
+  The GrainVoiceManager plays a GrainCloud per MIDI note.
+*/
+/*****************************************************************************/
+#pragma once
+#include <JuceHeader.h>
+#include <array>
+#include <memory>
+#include <vector>
+#include "Grain.h"
+
+/**
+ *\struct: GrainVoice
+ *\author: Anthony Brigante
+ *\brief:
+    The GrainVoice Struct is a GrainCloud Played by a MIDI Note
+ */
+struct GrainVoice
+{
+  std::unique_ptr<GrainCloud> mCloud; //!< Cloud the Note Plays
+  int mNote = -1;                     //!< MIDI Note Playing the Voice (-1 while Free)
+  bool mHeld = false;                 //!< True from the Note On Until the Note Off
+  uint64 mStartOrder = 0;             //!< Order the Notes Started In, the Oldest is Stolen First
+};
+
+/**
+ *\class: GrainVoiceManager
+ *\author: Anthony Brigante
+ *\brief:
+    The GrainVoiceManager Class plays a fixed number of GrainCloud voices
+    from MIDI notes. Each note takes a voice, which transposes its grains
+    by the note's distance from RootNote and scales them by its velocity.
+    A note off releases the voice, which is free again once its last grain
+    has faded out. When every voice is taken, the oldest released voice,
+    or failing that the oldest held voice, is stolen.
+
+    Every voice is created and prepared up front. MIDI messages are queued
+    by the MIDI thread in a lock-free FIFO and played by the audio thread
+    at the start of its next block, so the audio thread never allocates or
+    locks. The voices read the source of another cloud rather than holding
+    their own copies of it.
+ */
+class GrainVoiceManager
+{
+public:
+
+  //! Default Number of Voices, the Most Notes that Sound at Once
+  static constexpr int DefaultNumVoices = 16;
+
+  //! Largest Number of Voices
+  static constexpr int MaxVoices = 32;
+
+  //! Default Capacity of Each Voice's Grain Pool
+  static constexpr int DefaultMaxVoiceCloudSize = 256;
+
+  //! MIDI Note that Plays the Source at its Own Pitch (Middle C)
+  static constexpr int RootNote = 60;
+
+  //! Gain Range of the Velocity, from the Softest Note to the Loudest (in dB)
+  static constexpr float VelocityRangeDb = 40.0f;
+
+  //! Notes the FIFO Holds Between Blocks (Further Notes are Dropped)
+  static constexpr int EventCapacity = 512;
+
+  /**
+   *\fn: GrainVoiceManager
+   *\brief: Constructor for a GrainVoiceManager, Creates Every Voice
+   *\param: int numVoices - Number of Voices (1 to MaxVoices)
+   *\param: int maxCloudSize - Capacity of Each Voice's Grain Pool (Prepare Reuses it when the Size Matches)
+   */
+  GrainVoiceManager(int numVoices = DefaultNumVoices, int maxCloudSize = DefaultMaxVoiceCloudSize);
+
+  /**
+   *\fn: Prepare
+   *\brief: Allocates the Voices' Grain Pools and Partial Mixes and Silences Every Voice.
+            Must not be Called While Rendering (e.g. call from prepareToPlay).
+   *\param: int maxCloudSize - Maximum Number of Grains Each Voice can Play
+   *\param: int maxBlockSize - Largest Block the Voices Render at Once
+   */
+  void Prepare(int maxCloudSize, int maxBlockSize);
+
+  /**
+   *\fn: SetParameters
+   *\brief: Publishes New Parameters to Every Voice (GUI Thread)
+   *\param: const GrainParameters& parameters - Parameters the Voices Play With
+   */
+  void SetParameters(const GrainParameters& parameters);
+
+  /**
+   *\fn: PostMidiMessage
+   *\brief: Queues a Note On, Note Off, All Notes Off or All Sound Off for the Audio Thread,
+            Ignoring Other Messages (MIDI Thread, Never Blocks). Only One Thread may Post.
+   *\param: const MidiMessage& message - The MIDI Message
+   *\return: bool - False if the Queue was Full and the Message was Dropped
+   */
+  bool PostMidiMessage(const MidiMessage& message);
+
+  /**
+   *\fn: BeginBlock
+   *\brief: Plays the Queued Notes and Lists the Voices to Render this Block (Audio Thread)
+   *\param: const SourceAudio* source - Source the Voices Read (see GrainCloud::UpdateAudioSource)
+   *\param: GrainCloud** voices - Receives the Sounding Voices (Room for GetNumVoices())
+   *\return: int - Number of Sounding Voices
+   */
+  int BeginBlock(const SourceAudio* source, GrainCloud** voices);
+
+  /**
+   *\fn: GetNumVoices
+   *\brief: Gets the Number of Voices
+   *\return: int - Most Notes that Sound at Once
+   */
+  int GetNumVoices() const { return static_cast<int>(mVoices.size()); }
+
+private:
+
+  /**
+   *\struct: NoteEvent
+   *\brief: A Note Queued by PostMidiMessage
+   */
+  struct NoteEvent
+  {
+    int mNote = -1;         //!< MIDI Note (-1 Releases Every Note)
+    float mVelocity = 0.0f; //!< Velocity, 0 to 1 (0 for a Note Off)
+  };
+
+  std::vector<GrainVoice> mVoices;                 //!< Every Voice, Created by the Constructor
+  AbstractFifo mEventFifo{ EventCapacity };        //!< Read and Write Positions of the Queued Notes
+  std::array<NoteEvent, EventCapacity> mEvents;    //!< Queued Notes
+  uint64 mNumNotesStarted = 0;                     //!< Notes Started So Far, Orders the Voices
+
+  /**
+   *\fn: HandleEvents
+   *\brief: Plays a Run of Queued Notes
+   *\param: int start - First Note in mEvents
+   *\param: int count - Number of Notes
+   */
+  void HandleEvents(int start, int count);
+
+  /**
+   *\fn: NoteOn
+   *\brief: Starts a Note on a Free or Stolen Voice
+   *\param: int note - MIDI Note
+   *\param: float velocity - Velocity, 0 to 1
+   */
+  void NoteOn(int note, float velocity);
+
+  /**
+   *\fn: NoteOff
+   *\brief: Releases the Voices Holding a Note
+   *\param: int note - MIDI Note (-1 Releases Every Note)
+   */
+  void NoteOff(int note);
+
+  /**
+   *\fn: FindVoice
+   *\brief: Finds the Voice for a New Note: a Free Voice, or the Oldest Released
+            Voice, or the Oldest Held Voice
+   *\return: GrainVoice& - Voice to Play the Note
+   */
+  GrainVoice& FindVoice();
+};
@@ -10,20 +10,17 @@
 */
 /*****************************************************************************/
 
-// async vs sync granular synthesis
-
 #include "GranularSynthComponent.h"
 #include "Grain.h"
 
 //==============================================================================
 GranularSynthComponent::GranularSynthComponent() 
   : activeGrain(),
-    mThumbnailCache(5),
-    mThumbnail(512, mFormatManager, mThumbnailCache)
+    mSourceLoader(mFormatManager)
 {
 
     // set size of the component
-    setSize (800, 700);
+    setSize (800, 925);
 
 
         //------ CENTROID SAMPLE -------//
@@ -65,12 +62,41 @@ GranularSynthComponent::GranularSynthComponent()
     mCloudSizeLabel.setJustificationType(Justification::centred);
 
     // Slider
-    mCloudSizeSlider.setRange (1, 10);
+    mCloudSizeSlider.setRange (1, GrainCloud::DefaultMaxCloudSize, 1);
+    mCloudSizeSlider.setSkewFactorFromMidPoint(64.0);
     mCloudSizeSlider.setTextValueSuffix (" grains");
     mCloudSizeSlider.setNumDecimalPlacesToDisplay(0);
     mCloudSizeSlider.addListener(this);
     addAndMakeVisible (mCloudSizeSlider);
 
+        //------ GRAIN SCHEDULING -------//
+
+    // Schedule (Item IDs are the GrainSchedule + 1)
+    addAndMakeVisible(mScheduleBox);
+    mScheduleBox.addItemList({ "Continuous (Cloud Size Grains)", "Synchronous (Grains per Second)",
+                               "Asynchronous (Grains per Second)" }, 1);
+    mScheduleBox.setSelectedId(activeGrain.GetParameters().mSchedule + 1, dontSendNotification);
+    mScheduleBox.onChange = [this]
+    {
+        activeGrain.GetParameters().mSchedule = static_cast<GrainSchedule>(mScheduleBox.getSelectedId() - 1);
+        publishParameters();
+    };
+
+    // Density Label
+    addAndMakeVisible(mDensityLabel);
+    mDensityLabel.setText("Grain Density", dontSendNotification);
+    mDensityLabel.attachToComponent(&mDensitySlider, false);
+    mDensityLabel.setJustificationType(Justification::centred);
+
+    // Density Slider
+    mDensitySlider.setRange (1, 5000, 1);
+    mDensitySlider.setSkewFactorFromMidPoint(100.0);
+    mDensitySlider.setValue(activeGrain.GetParameters().mDensity, dontSendNotification);
+    mDensitySlider.setTextValueSuffix (" grains/s");
+    mDensitySlider.setNumDecimalPlacesToDisplay(0);
+    mDensitySlider.addListener(this);
+    addAndMakeVisible (mDensitySlider);
+
         //------ STARTING OFFSET -------//
 
     // Label
@@ -170,6 +196,27 @@ GranularSynthComponent::GranularSynthComponent()
     mRandomPanning.onClick = [this] { updateToggleValue(&mRandomPanning); };
     mRandomPanning.setButtonText("Random Panning?");
 
+    // Grain Window Shape (Item IDs are the EnvelopeShape + 1)
+    addAndMakeVisible(mEnvelopeShapeBox);
+    mEnvelopeShapeBox.addItemList({ "Trapezoid Window", "Hann Window", "Tukey Window",
+                                    "Gaussian Window", "Exponential Decay Window" }, 1);
+    mEnvelopeShapeBox.setSelectedId(activeGrain.GetParameters().mEnvelopeShape + 1, dontSendNotification);
+    mEnvelopeShapeBox.onChange = [this]
+    {
+        activeGrain.GetParameters().mEnvelopeShape = static_cast<EnvelopeShape>(mEnvelopeShapeBox.getSelectedId() - 1);
+        publishParameters();
+    };
+
+    // Interpolation Quality (Item IDs are the InterpolationQuality + 1)
+    addAndMakeVisible(mInterpolationBox);
+    mInterpolationBox.addItemList({ "Linear Interpolation", "Hermite Interpolation", "Windowed Sinc Interpolation" }, 1);
+    mInterpolationBox.setSelectedId(activeGrain.GetParameters().mInterpolation + 1, dontSendNotification);
+    mInterpolationBox.onChange = [this]
+    {
+        activeGrain.GetParameters().mInterpolation = static_cast<InterpolationQuality>(mInterpolationBox.getSelectedId() - 1);
+        publishParameters();
+    };
+
 
     // ----- FILE I/O ----- //
 
@@ -178,6 +225,10 @@ GranularSynthComponent::GranularSynthComponent()
     mOpenFileButton.onClick = [this] { openFile(); };
     addAndMakeVisible(&mOpenFileButton);
 
+    // Memory Map Toggle (Long Recordings Open Instantly, and Only What is Played is Loaded)
+    mMemoryMapButton.setButtonText("Stream WAV Files from Disk?");
+    addAndMakeVisible(&mMemoryMapButton);
+
     // Play Button
     mPlayButton.setButtonText("Play");
     mPlayButton.onClick = [this] { playFile(); };
@@ -192,19 +243,100 @@ GranularSynthComponent::GranularSynthComponent()
     mStopButton.setEnabled(false);
     addAndMakeVisible(&mStopButton);
 
+        //------ MODULATION -------//
+
+    // Modulator Being Edited (Item IDs are the Modulator + 1)
+    addAndMakeVisible(mModulatorBox);
+    for (int modulator = 0; modulator < ModulationMatrix::NumModulators; ++modulator)
+      mModulatorBox.addItem("Modulator " + String(modulator + 1), modulator + 1);
+    mModulatorBox.setSelectedId(1, dontSendNotification);
+    mModulatorBox.onChange = [this] { showModulator(); };
+
+    // Modulation Target (Item IDs are the ModulationTarget + 1)
+    addAndMakeVisible(mModulationTargetBox);
+    mModulationTargetBox.addItemList({ "Target: None", "Target: Centroid", "Target: Starting Offset", "Target: Pitch",
+                                       "Target: Grain Gain", "Target: Global Gain", "Target: Density" }, 1);
+    mModulationTargetBox.onChange = [this]
+    {
+        getSelectedModulator().mTarget = static_cast<ModulationTarget>(mModulationTargetBox.getSelectedId() - 1);
+        publishParameters();
+    };
+
+    // Modulation Shape (Item IDs are the ModulationShape + 1)
+    addAndMakeVisible(mModulationShapeBox);
+    mModulationShapeBox.addItemList({ "Sine LFO", "Triangle LFO", "Saw LFO", "Square LFO",
+                                      "Random Walk", "Rising Envelope", "Falling Envelope" }, 1);
+    mModulationShapeBox.onChange = [this]
+    {
+        getSelectedModulator().mShape = static_cast<ModulationShape>(mModulationShapeBox.getSelectedId() - 1);
+        publishParameters();
+    };
+
+    // Modulation Rate
+    mModulationRateSlider.setRange (0.01, 20.0, 0.01);
+    mModulationRateSlider.setSkewFactorFromMidPoint(1.0);
+    mModulationRateSlider.setTextValueSuffix (" Hz");
+    mModulationRateSlider.addListener(this);
+    addAndMakeVisible (mModulationRateSlider);
+
+    // Modulation Depth
+    mModulationDepthSlider.setRange (0, 100, 1);
+    mModulationDepthSlider.setTextValueSuffix (" % Depth");
+    mModulationDepthSlider.setNumDecimalPlacesToDisplay(0);
+    mModulationDepthSlider.addListener(this);
+    addAndMakeVisible (mModulationDepthSlider);
+
+    showModulator();
+
+        //------ OUTPUT STAGE -------//
+
+    // Output Limiting (Item IDs are the OutputLimiting + 1)
+    addAndMakeVisible(mOutputLimitingBox);
+    mOutputLimitingBox.addItemList({ "Output: Soft Clip", "Output: Lookahead Limiter (2 ms Latency)" }, 1);
+    mOutputLimitingBox.setSelectedId(SOFT_CLIP + 1, dontSendNotification);
+    mOutputLimitingBox.onChange = [this]
+    {
+        mOutputStage.SetLimiting(static_cast<OutputLimiting>(mOutputLimitingBox.getSelectedId() - 1));
+    };
+
+        //------ CALLBACK TELEMETRY -------//
+
+    // Load Readout (Updated by the Timer)
+    mTelemetryLabel.setText("Callback Load: -", dontSendNotification);
+    mTelemetryLabel.setJustificationType(Justification::centredLeft);
+    addAndMakeVisible(&mTelemetryLabel);
+
+    // CSV Recording Toggle (Written by a Background Thread, the Callback Only Queues Each Block)
+    mRecordTelemetryButton.setButtonText("Record Callback Timings to CSV?");
+    mRecordTelemetryButton.onClick = [this] { recordTelemetry(mRecordTelemetryButton.getToggleState()); };
+    addAndMakeVisible(&mRecordTelemetryButton);
+
+    // Reset Button
+    mResetTelemetryButton.setButtonText("Reset Callback Load");
+    mResetTelemetryButton.onClick = [this] { mTelemetry.Reset(); };
+    addAndMakeVisible(&mResetTelemetryButton);
+
     // Register the Audio File Reader
     mFormatManager.registerBasicFormats();
-
-    // Register the Change Listener with the AudioThumbnail
-    mThumbnail.addChangeListener(this);
     
 
     // specify the number of input and output channels that we want to open
     setAudioChannels (0, 2);
+
+    // Play the Voices from Every MIDI Input
+    for (auto& midiInput : MidiInput::getDevices())
+        deviceManager.setMidiInputEnabled(midiInput, true);
+
+    deviceManager.addMidiInputCallback({}, this);
+
+    // Collect Sources Swapped Out by the Audio Thread
+    startTimer(250);
 }
 
 GranularSynthComponent::~GranularSynthComponent()
 {
+    deviceManager.removeMidiInputCallback({}, this);
+
     // This shuts down the audio device and clears the audio source.
     shutdownAudio();
 }
@@ -219,27 +351,46 @@ void GranularSynthComponent::prepareToPlay (int samplesPerBlockExpected, double
     // but be careful - it will be called on the audio thread, not the GUI thread.
 
     // For more details, see the help for AudioProcessor::prepareToPlay()
-    sampleRate = 0;
-    samplesPerBlockExpected = 0;
+
+    // Sources are Converted to the Device's Rate when Loaded (the Timer Reloads them if it Changes)
+    mDeviceSampleRate = sampleRate;
+
+    // Each Callback's Deadline is the Duration of its Block at the Device's Rate
+    mTelemetry.Prepare(sampleRate);
+
+    // The Limiter's Lookahead is Timed at the Device's Rate
+    mOutputStage.Prepare(sampleRate);
+
+    // Allocate the Grain Pool Before the First Callback, Rendering Never Allocates
+    activeGrain.Prepare(GrainCloud::DefaultMaxCloudSize, jmax(samplesPerBlockExpected, GrainCloud::DefaultMaxBlockSize));
+    mVoices.Prepare(GrainVoiceManager::DefaultMaxVoiceCloudSize, jmax(samplesPerBlockExpected, GrainCloud::DefaultMaxBlockSize));
+
+    // Start the Workers that Render the Cloud's Partitions Alongside the Audio Thread
+    mEngine.Prepare(GrainEngine::GetDefaultNumWorkers());
 }
 
 void GranularSynthComponent::getNextAudioBlock (const AudioSourceChannelInfo& bufferToFill)
 {
-   // Get the Next Audio Block if the Grain is Being Played
+   const int64 callbackStart = CallbackTelemetry::Now();
+
+   // Swap in a New Source Even while Stopped, the Voices Play it Too
+   const SourceAudio* source = activeGrain.UpdateAudioSource();
+
+   // Render the Active Grain if it is Being Played, Alongside Every Sounding Voice
+   GrainCloud* clouds[1 + GrainVoiceManager::MaxVoices];
+   int numClouds = 0;
+
    if (activeGrain.mIsPlaying)
-   {
-      for (auto channel = 0; channel < bufferToFill.buffer->getNumChannels(); ++channel)
-      {
-        // Get a pointer to the start sample in the buffer for this audio output channel
-        auto* buffer = bufferToFill.buffer->getWritePointer(channel, bufferToFill.startSample);
-
-        // Fill the required number of samples with noise between -0.125 and +0.125
-        for (auto sample = 0; sample < bufferToFill.numSamples; ++sample)
-        {
-          buffer[sample] = activeGrain(channel);
-        }
-      }
-   }
+     clouds[numClouds++] = &activeGrain;
+
+   numClouds += mVoices.BeginBlock(source, clouds + numClouds);
+
+   mEngine.Render(clouds, numClouds, *bufferToFill.buffer, bufferToFill.startSample, bufferToFill.numSamples);
+
+   // Keep the Mix of Every Cloud Within Full Scale
+   mOutputStage.Process(*bufferToFill.buffer, bufferToFill.startSample, bufferToFill.numSamples);
+
+   mTelemetry.Record(callbackStart, bufferToFill.numSamples, numClouds);
 }
 
 void GranularSynthComponent::releaseResources()
@@ -252,30 +403,37 @@ void GranularSynthComponent::releaseResources()
 
 void GranularSynthComponent::sliderValueChanged(Slider * slider)
 {
+  // Parameters are Edited on the GUI Thread's Copy and Published Below
+  GrainParameters& parameters = activeGrain.GetParameters();
+
   // Centroid Sample
   if (slider == &mCentroidSampleSlider)
   {
-    activeGrain.SetCentroidSample(static_cast<int>(mCentroidSampleSlider.getValue()));
-    repaint();
+    parameters.mCentroidSample = static_cast<int>(mCentroidSampleSlider.getValue()) - 1;
+    repaintOverlay();
   }
 
   // Gain Duration
   else if (slider == &mGrainDurationSlider)
   {
-    activeGrain.SetDuration(static_cast<int>(mGrainDurationSlider.getValue()));
-    repaint();
+    parameters.mDuration = static_cast<int>(mGrainDurationSlider.getValue());
+    repaintOverlay();
   }
 
   // Starting Offset
   else if (slider == &mStartingOffsetSlider)
   {
-    activeGrain.mStartingOffset = static_cast<int>(mStartingOffsetSlider.getValue());
-    repaint();
+    parameters.mStartingOffset = static_cast<int>(mStartingOffsetSlider.getValue());
+    repaintOverlay();
   }
 
   // Cloud Size
   else if (slider == &mCloudSizeSlider)
-    activeGrain.SetCloudSize(static_cast<int>(mCloudSizeSlider.getValue()));
+    parameters.mCloudSize = static_cast<int>(mCloudSizeSlider.getValue());
+
+  // Density
+  else if (slider == &mDensitySlider)
+    parameters.mDensity = mDensitySlider.getValue();
 
   // Pitch Offset Min
   else if (slider == &mPitchOffsetMinSlider)
@@ -284,7 +442,7 @@ void GranularSynthComponent::sliderValueChanged(Slider * slider)
     if(mPitchOffsetMinSlider.getValue() > mPitchOffsetMaxSlider.getValue())
       mPitchOffsetMinSlider.setValue(mPitchOffsetMaxSlider.getValue(), juce::dontSendNotification);
 
-    activeGrain.mPitchOffsetMin = mPitchOffsetMinSlider.getValue();
+    parameters.mPitchOffsetMin = mPitchOffsetMinSlider.getValue();
   }
 
   // Pitch Offset Max
@@ -294,12 +452,12 @@ void GranularSynthComponent::sliderValueChanged(Slider * slider)
     if(mPitchOffsetMinSlider.getValue() > mPitchOffsetMaxSlider.getValue())
       mPitchOffsetMaxSlider.setValue(mPitchOffsetMinSlider.getValue(), juce::dontSendNotification);
 
-    activeGrain.mPitchOffsetMax = mPitchOffsetMaxSlider.getValue();
+    parameters.mPitchOffsetMax = mPitchOffsetMaxSlider.getValue();
   }
   
   // Grain Cloud Gain
   else if(slider == &mGrainCloudGainSlider)
-    activeGrain.mGlobalGain = Decibels::decibelsToGain<double>(mGrainCloudGainSlider.getValue());
+    parameters.mGlobalGain = Decibels::decibelsToGain<double>(mGrainCloudGainSlider.getValue());
   
   // Grain Gain Min Offset
   else if (slider == &mGrainGainMinSlider)
@@ -308,7 +466,7 @@ void GranularSynthComponent::sliderValueChanged(Slider * slider)
     if(mGrainGainMinSlider.getValue() > mGrainGainMaxSlider.getValue())
       mGrainGainMinSlider.setValue(mGrainGainMaxSlider.getValue(), juce::dontSendNotification);
 
-    activeGrain.mGainOffsetDbMin = static_cast<int>(mGrainGainMinSlider.getValue());
+    parameters.mGainOffsetDbMin = static_cast<int>(mGrainGainMinSlider.getValue());
   }
 
   // Grain Gain Max Offset
@@ -318,25 +476,31 @@ void GranularSynthComponent::sliderValueChanged(Slider * slider)
     if(mGrainGainMinSlider.getValue() > mGrainGainMaxSlider.getValue())
       mGrainGainMaxSlider.setValue(mGrainGainMinSlider.getValue(), juce::dontSendNotification);
 
-    activeGrain.mGainOffsetDbMax = static_cast<int>(mGrainGainMaxSlider.getValue());
+    parameters.mGainOffsetDbMax = static_cast<int>(mGrainGainMaxSlider.getValue());
   }
 
   // Release Slider
   else if(slider == &mGrainReleaseSlider)
-    activeGrain.mEnvelopeRelease = (mGrainReleaseSlider.getValue() / 1000.0);
+    parameters.mEnvelopeRelease = mGrainReleaseSlider.getValue();
 
-}
+  // Modulation Rate
+  else if (slider == &mModulationRateSlider)
+    getSelectedModulator().mRate = mModulationRateSlider.getValue();
 
-void GranularSynthComponent::changeListenerCallback(ChangeBroadcaster* source)
-{
-  if(source == &mThumbnail)
-    repaint();
+  // Modulation Depth
+  else if (slider == &mModulationDepthSlider)
+    getSelectedModulator().mDepth = mModulationDepthSlider.getValue() / 100.0;
+
+  publishParameters();
 }
 
 void GranularSynthComponent::updateToggleValue(Button* button)
 {
   if(button == &mRandomPanning)
-    activeGrain.mRandomPanning = button->getToggleState();
+  {
+    activeGrain.GetParameters().mRandomPanning = button->getToggleState();
+    publishParameters();
+  }
 }
 
 //==============================================================================
@@ -356,6 +520,10 @@ void GranularSynthComponent::resized()
     
     // Cloud Size
     mCloudSizeSlider.setBounds      (xValue, (yValue += yValueOffset), getWidth() - xValue - 10, 20);
+
+    // Grain Scheduling
+    mScheduleBox.setBounds          (xValue, (yValue += yValueOffset), halfWidth, 20);
+    mDensitySlider.setBounds        (mScheduleBox.getRight(), yValue, halfWidth, 20);
     
     // Offset
     mStartingOffsetSlider.setBounds (xValue, (yValue += yValueOffset), getWidth() - xValue - 10, 20);
@@ -372,15 +540,40 @@ void GranularSynthComponent::resized()
     mGrainGainMaxSlider.setBounds   (mGrainGainMinSlider.getRight(), yValue, halfWidth, 20);
    
     // Random Panning
-    mRandomPanning.setBounds        (xValue, (yValue += yValueOffset),getWidth() - xValue - 10, 20);
+    mRandomPanning.setBounds        (xValue, (yValue += yValueOffset), halfWidth, 20);
+
+    // Grain Window
+    mEnvelopeShapeBox.setBounds     (mRandomPanning.getRight(), yValue, halfWidth, 20);
+
+    // Interpolation
+    mInterpolationBox.setBounds     (mRandomPanning.getRight(), (yValue += 30), halfWidth, 20);
+
+    // Output Limiting
+    mOutputLimitingBox.setBounds    (xValue, yValue, halfWidth, 20);
+
+    // Modulation
+    mModulatorBox.setBounds         (xValue, (yValue += 30), halfWidth, 20);
+    mModulationTargetBox.setBounds  (mModulatorBox.getRight(), yValue, halfWidth, 20);
+    mModulationShapeBox.setBounds   (xValue, (yValue += 30), halfWidth, 20);
+    mModulationRateSlider.setBounds (mModulationShapeBox.getRight(), yValue, halfWidth, 20);
+    mModulationDepthSlider.setBounds(xValue, (yValue += 30), getWidth() - xValue - 10, 20);
 
     // Buttons
-    mOpenFileButton.setBounds (10, (yValue += 40), getWidth() - 20, 20);
+    mOpenFileButton.setBounds (10, (yValue += 40), halfWidth + 20, 20);
+    mMemoryMapButton.setBounds (mOpenFileButton.getRight() + 10, yValue, halfWidth + 10, 20);
     mPlayButton.setBounds (10, (yValue += 30), halfWidth + 20, 20);
     mStopButton.setBounds (mPlayButton.getRight(), yValue, halfWidth + 20, 20);
 
+    // Callback Telemetry
+    mTelemetryLabel.setBounds (10, (yValue += 30), getWidth() - 20, 20);
+    mRecordTelemetryButton.setBounds (10, (yValue += 25), halfWidth + 20, 20);
+    mResetTelemetryButton.setBounds (mRecordTelemetryButton.getRight(), yValue, halfWidth + 20, 20);
+
     mMaxYValue = (yValue + 50);
 
+    // Waveform
+    mWaveformBounds = Rectangle<int>(20, mMaxYValue, getWidth() - 40, (getHeight() / 4));
+    updateWaveformImage();
 }
 
 void GranularSynthComponent::paint(Graphics& g)
@@ -388,10 +581,10 @@ void GranularSynthComponent::paint(Graphics& g)
   // Only Draw Waveform if the Window is Big Enough
   if (getHeight() >= 700)
   {
-    Rectangle<int> thumbnailBounds(20, mMaxYValue, getWidth() - 40, (getHeight() / 4));
+    const Rectangle<int>& thumbnailBounds = mWaveformBounds;
 
     // Check if a file has been loaded and draw wavefrom if necessary
-    if (mThumbnail.getNumChannels() == 0) // if no wavefrom
+    if (mPeaks == nullptr) // if no wavefrom
     {
       g.setColour(Colours::darkgrey);
       g.fillRect(thumbnailBounds);
@@ -400,17 +593,10 @@ void GranularSynthComponent::paint(Graphics& g)
     }
     else // if waveform
     {
-      g.setColour(Colours::transparentBlack);
-      g.fillRect(thumbnailBounds);
-      g.setColour(Colours::azure);
-
-      // Draw Waveform
-      double audioLength = mThumbnail.getTotalLength();
-      mThumbnail.drawChannels(g,
-        thumbnailBounds,
-        0.0,
-        audioLength,
-        1.0f);
+      // Draw the Cached Waveform, then the Overlays on Top
+      double audioLength = mPeaks->GetLength() / mPeaks->GetSampleRate();
+      g.drawImageAt(mWaveformImage, thumbnailBounds.getX(), thumbnailBounds.getY());
+      mOverlayBounds = getOverlayBounds();
 
       // Draw Current Sample Line
      auto audioPosition = (activeGrain.GetCentroidSample() / activeGrain.mSamplingRate);
@@ -443,16 +629,16 @@ void GranularSynthComponent::paint(Graphics& g)
                                  juce::Point<float>(static_cast<float>(endDrawPosition), static_cast<float>(thumbnailBounds.getBottom()))));
 
      // Get Random Starting/Ending Position
-     if (activeGrain.mStartingOffset > 0)
+     if (activeGrain.GetParameters().mStartingOffset > 0)
      {
        // Draw Starting Value Range
-       auto minRandomPosition = (activeGrain.GetCentroidSample() - activeGrain.mStartingOffset) / activeGrain.mSamplingRate;
+       auto minRandomPosition = (activeGrain.GetCentroidSample() - activeGrain.GetParameters().mStartingOffset) / activeGrain.mSamplingRate;
        if (minRandomPosition < 0)
          minRandomPosition = 0;
 
        auto drawStartingMinPosition = (minRandomPosition / audioLength) * thumbnailBounds.getWidth() + thumbnailBounds.getX();
 
-       double maxRandomPosition = (activeGrain.GetCentroidSample() + activeGrain.mStartingOffset);
+       double maxRandomPosition = (activeGrain.GetCentroidSample() + activeGrain.GetParameters().mStartingOffset);
        if (maxRandomPosition >= activeGrain.GetSize())
          maxRandomPosition = activeGrain.GetSize();
        maxRandomPosition /= activeGrain.mSamplingRate;
@@ -466,13 +652,13 @@ void GranularSynthComponent::paint(Graphics& g)
 
 
        // Draw Ending Range Based on Starting Value
-       minRandomPosition = ((activeGrain.GetCentroidSample() - activeGrain.mStartingOffset) / activeGrain.mSamplingRate) + (grainDuration / 1000.0);;
+       minRandomPosition = ((activeGrain.GetCentroidSample() - activeGrain.GetParameters().mStartingOffset) / activeGrain.mSamplingRate) + (grainDuration / 1000.0);;
        if (minRandomPosition < 0)
          minRandomPosition = 0;
 
        drawStartingMinPosition = (minRandomPosition / audioLength) * thumbnailBounds.getWidth() + thumbnailBounds.getX();
 
-       maxRandomPosition = (activeGrain.GetCentroidSample() + activeGrain.mStartingOffset);
+       maxRandomPosition = (activeGrain.GetCentroidSample() + activeGrain.GetParameters().mStartingOffset);
        if (maxRandomPosition >= activeGrain.GetSize())
          maxRandomPosition = activeGrain.GetSize();
        maxRandomPosition /= activeGrain.mSamplingRate;
@@ -491,6 +677,79 @@ void GranularSynthComponent::paint(Graphics& g)
   }
 }
 
+void GranularSynthComponent::drawWaveform(Graphics& g, Rectangle<int> bounds)
+{
+  const int numChannels = mPeaks->GetNumChannels();
+  const int64 length = mPeaks->GetLength();
+  const int width = jmax(1, bounds.getWidth());
+  const float halfHeight = bounds.getHeight() / (2.0f * numChannels);
+
+  for (int channel = 0; channel < numChannels; ++channel)
+  {
+    const float centre = bounds.getY() + halfHeight * (2 * channel + 1);
+
+    for (int x = 0; x < bounds.getWidth(); ++x)
+    {
+      // The Pyramid Reads the Level Matching the Samples Under the Column
+      const PeakBin peak = mPeaks->GetPeak(channel, length * x / width, length * (x + 1) / width);
+      const float top = centre - peak.mMax * halfHeight;
+
+      g.setColour(Colours::azure);
+      g.drawVerticalLine(bounds.getX() + x, top, jmax(top + 1.0f, centre - peak.mMin * halfHeight));
+
+      g.setColour(Colours::steelblue);
+      g.drawVerticalLine(bounds.getX() + x, centre - peak.mRms * halfHeight, centre + peak.mRms * halfHeight);
+    }
+  }
+}
+
+void GranularSynthComponent::updateWaveformImage()
+{
+  if (mPeaks == nullptr || mWaveformBounds.isEmpty())
+  {
+    mWaveformImage = Image();
+    return;
+  }
+
+  mWaveformImage = Image(Image::ARGB, mWaveformBounds.getWidth(), mWaveformBounds.getHeight(), true);
+
+  Graphics g(mWaveformImage);
+  drawWaveform(g, mWaveformBounds.withZeroOrigin());
+}
+
+Rectangle<int> GranularSynthComponent::getOverlayBounds()
+{
+  if (mPeaks == nullptr || activeGrain.mSamplingRate <= 0.0)
+    return {};
+
+  const double audioLength = mPeaks->GetLength() / mPeaks->GetSampleRate();
+  const double startingOffset = activeGrain.GetParameters().mStartingOffset;
+  const double grainDuration = mGrainDurationSlider.getValue() / 1000.0;
+
+  // Every Overlay Lies Between the Earliest Grain Start and the Latest Grain End
+  const double first = jmax(0.0, activeGrain.GetCentroidSample() - startingOffset) / activeGrain.mSamplingRate;
+  const double last = jmin(static_cast<double>(activeGrain.GetSize()), activeGrain.GetCentroidSample() + startingOffset)
+                      / activeGrain.mSamplingRate + grainDuration;
+
+  // Padded for the Width of the Lines
+  const int left = mWaveformBounds.getX() + static_cast<int>(std::floor(first / audioLength * mWaveformBounds.getWidth())) - 2;
+  const int right = mWaveformBounds.getX() + static_cast<int>(std::ceil(last / audioLength * mWaveformBounds.getWidth())) + 2;
+
+  return Rectangle<int>(left, mWaveformBounds.getY(), right - left, mWaveformBounds.getHeight());
+}
+
+void GranularSynthComponent::repaintOverlay()
+{
+  // Where the Overlays Were (the Waveform Image Shows Through Again) and Where they Now Are
+  if (!mOverlayBounds.isEmpty())
+    repaint(mOverlayBounds);
+
+  const Rectangle<int> overlayBounds = getOverlayBounds();
+
+  if (!overlayBounds.isEmpty())
+    repaint(overlayBounds);
+}
+
 //==============================================================================
 
 void GranularSynthComponent::changeState(TransportState newState)
@@ -526,56 +785,172 @@ void GranularSynthComponent::changeState(TransportState newState)
 
 void GranularSynthComponent::openFile()
 {
-  // Set the Grain to No Longer be Playing
-  activeGrain.mIsPlaying = false;
-  
-  // Close the Audio Thread While Opening A File
-  shutdownAudio();
-  
   FileChooser chooser("Select a WAV file to play...", {}, "*.wav;*.flac");
   
-  // Open File Browser
+  // Open File Browser, the File is Loaded in the Background While the Current One Keeps Playing
   if (chooser.browseForFileToOpen())
+    loadFile(chooser.getResult(), true);
+}
+
+void GranularSynthComponent::loadFile(const File& file, bool resetControls)
+{
+  mOpenFileButton.setEnabled(false);
+  mOpenFileButton.setButtonText("Loading...");
+
+  mSourceLoader.Load(file, mMemoryMapButton.getToggleState(), mDeviceSampleRate.load(),
+                     [this, resetControls](const File& loadedFile, std::unique_ptr<SourceAudio> audio,
+                                           std::unique_ptr<PeakPyramid> peaks, const String& error)
+                     {
+                       sourceLoaded(loadedFile, std::move(audio), std::move(peaks), error, resetControls);
+                     });
+}
+
+void GranularSynthComponent::sourceLoaded(const File& file, std::unique_ptr<SourceAudio> audio,
+                                          std::unique_ptr<PeakPyramid> peaks, const String& error, bool resetControls)
+{
+  mOpenFileButton.setEnabled(true);
+  mOpenFileButton.setButtonText("Open File...");
+
+  if (audio == nullptr)
   {
-    auto file = chooser.getResult();
-    auto* reader = mFormatManager.createReaderFor(file);
+    // Stop Reloading a File that has Gone Away
+    mSourceFile = File();
 
-    // Load File into the Grain
-    if (reader != nullptr)
-    {
-      // Enable the PlayButton
-      mPlayButton.setEnabled(true);
-
-      // Set the Thumbnail's Source to the new wavefile
-      mThumbnail.setSource(new FileInputSource(file));
-
-      // Set the Active Grain's Source Audio File to the New Source
-      activeGrain.SetAudioSource(*reader);
-      activeGrain.mSamplingRate = reader->sampleRate;
-
-      // Update the Starting Sample Slider Range
-      mCentroidSampleSlider.setRange (1, activeGrain.GetSize());
-      mCentroidSampleSlider.setTextValueSuffix (" Sample");
-      mCentroidSampleSlider.setNumDecimalPlacesToDisplay(0);
-
-      // Reset the Values for all Sliders 
-      mCentroidSampleSlider.setValue(1);
-      mGrainDurationSlider.setValue(1);
-      mCloudSizeSlider.setValue(1);
-      mStartingOffsetSlider.setValue(0);
-      mPitchOffsetMinSlider.setValue(0);
-      mPitchOffsetMaxSlider.setValue(0);
-      mGrainCloudGainSlider.setValue(0);
-      mGrainGainMinSlider.setValue(0);
-      mGrainGainMaxSlider.setValue(0);
-
-      // Turn Back on the Audio Thread
-      setAudioChannels(0, reader->numChannels);
-
-      // Clear the File Reader From Memory
-      delete reader;
-    }
+    AlertWindow::showMessageBoxAsync(AlertWindow::WarningIcon, "Unable to Open File", error);
+    return;
   }
+
+  mSourceFile = file;
+
+  // The Peaks Always Match the Audio Being Played, Reloads Included
+  mPeaks = std::move(peaks);
+  updateWaveformImage();
+  repaint();
+
+  // A Reload at a New Sample Rate Keeps the Controls, with the Sample Positions Scaled to the New Length
+  if (!resetControls)
+  {
+    const double scale = static_cast<double>(audio->GetLength()) / jmax(1, activeGrain.GetSize());
+    const double centroidSample = mCentroidSampleSlider.getValue() * scale;
+    const double startingOffset = mStartingOffsetSlider.getValue() * scale;
+
+    activeGrain.SetAudioSource(std::move(audio));
+
+    mCentroidSampleSlider.setRange (1, activeGrain.GetSize());
+    mCentroidSampleSlider.setValue(jmax(1.0, std::round(centroidSample)));
+    mStartingOffsetSlider.setValue(std::round(startingOffset));
+    return;
+  }
+
+  // Enable the PlayButton (the New File Keeps Playing if the Last One was)
+  mPlayButton.setEnabled(!activeGrain.mIsPlaying);
+
+  // Hand the New Source to the Audio Thread, which Swaps it in Between Blocks
+  activeGrain.SetAudioSource(std::move(audio));
+
+  // Update the Starting Sample Slider Range
+  mCentroidSampleSlider.setRange (1, activeGrain.GetSize());
+  mCentroidSampleSlider.setTextValueSuffix (" Sample");
+  mCentroidSampleSlider.setNumDecimalPlacesToDisplay(0);
+
+  // Reset the Values for all Sliders 
+  mCentroidSampleSlider.setValue(1);
+  mGrainDurationSlider.setValue(1);
+  mCloudSizeSlider.setValue(1);
+  mStartingOffsetSlider.setValue(0);
+  mPitchOffsetMinSlider.setValue(0);
+  mPitchOffsetMaxSlider.setValue(0);
+  mGrainCloudGainSlider.setValue(0);
+  mGrainGainMinSlider.setValue(0);
+  mGrainGainMaxSlider.setValue(0);
+}
+
+void GranularSynthComponent::timerCallback()
+{
+  // Free the Source the Audio Thread Swapped Out, it Never Frees Memory Itself
+  activeGrain.CollectRetiredSource();
+
+  updateTelemetryLabel();
+
+  // Reload the Source if the Device's Sample Rate has Changed Since it was Converted
+  const double deviceSampleRate = mDeviceSampleRate.load();
+
+  if (deviceSampleRate > 0.0 && mSourceFile != File() && !mSourceLoader.IsLoading()
+      && activeGrain.mSamplingRate != deviceSampleRate)
+    loadFile(mSourceFile, false);
+}
+
+void GranularSynthComponent::handleIncomingMidiMessage(MidiInput*, const MidiMessage& message)
+{
+  // The Audio Thread Plays the Note at the Start of its Next Block
+  mVoices.PostMidiMessage(message);
+}
+
+void GranularSynthComponent::publishParameters()
+{
+  activeGrain.PublishParameters();
+  mVoices.SetParameters(activeGrain.GetParameters());
+}
+
+void GranularSynthComponent::showModulator()
+{
+  const ModulatorParameters& modulator = getSelectedModulator();
+
+  mModulationTargetBox.setSelectedId(modulator.mTarget + 1, dontSendNotification);
+  mModulationShapeBox.setSelectedId(modulator.mShape + 1, dontSendNotification);
+  mModulationRateSlider.setValue(modulator.mRate, dontSendNotification);
+  mModulationDepthSlider.setValue(modulator.mDepth * 100.0, dontSendNotification);
+}
+
+ModulatorParameters& GranularSynthComponent::getSelectedModulator()
+{
+  const int modulator = jlimit(0, ModulationMatrix::NumModulators - 1, mModulatorBox.getSelectedId() - 1);
+  return activeGrain.GetParameters().mModulators[modulator];
+}
+
+void GranularSynthComponent::recordTelemetry(bool record)
+{
+  if (!record)
+  {
+    mTelemetry.StopRecording();
+    return;
+  }
+
+  FileChooser chooser("Record the callback timings to...",
+                      File::getSpecialLocation(File::userDocumentsDirectory).getChildFile("GranularSynthCallbacks.csv"),
+                      "*.csv");
+
+  // Untick the Toggle if Nothing is Being Recorded
+  if (!chooser.browseForFileToSave(true) || !mTelemetry.StartRecording(chooser.getResult()))
+    mRecordTelemetryButton.setToggleState(false, dontSendNotification);
+}
+
+void GranularSynthComponent::updateTelemetryLabel()
+{
+  const CallbackStats stats = mTelemetry.GetStats();
+
+  String text = "Callback Load: ";
+
+  if (stats.mNumCallbacks == 0)
+    text << "-";
+  else
+    text << "min " << String(100.0 * stats.mMinLoad, 1) << "%, mean " << String(100.0 * stats.mMeanLoad, 1) << "%, p99 " << String(100.0 * stats.mP99Load, 1)
+         << "%, max " << String(100.0 * stats.mMaxLoad, 1) << "%    Missed Deadlines: " << String(stats.mNumOverruns)
+         << " of " << String(stats.mNumCallbacks);
+
+  // Devices that Count their Own Xruns Catch those the Callback Never Saw
+  if (auto* device = deviceManager.getCurrentAudioDevice())
+  {
+    const int xruns = device->getXRunCount();
+
+    if (xruns >= 0)
+      text << "    Device Xruns: " << String(xruns);
+  }
+
+  if (stats.mNumDropped > 0)
+    text << "    (" << String(stats.mNumDropped) << " Blocks not Recorded)";
+
+  mTelemetryLabel.setText(text, dontSendNotification);
 }
 
 void GranularSynthComponent::playFile()
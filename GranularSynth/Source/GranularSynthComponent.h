@@ -14,6 +14,12 @@
 
 #include "../JuceLibraryCode/JuceHeader.h"
 #include "Grain.h"
+#include "GrainEngine.h"
+#include "GrainVoices.h"
+#include "CallbackTelemetry.h"
+#include "OutputStage.h"
+#include "SourceLoader.h"
+#include "PeakPyramid.h"
 
 /**
  *\class: GranularSynthComponent
@@ -23,7 +29,8 @@
  */
 class GranularSynthComponent   : public AudioAppComponent,
                                  public Slider::Listener,
-                                 public ChangeListener
+                                 private MidiInputCallback,
+                                 private Timer
 { 
 public:
     //==============================================================================
@@ -46,8 +53,9 @@ public:
     void releaseResources() override;
 
     void sliderValueChanged(Slider* slider) override;
-    void changeListenerCallback(ChangeBroadcaster* source) override;
     void updateToggleValue(Button* button);
+    void timerCallback() override;
+    void handleIncomingMidiMessage(MidiInput* source, const MidiMessage& message) override;
 
     //==============================================================================
     void resized() override;
@@ -59,6 +67,7 @@ private:
     //----- GUI Objects -----//
     
     TextButton mOpenFileButton;    //<! Button Used to Open an Audio File
+    ToggleButton mMemoryMapButton; //<! ToggleButton Determining if WAV Files are Memory Mapped Instead of Loaded
     TextButton mPlayButton;        //<! Button Used to Play an opened Audio File
     TextButton mStopButton;        //<! Button Used to Stop an Opened Audio File
 
@@ -74,6 +83,10 @@ private:
     Label mCloudSizeLabel;         //<! Label Noting the Cloud Size Slider
     Slider mCloudSizeSlider;       //<! Slider Designating the Cloud Size of a Grain
 
+    ComboBox mScheduleBox;         //<! ComboBox Selecting How the Grains are Started
+    Label mDensityLabel;           //<! Label Noting the Density Slider
+    Slider mDensitySlider;         //<! Slider Designating the Grains Started per Second
+
     // --- Pitch Offset --- //
     Label mPitchOffsetLabel;       //<! Label Noting the Pitch Offset Sliders
     
@@ -100,6 +113,23 @@ private:
 
     Slider mGrainReleaseSlider;    //<! Slider Designating The Release Value of the Grain ADSR
     ToggleButton mRandomPanning;   //<! ToggleButton Determining if we are to Randomly Pan the Grain
+    ComboBox mEnvelopeShapeBox;    //<! ComboBox Selecting the Window Shape of the Grains
+    ComboBox mInterpolationBox;    //<! ComboBox Selecting How Pitched Grains Read the Audio Between Samples
+    ComboBox mOutputLimitingBox;   //<! ComboBox Selecting How the Mix is Kept Within Full Scale
+
+    // --- Modulation --- //
+
+    ComboBox mModulatorBox;             //<! ComboBox Selecting Which Modulator the Controls Below Edit
+    ComboBox mModulationTargetBox;      //<! ComboBox Selecting the Parameter the Modulator Moves
+    ComboBox mModulationShapeBox;       //<! ComboBox Selecting the Signal the Modulator Produces
+    Slider mModulationRateSlider;       //<! Slider Designating the Speed of the Modulator
+    Slider mModulationDepthSlider;      //<! Slider Designating How Far the Modulator Moves its Parameter
+
+    // --- Callback Telemetry --- //
+
+    Label mTelemetryLabel;                //<! Label Showing the Load of the Audio Callback
+    ToggleButton mRecordTelemetryButton;  //<! ToggleButton Determining if Every Callback is Written to a CSV File
+    TextButton mResetTelemetryButton;     //<! Button Used to Clear the Callback Statistics
 
     //----- Data ------//
 
@@ -118,15 +148,25 @@ private:
     AudioFormatManager mFormatManager;  //<! Manages Valid Audio Formats
     TransportState state;               //<! Determines the Current Audio Playback State
 
-    std::vector<GrainCloud> mGrains;   //<! Vector of Grains 
     GrainCloud activeGrain;            //<! Reference to the Current Active grain. 
+    GrainEngine mEngine;               //<! Renders the Grains on the Worker Threads
+    GrainVoiceManager mVoices;         //<! Clouds Played by MIDI Notes, Sharing the Active Grain's Source
+    CallbackTelemetry mTelemetry;      //<! Times Every Audio Callback Against its Deadline
+    OutputStage mOutputStage;          //<! Keeps the Mix of Every Cloud Within Full Scale
 
     int mMaxYValue = 0; //<! Maximum Y value of Components being Drawn to the Screen
 
     // --- Waveform GUI Drawing --- //
     
-    AudioThumbnailCache mThumbnailCache; //<! Drawing Cache for the Waveform
-    AudioThumbnail mThumbnail;           //<! Waveform Thumbnail Object
+    std::unique_ptr<PeakPyramid> mPeaks; //<! Min/Max/RMS Peaks of the Active Source, Drawn as the Waveform
+    Image mWaveformImage;                //<! The Drawn Waveform, Only Redrawn on Load or Resize
+    Rectangle<int> mWaveformBounds;      //<! Area the Waveform is Drawn in, Set by resized
+    Rectangle<int> mOverlayBounds;       //<! Area the Overlays Covered when Last Painted
+
+    SourceLoader mSourceLoader;          //<! Loads Audio Files on a Background Thread
+    File mSourceFile;                    //<! File the Active Grain is Playing
+
+    std::atomic<double> mDeviceSampleRate{ 0.0 }; //<! Sample Rate of the Audio Device, Set by prepareToPlay
 
     //================================FUNCTIONS=====================================
      
@@ -143,6 +183,85 @@ private:
      */
     void openFile();
 
+    /**
+     *\fn: loadFile
+     *\brief: Starts Loading an Audio File at the Device's Sample Rate
+     *\param: const File& file - File to Load
+     *\param: bool resetControls - True to Reset the Controls Once Loaded, False to Keep them (Reloads)
+     */
+    void loadFile(const File& file, bool resetControls);
+
+    /**
+     *\fn: sourceLoaded
+     *\brief: Hands a Loaded Audio File to the Active Grain and Updates the Controls
+     *\param: const File& file - The Loaded File
+     *\param: std::unique_ptr<SourceAudio> audio - The Loaded Audio (nullptr if it could not be Loaded)
+     *\param: std::unique_ptr<PeakPyramid> peaks - Peaks of the Loaded Audio
+     *\param: const String& error - Reason the File could not be Loaded
+     *\param: bool resetControls - True to Reset the Controls, False to Keep them Where they Were
+     */
+    void sourceLoaded(const File& file, std::unique_ptr<SourceAudio> audio, std::unique_ptr<PeakPyramid> peaks,
+                      const String& error, bool resetControls);
+
+    /**
+     *\fn: drawWaveform
+     *\brief: Draws the Peaks of the Active Source, a Column per Pixel, Channels Stacked
+     *\param: Graphics& g - Graphics Context to Draw with
+     *\param: Rectangle<int> bounds - Area to Draw the Waveform in
+     */
+    void drawWaveform(Graphics& g, Rectangle<int> bounds);
+
+    /**
+     *\fn: updateWaveformImage
+     *\brief: Redraws the Cached Waveform Image at the Size of the Waveform Area
+     */
+    void updateWaveformImage();
+
+    /**
+     *\fn: getOverlayBounds
+     *\brief: Gets the Area Covered by the Centroid, Duration and Offset Overlays
+     *\return: Rectangle<int> - Area of the Overlays (Empty if no File is Loaded)
+     */
+    Rectangle<int> getOverlayBounds();
+
+    /**
+     *\fn: repaintOverlay
+     *\brief: Repaints Only Where the Overlays Were and Where they Now Are
+     */
+    void repaintOverlay();
+
+    /**
+     *\fn: publishParameters
+     *\brief: Publishes the Edited Parameters to the Active Grain and to Every Voice
+     */
+    void publishParameters();
+
+    /**
+     *\fn: showModulator
+     *\brief: Sets the Modulation Controls to the Modulator Selected by the Modulator Box
+     */
+    void showModulator();
+
+    /**
+     *\fn: getSelectedModulator
+     *\brief: Gets the Modulator Selected by the Modulator Box
+     *\return: ModulatorParameters& - The Modulator, in the Active Grain's Parameters
+     */
+    ModulatorParameters& getSelectedModulator();
+
+    /**
+     *\fn: recordTelemetry
+     *\brief: Starts Writing Every Callback to a CSV File Chosen by the User, or Stops
+     *\param: bool record - True to Start Recording, False to Stop
+     */
+    void recordTelemetry(bool record);
+
+    /**
+     *\fn: updateTelemetryLabel
+     *\brief: Shows the Newest Callback Statistics and the Device's Xrun Count
+     */
+    void updateTelemetryLabel();
+
     /**
      *\fn: playFile
      *\brief: Plays a Selected Audio File
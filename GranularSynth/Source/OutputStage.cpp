@@ -0,0 +1,210 @@
+/*****************************************************************************/
+/*!
+\file   OutputStage.cpp
+\author Anthony Brigante
+\par    email: anthonypbrigante\@gmail.com
+\par    GitHub Repository: https://github.com/abrigante1/GranularSynth
+\brief
+  Implementation of the OutputStage Class.
+*/
+/*****************************************************************************/
+
+#include "OutputStage.h"
+#include "GrainSimd.h"
+#include <cmath>
+
+namespace
+{
+  /**
+   *\fn: SoftClipSample
+   *\brief: Soft Clips a Single Sample (the Scalar Form of OutputStage::SoftClip)
+   *\param: float x - Sample
+   *\return: float - Clipped Sample, Within [-1, 1]
+   */
+  inline float SoftClipSample(float x)
+  {
+    const float knee = OutputStage::SoftClipKnee;
+    const float range = 1.0f - knee;
+
+    // Past the Knee, a Pade Approximation of tanh Bends the Level into the Headroom,
+    // Reaching it (with a Flat Slope) 3 Headrooms Past the Knee
+    const float level = std::abs(x);
+    const float over = jmin(jmax(level - knee, 0.0f) / range, 3.0f);
+    const float bent = jmin(level, knee) + range * over * (27.0f + over * over) / (27.0f + 9.0f * over * over);
+
+    return std::copysign(bent, x);
+  }
+}
+
+// ------------------------------------------------------------------------------------
+// ------------------------------------------------------------------------------------
+// ------------------------------------------------------------------------------------
+
+void OutputStage::Prepare(double sampleRate)
+{
+  mLookahead = jmax(1, static_cast<int>(std::ceil(sampleRate * LookaheadMs / 1000.0)));
+  mReleaseCoefficient = static_cast<float>(1.0 - std::exp(-1000.0 / (jmax(1.0, sampleRate) * ReleaseMs)));
+
+  for (std::vector<float>& delay : mDelay)
+    delay.resize(static_cast<size_t>(mLookahead));
+
+  mWindowGain.resize(static_cast<size_t>(mLookahead));
+  mWindowFrame.resize(static_cast<size_t>(mLookahead));
+  mSmoothing.resize(static_cast<size_t>(mLookahead));
+
+  mLimiting = mRequestedLimiting;
+  ResetLimiter();
+}
+
+// ------------------------------------------------------------------------------------
+
+void OutputStage::Process(AudioBuffer<float>& buffer, int startSample, int numSamples)
+{
+  if (numSamples <= 0 || buffer.getNumChannels() == 0)
+    return;
+
+  // A New Limiting Starts from an Empty Delay Line
+  const OutputLimiting limiting = mRequestedLimiting;
+  if (limiting != mLimiting)
+  {
+    mLimiting = limiting;
+    ResetLimiter();
+  }
+
+  float* left = buffer.getWritePointer(0, startSample);
+  float* right = (buffer.getNumChannels() >= 2) ? buffer.getWritePointer(1, startSample) : nullptr;
+
+  if (mLimiting == LOOKAHEAD_LIMITER && !mSmoothing.empty())
+  {
+    Limit(left, right, numSamples);
+    return;
+  }
+
+  SoftClip(left, numSamples);
+
+  if (right != nullptr)
+    SoftClip(right, numSamples);
+}
+
+// ------------------------------------------------------------------------------------
+
+void OutputStage::SoftClip(float* samples, int numSamples)
+{
+  int i = 0;
+
+#if GRAIN_KERNEL_USE_SSE2
+  const __m128 knee = _mm_set1_ps(SoftClipKnee);
+  const __m128 range = _mm_set1_ps(1.0f - SoftClipKnee);
+  const __m128 inverseRange = _mm_set1_ps(1.0f / (1.0f - SoftClipKnee));
+  const __m128 three = _mm_set1_ps(3.0f);
+  const __m128 nine = _mm_set1_ps(9.0f);
+  const __m128 twentySeven = _mm_set1_ps(27.0f);
+  const __m128 signMask = _mm_set1_ps(-0.0f);
+
+  // Four Samples at a Time, the Same Steps as SoftClipSample
+  for (; i + 4 <= numSamples; i += 4)
+  {
+    const __m128 x = _mm_loadu_ps(samples + i);
+    const __m128 sign = _mm_and_ps(x, signMask);
+    const __m128 level = _mm_andnot_ps(signMask, x);
+
+    const __m128 over = _mm_min_ps(_mm_mul_ps(_mm_max_ps(_mm_sub_ps(level, knee), _mm_setzero_ps()), inverseRange), three);
+    const __m128 over2 = _mm_mul_ps(over, over);
+    const __m128 bent = _mm_div_ps(_mm_mul_ps(over, _mm_add_ps(twentySeven, over2)),
+                                   _mm_add_ps(twentySeven, _mm_mul_ps(nine, over2)));
+
+    const __m128 clipped = _mm_add_ps(_mm_min_ps(level, knee), _mm_mul_ps(range, bent));
+    _mm_storeu_ps(samples + i, _mm_or_ps(clipped, sign));
+  }
+#endif
+
+  for (; i < numSamples; ++i)
+    samples[i] = SoftClipSample(samples[i]);
+}
+
+// ------------------------------------------------------------------------------------
+
+void OutputStage::Limit(float* left, float* right, int numSamples)
+{
+  const int lookahead = mLookahead;
+
+  for (int frame = 0; frame < numSamples; ++frame, ++mFrame)
+  {
+    // Gain this Frame Needs to Stay Under the Ceiling (Both Channels Share it, Keeping the Image)
+    const float peak = (right != nullptr) ? jmax(std::abs(left[frame]), std::abs(right[frame])) : std::abs(left[frame]);
+    const float needed = (peak > LimiterCeiling) ? LimiterCeiling / peak : 1.0f;
+
+    // Sliding Minimum of the Needed Gains over the Window (Entries Needing Less are Dropped from the Back)
+    while (mWindowCount > 0 && mWindowGain[static_cast<size_t>((mWindowFront + mWindowCount - 1) % lookahead)] >= needed)
+      --mWindowCount;
+
+    if (mWindowCount > 0 && mWindowFrame[static_cast<size_t>(mWindowFront)] <= mFrame - lookahead)
+    {
+      mWindowFront = (mWindowFront + 1) % lookahead;
+      --mWindowCount;
+    }
+
+    const size_t back = static_cast<size_t>((mWindowFront + mWindowCount) % lookahead);
+    mWindowGain[back] = needed;
+    mWindowFrame[back] = mFrame;
+    ++mWindowCount;
+
+    // Recover Slowly, but Never Above what the Window Needs
+    const float windowGain = mWindowGain[static_cast<size_t>(mWindowFront)];
+    mReleasedGain = jmin(windowGain, mReleasedGain + (1.0f - mReleasedGain) * mReleaseCoefficient);
+
+    // Averaging over the Window Ramps the Gain Down Ahead of Each Peak, and Every
+    // Released Gain Averaged for a Delayed Sample Covers that Sample's Needed Gain
+    const size_t slot = static_cast<size_t>(mFrame % lookahead);
+    mSmoothingSum += mReleasedGain - mSmoothing[slot];
+    mSmoothing[slot] = mReleasedGain;
+
+    const float gain = static_cast<float>(mSmoothingSum / lookahead);
+
+    // The Delay Line Holds the Last mLookahead Frames, the Oldest (mLookahead - 1 Frames Ago) is Played Now
+    const size_t oldest = static_cast<size_t>((mFrame + 1) % lookahead);
+
+    mDelay[0][slot] = left[frame];
+    left[frame] = mDelay[0][oldest] * gain;
+
+    if (right != nullptr)
+    {
+      mDelay[1][slot] = right[frame];
+      right[frame] = mDelay[1][oldest] * gain;
+    }
+  }
+}
+
+// ------------------------------------------------------------------------------------
+
+void OutputStage::ResetLimiter()
+{
+  for (std::vector<float>& delay : mDelay)
+    std::fill(delay.begin(), delay.end(), 0.0f);
+
+  std::fill(mSmoothing.begin(), mSmoothing.end(), 1.0f);
+  mSmoothingSum = static_cast<double>(mSmoothing.size());
+  mReleasedGain = 1.0f;
+
+  mWindowFront = 0;
+  mWindowCount = 0;
+  mFrame = 0;
+}
+
+// ------------------------------------------------------------------------------------
+
+void OutputStage::Dither(AudioBuffer<float>& buffer, int startSample, int numSamples, int bitsPerSample)
+{
+  // One Least Significant Bit of a Signed Integer Sample, on the Float Scale
+  const float lsb = 1.0f / static_cast<float>(1 << (jlimit(8, 24, bitsPerSample) - 1));
+
+  // The Difference of Two Uniform Values is Triangular over [-1, 1] LSB, which
+  // Leaves the Quantisation Error Independent of the Signal
+  for (int channel = 0; channel < buffer.getNumChannels(); ++channel)
+  {
+    float* samples = buffer.getWritePointer(channel, startSample);
+
+    for (int i = 0; i < numSamples; ++i)
+      samples[i] += (mDitherRandom.NextFloat() - mDitherRandom.NextFloat()) * lsb;
+  }
+}
@@ -0,0 +1,136 @@
+/*****************************************************************************/
+/*!
+\file   OutputStage.h
+\author Anthony Brigante
+\par    email: anthonypbrigante\@gmail.com
+\par    GitHub Repository: https://github.com/abrigante1/GranularSynth
+\brief
+  Definition of the OutputLimiting Enum and the OutputStage Class.
+  The OutputStage keeps the mix of every cloud within full scale, a block
+  at a time, and dithers renders that are exported as integers.
+*/
+/*****************************************************************************/
+#pragma once
+#include <JuceHeader.h>
+#include <vector>
+#include "GrainRandom.h"
+
+//! How the OutputStage Keeps the Mix Within Full Scale
+enum OutputLimiting
+{
+  SOFT_CLIP = 0,      //!< Bends Peaks Above the Knee Smoothly into Full Scale (No Latency)
+  LOOKAHEAD_LIMITER,  //!< Turns the Mix Down Ahead of Peaks, so they are Never Distorted (LookaheadMs Latency)
+  NUMBER_OF_OUTPUT_LIMITINGS
+};
+
+/**
+ *\class: OutputStage
+ *\author: Anthony Brigante
+ *\brief:
+    The OutputStage Class runs once per block over the summed output of
+    every cloud (at most two channels). The soft clipper is branch free and
+    processes four samples at a time. The limiter follows the smallest gain
+    any peak in the next LookaheadMs needs, and smooths it over the same
+    window, so the gain is already down when a peak leaves the delay line.
+
+    Prepare allocates everything, Process never allocates or locks.
+ */
+class OutputStage
+{
+public:
+
+  //! Level the Soft Clipper Starts Bending at, it Reaches Full Scale when the Input is 3 Knees Past it
+  static constexpr float SoftClipKnee = 0.8f;
+
+  //! Highest Peak the Limiter Lets Through (about -0.2 dB)
+  static constexpr float LimiterCeiling = 0.977f;
+
+  //! How Far the Limiter Looks Ahead, its Latency (in ms)
+  static constexpr double LookaheadMs = 2.0;
+
+  //! Time the Limiter Takes to Recover Most of the Way from a Peak (in ms)
+  static constexpr double ReleaseMs = 60.0;
+
+  /**
+   *\fn: Prepare
+   *\brief: Allocates the Limiter's Delay Line and Clears it. Must not be Called While Processing.
+   *\param: double sampleRate - Sample Rate of the Output
+   */
+  void Prepare(double sampleRate);
+
+  /**
+   *\fn: SetLimiting
+   *\brief: Chooses How the Mix is Kept Within Full Scale (Any Thread, Picked up by the Next Block)
+   *\param: OutputLimiting limiting - Soft Clip or Lookahead Limiter
+   */
+  void SetLimiting(OutputLimiting limiting) { mRequestedLimiting = limiting; }
+
+  /**
+   *\fn: GetLatency
+   *\brief: Gets the Delay the Current Limiting Adds
+   *\return: int - Latency (in samples)
+   */
+  int GetLatency() const { return (mRequestedLimiting == LOOKAHEAD_LIMITER) ? mLookahead - 1 : 0; }
+
+  /**
+   *\fn: Process
+   *\brief: Keeps a Block of the Mix Within Full Scale, in Place
+   *\param: AudioBuffer<float>& buffer - Mix of Every Cloud (the First Two Channels are Processed)
+   *\param: int startSample - First Sample of the Block
+   *\param: int numSamples - Number of Samples in the Block
+   */
+  void Process(AudioBuffer<float>& buffer, int startSample, int numSamples);
+
+  /**
+   *\fn: Dither
+   *\brief: Adds Triangular Dither of One Least Significant Bit, Before the Block is Written as Integers
+   *\param: AudioBuffer<float>& buffer - Block to Dither
+   *\param: int startSample - First Sample of the Block
+   *\param: int numSamples - Number of Samples in the Block
+   *\param: int bitsPerSample - Bit Depth the Block will be Written at (16 or 24)
+   */
+  void Dither(AudioBuffer<float>& buffer, int startSample, int numSamples, int bitsPerSample);
+
+  /**
+   *\fn: SoftClip
+   *\brief: Soft Clips Samples in Place, Leaving those Below the Knee Untouched
+   *\param: float* samples - Samples to Clip
+   *\param: int numSamples - Number of Samples
+   */
+  static void SoftClip(float* samples, int numSamples);
+
+private:
+
+  /**
+   *\fn: Limit
+   *\brief: Runs the Lookahead Limiter over a Block, in Place
+   *\param: float* left - Left Channel of the Block
+   *\param: float* right - Right Channel of the Block (nullptr if Mono)
+   *\param: int numSamples - Number of Samples in the Block
+   */
+  void Limit(float* left, float* right, int numSamples);
+
+  /**
+   *\fn: ResetLimiter
+   *\brief: Empties the Delay Line and Returns the Gain to Unity
+   */
+  void ResetLimiter();
+
+  std::atomic<OutputLimiting> mRequestedLimiting{ SOFT_CLIP }; //!< Limiting Chosen by SetLimiting
+  OutputLimiting mLimiting = SOFT_CLIP;  //!< Limiting of the Block Being Processed
+
+  int mLookahead = 1;                    //!< Length of the Limiter's Window (in samples)
+  float mReleaseCoefficient = 0.0f;      //!< Fraction of the Way Back to Unity the Gain Recovers per Sample
+  int64 mFrame = 0;                      //!< Frames Limited Since the Last Reset
+
+  std::vector<float> mDelay[2];          //!< Delay Line of Each Channel, mLookahead Samples
+  std::vector<float> mWindowGain;        //!< Gains of the Sliding Minimum, Increasing from Front to Back
+  std::vector<int64> mWindowFrame;       //!< Frames the Gains of the Sliding Minimum were Needed at
+  int mWindowFront = 0;                  //!< Oldest Entry of the Sliding Minimum
+  int mWindowCount = 0;                  //!< Number of Entries in the Sliding Minimum
+  std::vector<float> mSmoothing;         //!< The Last mLookahead Released Gains, Averaged into the Output Gain
+  double mSmoothingSum = 0.0;            //!< Sum of mSmoothing
+  float mReleasedGain = 1.0f;            //!< Gain After the Release
+
+  GrainRandom mDitherRandom;             //!< Random Number Generator of the Dither
+};
@@ -0,0 +1,137 @@
+/*****************************************************************************/
+/*!
+\file   PeakCache.cpp
+\author Anthony Brigante
+\par    email: anthonypbrigante\@gmail.com
+\par    GitHub Repository: https://github.com/abrigante1/GranularSynth
+\brief
+  Implementation of the PeakCache Class.
+*/
+/*****************************************************************************/
+
+#include "PeakCache.h"
+#include <algorithm>
+#include <vector>
+
+// ------------------------------------------------------------------------------------
+// ------------------------------------------------------------------------------------
+// ------------------------------------------------------------------------------------
+
+PeakCache::PeakCache(const File& directory, int64 maxBytes)
+  : mDirectory(directory), mMaxBytes(maxBytes)
+{
+}
+
+// ------------------------------------------------------------------------------------
+
+File PeakCache::GetDefaultDirectory()
+{
+  return File::getSpecialLocation(File::userApplicationDataDirectory).getChildFile("GranularSynth")
+                                                                     .getChildFile("PeakCache");
+}
+
+// ------------------------------------------------------------------------------------
+
+std::unique_ptr<PeakPyramid> PeakCache::Load(const File& file, double sampleRate) const
+{
+  const String key = GetKey(file, sampleRate);
+  const File entry = GetEntry(key);
+
+  if (!entry.existsAsFile())
+    return nullptr;
+
+  std::unique_ptr<PeakPyramid> peaks;
+
+  {
+    FileInputStream input(entry);
+
+    if (!input.openedOk() || input.readInt() != Magic || input.readInt() != Version || input.readString() != key)
+      return nullptr;
+
+    peaks = PeakPyramid::Read(input);
+  }
+
+  // Mark the Entry as Used, Eviction Goes by Modification Time
+  if (peaks != nullptr)
+    entry.setLastModificationTime(Time::getCurrentTime());
+
+  return peaks;
+}
+
+// ------------------------------------------------------------------------------------
+
+void PeakCache::Store(const File& file, const PeakPyramid& peaks) const
+{
+  if (!mDirectory.createDirectory())
+    return;
+
+  const String key = GetKey(file, peaks.GetSampleRate());
+  TemporaryFile entry(GetEntry(key));
+
+  {
+    FileOutputStream output(entry.getFile());
+
+    if (!output.openedOk())
+      return;
+
+    output.writeInt(Magic);
+    output.writeInt(Version);
+    output.writeString(key);
+
+    if (!peaks.Write(output))
+      return;
+
+    output.flush();
+  }
+
+  if (entry.overwriteTargetFileWithTemporary())
+    Evict();
+}
+
+// ------------------------------------------------------------------------------------
+
+String PeakCache::GetKey(const File& file, double sampleRate)
+{
+  return file.getFullPathName() + "|" + String(file.getSize()) + "|"
+         + String(file.getLastModificationTime().toMilliseconds()) + "|" + String(sampleRate);
+}
+
+// ------------------------------------------------------------------------------------
+
+File PeakCache::GetEntry(const String& key) const
+{
+  return mDirectory.getChildFile(String::toHexString(key.hashCode64()) + ".peaks");
+}
+
+// ------------------------------------------------------------------------------------
+
+void PeakCache::Evict() const
+{
+  struct Entry
+  {
+    File mFile;
+    int64 mSize;
+    int64 mLastUsed;
+  };
+
+  std::vector<Entry> entries;
+  int64 totalBytes = 0;
+
+  for (const File& file : mDirectory.findChildFiles(File::findFiles, false, "*.peaks"))
+  {
+    entries.push_back({ file, file.getSize(), file.getLastModificationTime().toMilliseconds() });
+    totalBytes += entries.back().mSize;
+  }
+
+  // Oldest First
+  std::sort(entries.begin(), entries.end(), [](const Entry& a, const Entry& b) { return a.mLastUsed < b.mLastUsed; });
+
+  for (const Entry& entry : entries)
+  {
+    if (totalBytes <= mMaxBytes)
+      break;
+
+    if (entry.mFile.deleteFile())
+      totalBytes -= entry.mSize;
+  }
+}
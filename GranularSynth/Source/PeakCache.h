@@ -0,0 +1,104 @@
+/*****************************************************************************/
+/*!
+\file   PeakCache.h
+\author Anthony Brigante
+\par    email: anthonypbrigante\@gmail.com
+\par    GitHub Repository: https://github.com/abrigante1/GranularSynth
+\brief
+  Definition of the PeakCache Class, which Keeps the PeakPyramids of
+  Recently Opened Files on Disk Between Sessions.
+*/
+/*****************************************************************************/
+#pragma once
+#include <JuceHeader.h>
+#include "PeakPyramid.h"
+
+/**
+ *\class: PeakCache
+ *\author: Anthony Brigante
+ *\brief:
+    The PeakCache Class stores a PeakPyramid per audio file in a directory,
+    one cache file each. An entry is keyed by the file's path, size and
+    modification time and by the sample rate the peaks were scanned at, so
+    an edited file or a reload at another rate is simply a miss.
+
+    Reading an entry back costs one sequential read of level 0, instead
+    of a scan of the whole source (all of it read from disk when the source
+    is memory mapped). Hits touch their entry, and Store deletes the least
+    recently used entries until the directory is back under its size cap.
+    Entries are written to a temporary file and moved into place, so a
+    crash never leaves a partial entry behind.
+ */
+class PeakCache
+{
+public:
+
+  //! Default Size Cap of the Cache Directory (in bytes)
+  static constexpr int64 DefaultMaxBytes = static_cast<int64>(512) * 1024 * 1024;
+
+  /**
+   *\fn: PeakCache
+   *\brief: Constructor for a PeakCache
+   *\param: const File& directory - Directory Holding the Entries (Created on the First Store)
+   *\param: int64 maxBytes - Size Cap of the Directory (in bytes)
+   */
+  explicit PeakCache(const File& directory = GetDefaultDirectory(), int64 maxBytes = DefaultMaxBytes);
+
+  /**
+   *\fn: GetDefaultDirectory
+   *\brief: Gets the Cache Directory in the User's Application Data
+   *\return: File - The Default Cache Directory
+   */
+  static File GetDefaultDirectory();
+
+  /**
+   *\fn: Load
+   *\brief: Reads the Peaks of a File if they are Cached
+   *\param: const File& file - Audio File the Peaks Summarise
+   *\param: double sampleRate - Sample Rate the Peaks were Scanned at
+   *\return: std::unique_ptr<PeakPyramid> - The Cached Peaks, or nullptr on a Miss
+   */
+  std::unique_ptr<PeakPyramid> Load(const File& file, double sampleRate) const;
+
+  /**
+   *\fn: Store
+   *\brief: Caches the Peaks of a File, then Evicts the Least Recently Used Entries Over the Cap
+   *\param: const File& file - Audio File the Peaks Summarise
+   *\param: const PeakPyramid& peaks - The Peaks
+   */
+  void Store(const File& file, const PeakPyramid& peaks) const;
+
+private:
+
+  //! First Four Bytes of Every Entry ("GSPK")
+  static constexpr int Magic = 0x4b505347;
+
+  //! Version of the Entry Layout, Bumped Whenever it Changes
+  static constexpr int Version = 1;
+
+  File mDirectory;    //!< Directory Holding the Entries
+  int64 mMaxBytes;    //!< Size Cap of the Directory (in bytes)
+
+  /**
+   *\fn: GetKey
+   *\brief: Describes Everything an Entry Depends on
+   *\param: const File& file - Audio File the Peaks Summarise
+   *\param: double sampleRate - Sample Rate the Peaks were Scanned at
+   *\return: String - Path, Size, Modification Time and Sample Rate
+   */
+  static String GetKey(const File& file, double sampleRate);
+
+  /**
+   *\fn: GetEntry
+   *\brief: Gets the Cache File of a Key (Keys are Stored in their Entries, so Hash Collisions are Misses)
+   *\param: const String& key - Key from GetKey
+   *\return: File - The Entry
+   */
+  File GetEntry(const String& key) const;
+
+  /**
+   *\fn: Evict
+   *\brief: Deletes the Least Recently Used Entries Until the Directory is Under the Cap
+   */
+  void Evict() const;
+};
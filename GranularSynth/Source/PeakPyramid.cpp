@@ -0,0 +1,307 @@
+/*****************************************************************************/
+/*!
+\file   PeakPyramid.cpp
+\author Anthony Brigante
+\par    email: anthonypbrigante\@gmail.com
+\par    GitHub Repository: https://github.com/abrigante1/GranularSynth
+\brief
+  Implementation of the PeakPyramid Class.
+*/
+/*****************************************************************************/
+
+#include "PeakPyramid.h"
+#include <atomic>
+#include <cmath>
+#include <vector>
+
+namespace
+{
+  /**
+   *\fn: ScanChannel
+   *\brief: Summarises a Run of Level 0 Bins of One Channel
+   *\tparam: Reader - SourceReaders Struct Matching the Format of the Samples
+   *\param: const char* samples - First Sample of the Channel
+   *\param: int frameStride - Bytes Between Consecutive Samples
+   *\param: int64 length - Number of Samples in the Channel
+   *\param: int64 firstBin - First Bin to Summarise
+   *\param: int64 endBin - Bin After the Last Bin to Summarise
+   *\param: PeakBin* bins - Bins of the Channel, Indexed from Bin 0
+   */
+  template <typename Reader>
+  void ScanChannel(const char* samples, int frameStride, int64 length, int64 firstBin, int64 endBin, PeakBin* bins)
+  {
+    for (int64 bin = firstBin; bin < endBin; ++bin)
+    {
+      const int64 start = bin * PeakPyramid::BaseSamplesPerBin;
+      const int64 end = jmin(length, start + PeakPyramid::BaseSamplesPerBin);
+
+      const char* sample = samples + start * frameStride;
+      float low = Reader::Read(sample);
+      float high = low;
+      float sumSquares = 0.0f;
+
+      for (int64 i = start; i < end; ++i, sample += frameStride)
+      {
+        const float value = Reader::Read(sample);
+        low = jmin(low, value);
+        high = jmax(high, value);
+        sumSquares += value * value;
+      }
+
+      bins[bin].mMin = low;
+      bins[bin].mMax = high;
+      bins[bin].mRms = std::sqrt(sumSquares / static_cast<float>(end - start));
+    }
+  }
+}
+
+// ------------------------------------------------------------------------------------
+// ------------------------------------------------------------------------------------
+// ------------------------------------------------------------------------------------
+
+std::unique_ptr<PeakPyramid> PeakPyramid::Build(const SourceAudio& audio, ThreadPool& pool)
+{
+  std::unique_ptr<PeakPyramid> peaks(new PeakPyramid());
+  const GrainSource& source = audio.GetSource();
+
+  peaks->mNumChannels = jlimit(1, 2, audio.GetNumChannels());
+  peaks->mLength = source.mLength;
+  peaks->mSampleRate = audio.GetSampleRate();
+
+  Level base;
+  base.mNumBins = (source.mLength + BaseSamplesPerBin - 1) / BaseSamplesPerBin;
+
+  for (int channel = 0; channel < peaks->mNumChannels; ++channel)
+    base.mBins[channel].resize(static_cast<size_t>(base.mNumBins));
+
+  peaks->mLevels.push_back(std::move(base));
+
+  if (!source.IsValid())
+    return peaks;
+
+  // Every Thread Pulls Runs of Bins Until None are Left, the Calling Thread Included
+  const int64 numJobs = (peaks->mLevels[0].mNumBins + BinsPerJob - 1) / BinsPerJob;
+  std::atomic<int64> nextJob{ 0 };
+
+  auto scan = [&]()
+  {
+    for (int64 job = nextJob++; job < numJobs; job = nextJob++)
+      peaks->ScanBins(source, job * BinsPerJob, jmin(peaks->mLevels[0].mNumBins, (job + 1) * BinsPerJob));
+  };
+
+  // Helpers Reference this Frame, so Wait for Every One to Return, not just for the Bins to be Done
+  const int numHelpers = static_cast<int>(jmin(static_cast<int64>(pool.getNumThreads()), numJobs - 1));
+  std::atomic<int> helpersRunning{ numHelpers };
+  WaitableEvent helpersFinished;
+
+  for (int i = 0; i < numHelpers; ++i)
+  {
+    pool.addJob([&]()
+    {
+      scan();
+
+      if (--helpersRunning == 0)
+        helpersFinished.signal();
+    });
+  }
+
+  scan();
+
+  if (numHelpers > 0)
+    helpersFinished.wait(-1);
+
+  peaks->MergeLevels();
+  return peaks;
+}
+
+// ------------------------------------------------------------------------------------
+
+std::unique_ptr<PeakPyramid> PeakPyramid::Read(InputStream& input)
+{
+  std::unique_ptr<PeakPyramid> peaks(new PeakPyramid());
+
+  peaks->mNumChannels = input.readInt();
+  peaks->mLength = input.readInt64();
+  peaks->mSampleRate = input.readDouble();
+
+  Level base;
+  base.mNumBins = input.readInt64();
+
+  if (peaks->mNumChannels < 1 || peaks->mNumChannels > 2 || peaks->mLength < 0 || peaks->mSampleRate <= 0.0
+      || base.mNumBins != (peaks->mLength + BaseSamplesPerBin - 1) / BaseSamplesPerBin)
+    return nullptr;
+
+  // Min, Max and RMS of Each Bin, Scaled to 16 Bits
+  std::vector<int16> values(static_cast<size_t>(base.mNumBins) * 3);
+  const int numBytes = static_cast<int>(values.size() * sizeof(int16));
+
+  for (int channel = 0; channel < peaks->mNumChannels; ++channel)
+  {
+    if (input.read(values.data(), numBytes) != numBytes)
+      return nullptr;
+
+    std::vector<PeakBin>& bins = base.mBins[channel];
+    bins.resize(static_cast<size_t>(base.mNumBins));
+
+    for (size_t bin = 0; bin < bins.size(); ++bin)
+    {
+      bins[bin].mMin = values[3 * bin] * (1.0f / 32767.0f);
+      bins[bin].mMax = values[3 * bin + 1] * (1.0f / 32767.0f);
+      bins[bin].mRms = values[3 * bin + 2] * (1.0f / 32767.0f);
+    }
+  }
+
+  peaks->mLevels.push_back(std::move(base));
+  peaks->MergeLevels();
+  return peaks;
+}
+
+// ------------------------------------------------------------------------------------
+
+bool PeakPyramid::Write(OutputStream& output) const
+{
+  const Level& base = mLevels[0];
+
+  output.writeInt(mNumChannels);
+  output.writeInt64(mLength);
+  output.writeDouble(mSampleRate);
+  output.writeInt64(base.mNumBins);
+
+  auto scale = [](float value) { return jlimit(-1.0f, 1.0f, value) * 32767.0f; };
+
+  std::vector<int16> values(static_cast<size_t>(base.mNumBins) * 3);
+
+  for (int channel = 0; channel < mNumChannels; ++channel)
+  {
+    const std::vector<PeakBin>& bins = base.mBins[channel];
+
+    for (size_t bin = 0; bin < bins.size(); ++bin)
+    {
+      // Min and Max are Rounded Outwards, so the Drawn Peaks Never Shrink
+      values[3 * bin] = static_cast<int16>(std::floor(scale(bins[bin].mMin)));
+      values[3 * bin + 1] = static_cast<int16>(std::ceil(scale(bins[bin].mMax)));
+      values[3 * bin + 2] = static_cast<int16>(std::round(scale(bins[bin].mRms)));
+    }
+
+    if (!output.write(values.data(), values.size() * sizeof(int16)))
+      return false;
+  }
+
+  return true;
+}
+
+// ------------------------------------------------------------------------------------
+
+PeakBin PeakPyramid::GetPeak(int channel, int64 startSample, int64 endSample) const
+{
+  PeakBin peak;
+
+  if (mLevels.empty() || mLength == 0)
+    return peak;
+
+  channel = jmin(channel, mNumChannels - 1);
+  startSample = jlimit(static_cast<int64>(0), mLength - 1, startSample);
+  endSample = jlimit(startSample + 1, mLength, endSample);
+
+  const int level = GetLevel(endSample - startSample);
+  const int64 samplesPerBin = GetSamplesPerBin(level);
+  const Level& bins = mLevels[static_cast<size_t>(level)];
+
+  const int64 firstBin = startSample / samplesPerBin;
+  const int64 endBin = jlimit(firstBin + 1, bins.mNumBins, (endSample + samplesPerBin - 1) / samplesPerBin);
+
+  const PeakBin* bin = bins.mBins[channel].data() + firstBin;
+  peak = *bin;
+  float sumSquares = 0.0f;
+
+  for (int64 i = firstBin; i < endBin; ++i, ++bin)
+  {
+    peak.mMin = jmin(peak.mMin, bin->mMin);
+    peak.mMax = jmax(peak.mMax, bin->mMax);
+    sumSquares += bin->mRms * bin->mRms;
+  }
+
+  peak.mRms = std::sqrt(sumSquares / static_cast<float>(endBin - firstBin));
+  return peak;
+}
+
+// ------------------------------------------------------------------------------------
+
+int PeakPyramid::GetLevel(int64 numSamples) const
+{
+  int level = 0;
+
+  while (level + 1 < GetNumLevels() && GetSamplesPerBin(level + 1) <= numSamples)
+    ++level;
+
+  return level;
+}
+
+// ------------------------------------------------------------------------------------
+
+void PeakPyramid::ScanBins(const GrainSource& source, int64 firstBin, int64 endBin)
+{
+  for (int channel = 0; channel < mNumChannels; ++channel)
+  {
+    const char* samples = (channel == 0) ? source.mLeft : source.mRight;
+    PeakBin* bins = mLevels[0].mBins[channel].data();
+
+    switch (source.mFormat)
+    {
+      case FLOAT_32_GUARDED:
+        ScanChannel<SourceReaders::GuardedFloat32>(samples, source.mFrameStride, source.mLength, firstBin, endBin, bins);
+        break;
+
+      case FLOAT_32:
+        ScanChannel<SourceReaders::Float32>(samples, source.mFrameStride, source.mLength, firstBin, endBin, bins);
+        break;
+
+      case INT_16:
+        ScanChannel<SourceReaders::Int16>(samples, source.mFrameStride, source.mLength, firstBin, endBin, bins);
+        break;
+
+      case INT_24:
+        ScanChannel<SourceReaders::Int24>(samples, source.mFrameStride, source.mLength, firstBin, endBin, bins);
+        break;
+
+      case INT_32:
+        ScanChannel<SourceReaders::Int32>(samples, source.mFrameStride, source.mLength, firstBin, endBin, bins);
+        break;
+
+      default:
+        break;
+    }
+  }
+}
+
+// ------------------------------------------------------------------------------------
+
+void PeakPyramid::MergeLevels()
+{
+  while (mLevels.back().mNumBins > MinBinsPerLevel)
+  {
+    const Level& finer = mLevels.back();
+
+    Level coarser;
+    coarser.mNumBins = (finer.mNumBins + 1) / 2;
+
+    for (int channel = 0; channel < mNumChannels; ++channel)
+    {
+      const std::vector<PeakBin>& from = finer.mBins[channel];
+      std::vector<PeakBin>& to = coarser.mBins[channel];
+      to.resize(static_cast<size_t>(coarser.mNumBins));
+
+      for (size_t bin = 0; bin < to.size(); ++bin)
+      {
+        const PeakBin& a = from[2 * bin];
+        const PeakBin& b = (2 * bin + 1 < from.size()) ? from[2 * bin + 1] : a;
+
+        to[bin].mMin = jmin(a.mMin, b.mMin);
+        to[bin].mMax = jmax(a.mMax, b.mMax);
+        to[bin].mRms = std::sqrt(0.5f * (a.mRms * a.mRms + b.mRms * b.mRms));
+      }
+    }
+
+    mLevels.push_back(std::move(coarser));
+  }
+}
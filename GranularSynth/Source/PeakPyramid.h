@@ -0,0 +1,170 @@
+/*****************************************************************************/
+/*!
+\file   PeakPyramid.h
+\author Anthony Brigante
+\par    email: anthonypbrigante\@gmail.com
+\par    GitHub Repository: https://github.com/abrigante1/GranularSynth
+\brief
+  Definition of the PeakBin Struct and the PeakPyramid Class, the
+  Min/Max/RMS Summary of a SourceAudio the Waveform View is Drawn From.
+*/
+/*****************************************************************************/
+#pragma once
+#include <JuceHeader.h>
+#include <vector>
+#include "GrainSource.h"
+
+/**
+ *\struct: PeakBin
+ *\author: Anthony Brigante
+ *\brief:
+    The PeakBin Struct summarises a run of samples of one channel.
+ */
+struct PeakBin
+{
+  float mMin = 0.0f;  //!< Lowest Sample
+  float mMax = 0.0f;  //!< Highest Sample
+  float mRms = 0.0f;  //!< Root Mean Square of the Samples
+};
+
+/**
+ *\class: PeakPyramid
+ *\author: Anthony Brigante
+ *\brief:
+    The PeakPyramid Class holds PeakBins of a source at several zoom levels.
+    Level 0 has a bin per BaseSamplesPerBin samples, and each level after it
+    merges pairs of bins of the one before, down to MinBinsPerLevel bins.
+    GetPeak summarises any range of samples from the coarsest level that
+    still resolves it, so drawing costs the same at every zoom.
+
+    Level 0 is scanned straight from the SourceAudio (decoded or mapped)
+    by every thread of a ThreadPool at once. The other levels are merged
+    from it, which costs half as much again as a single level.
+
+    Only level 0 is written to a stream (see PeakCache), as 16 bit values.
+    Read merges the other levels again.
+ */
+class PeakPyramid
+{
+public:
+
+  //! Samples Summarised by Each Bin of Level 0
+  static constexpr int BaseSamplesPerBin = 64;
+
+  //! Levels Stop Once they are Down to this Many Bins
+  static constexpr int MinBinsPerLevel = 256;
+
+  //! Bins of Level 0 Scanned by Each Job
+  static constexpr int BinsPerJob = 4096;
+
+  /**
+   *\fn: Build
+   *\brief: Scans a Source into a New Pyramid. Slow for Long Sources, so Call Off the Message Thread.
+   *\param: const SourceAudio& audio - Audio to Summarise (Only the First Two Channels)
+   *\param: ThreadPool& pool - Threads that Share the Scan with the Calling Thread
+   *\return: std::unique_ptr<PeakPyramid> - The Pyramid
+   */
+  static std::unique_ptr<PeakPyramid> Build(const SourceAudio& audio, ThreadPool& pool);
+
+  /**
+   *\fn: Read
+   *\brief: Reads a Pyramid Written by Write
+   *\param: InputStream& input - Stream Positioned at the Start of the Pyramid
+   *\return: std::unique_ptr<PeakPyramid> - The Pyramid, or nullptr if the Stream is Truncated or Corrupt
+   */
+  static std::unique_ptr<PeakPyramid> Read(InputStream& input);
+
+  /**
+   *\fn: Write
+   *\brief: Writes Level 0 of the Pyramid, in the Host's Byte Order
+   *\param: OutputStream& output - Stream to Write to
+   *\return: bool - False if the Stream could not be Written
+   */
+  bool Write(OutputStream& output) const;
+
+  /**
+   *\fn: GetPeak
+   *\brief: Summarises a Range of Samples of a Channel
+   *\param: int channel - Channel (Mono Pyramids Return Channel 0 for Channel 1)
+   *\param: int64 startSample - First Sample of the Range
+   *\param: int64 endSample - Sample After the Last Sample of the Range
+   *\return: PeakBin - Min, Max and RMS of the Bins Covering the Range
+   */
+  PeakBin GetPeak(int channel, int64 startSample, int64 endSample) const;
+
+  /**
+   *\fn: GetLevel
+   *\brief: Picks the Coarsest Level Whose Bins are no Wider than a Range
+   *\param: int64 numSamples - Samples in the Range (a Pixel's Worth, When Drawing)
+   *\return: int - Level to Read
+   */
+  int GetLevel(int64 numSamples) const;
+
+  /**
+   *\fn: GetSamplesPerBin
+   *\brief: Gets the Samples Summarised by Each Bin of a Level
+   *\param: int level - Level
+   *\return: int64 - Samples per Bin
+   */
+  int64 GetSamplesPerBin(int level) const { return static_cast<int64>(BaseSamplesPerBin) << level; }
+
+  /**
+   *\fn: GetNumLevels
+   *\brief: Gets the Number of Zoom Levels
+   *\return: int - Number of Levels
+   */
+  int GetNumLevels() const { return static_cast<int>(mLevels.size()); }
+
+  /**
+   *\fn: GetNumChannels
+   *\brief: Gets the Number of Channels Summarised
+   *\return: int - Number of Channels (1 or 2)
+   */
+  int GetNumChannels() const { return mNumChannels; }
+
+  /**
+   *\fn: GetLength
+   *\brief: Gets the Length of the Summarised Source
+   *\return: int64 - Number of Samples per Channel
+   */
+  int64 GetLength() const { return mLength; }
+
+  /**
+   *\fn: GetSampleRate
+   *\brief: Gets the Sample Rate of the Summarised Source
+   *\return: double - Sample Rate (in Hz)
+   */
+  double GetSampleRate() const { return mSampleRate; }
+
+private:
+
+  /**
+   *\struct: Level
+   *\brief: Bins of One Zoom Level, Channel by Channel
+   */
+  struct Level
+  {
+    int64 mNumBins = 0;               //!< Bins per Channel
+    std::vector<PeakBin> mBins[2];    //!< Bins of Each Channel (Channel 1 is Empty when Mono)
+  };
+
+  std::vector<Level> mLevels;   //!< Zoom Levels, Finest First
+  int mNumChannels = 0;         //!< Number of Channels Summarised
+  int64 mLength = 0;            //!< Number of Samples per Channel
+  double mSampleRate = 0.0;     //!< Sample Rate of the Source
+
+  /**
+   *\fn: ScanBins
+   *\brief: Summarises a Run of Level 0 Bins of Every Channel from the Source
+   *\param: const GrainSource& source - View of the Samples
+   *\param: int64 firstBin - First Bin to Summarise
+   *\param: int64 endBin - Bin After the Last Bin to Summarise
+   */
+  void ScanBins(const GrainSource& source, int64 firstBin, int64 endBin);
+
+  /**
+   *\fn: MergeLevels
+   *\brief: Builds Every Level After Level 0 by Merging Pairs of Bins
+   */
+  void MergeLevels();
+};
@@ -0,0 +1,152 @@
+/*****************************************************************************/
+/*!
+\file   PolyphaseResampler.cpp
+\author Anthony Brigante
+\par    email: anthonypbrigante\@gmail.com
+\par    GitHub Repository: https://github.com/abrigante1/GranularSynth
+\brief
+  Implementation of the PolyphaseResampler Class.
+*/
+/*****************************************************************************/
+
+#include "PolyphaseResampler.h"
+#include <cmath>
+
+namespace
+{
+  const double KaiserBeta = 8.6;  //!< Kaiser Window Shape (about 90 dB of Stopband Attenuation)
+  const double Rolloff = 0.94;    //!< Cutoff of the Filters, Relative to the Lower Nyquist Frequency
+
+  /**
+   *\fn: BesselI0
+   *\brief: Evaluates the Zeroth Order Modified Bessel Function of the First Kind
+   *\param: double x - Point to Evaluate
+   *\return: double - I0(x)
+   */
+  double BesselI0(double x)
+  {
+    double sum = 1.0;
+    double term = 1.0;
+    const double halfX = 0.5 * x;
+
+    for (int k = 1; k < 64 && term > sum * 1e-12; ++k)
+    {
+      term *= (halfX / k) * (halfX / k);
+      sum += term;
+    }
+
+    return sum;
+  }
+
+  /**
+   *\fn: GreatestCommonDivisor
+   *\brief: Finds the Greatest Common Divisor of Two Positive Integers
+   *\param: int64 a - First Integer
+   *\param: int64 b - Second Integer
+   *\return: int64 - The Greatest Common Divisor
+   */
+  int64 GreatestCommonDivisor(int64 a, int64 b)
+  {
+    while (b != 0)
+    {
+      const int64 remainder = a % b;
+      a = b;
+      b = remainder;
+    }
+
+    return a;
+  }
+}
+
+// ------------------------------------------------------------------------------------
+// ------------------------------------------------------------------------------------
+// ------------------------------------------------------------------------------------
+
+PolyphaseResampler::PolyphaseResampler(double inputRate, double outputRate)
+{
+  jassert(inputRate > 0.0 && outputRate > 0.0);
+
+  // Reduce the Ratio to Output / Input = L / M
+  const int64 input = jmax<int64>(1, static_cast<int64>(std::llround(inputRate)));
+  const int64 output = jmax<int64>(1, static_cast<int64>(std::llround(outputRate)));
+  const int64 divisor = GreatestCommonDivisor(input, output);
+
+  mInputStep = input / divisor;
+  mOutputStep = output / divisor;
+  mNumPhases = static_cast<int>(jmin<int64>(mOutputStep, MaxPhases));
+
+  // Downsampling Lowers the Cutoff Below the Output's Nyquist Frequency, which Widens the Filters
+  const double bandwidth = jmin(1.0, static_cast<double>(output) / static_cast<double>(input));
+  const double cutoff = bandwidth * Rolloff;
+  const int halfWidth = static_cast<int>(std::ceil(HalfTaps / bandwidth));
+
+  mNumTaps = 2 * halfWidth;
+  mFirstTap = 1 - halfWidth;
+  mFilters.assign(static_cast<size_t>(mNumPhases) * static_cast<size_t>(mNumTaps), 0.0f);
+
+  const double pi = MathConstants<double>::pi;
+  const double windowNormal = 1.0 / BesselI0(KaiserBeta);
+
+  for (int phase = 0; phase < mNumPhases; ++phase)
+  {
+    const double fraction = static_cast<double>(phase) / mNumPhases;
+    float* filter = mFilters.data() + static_cast<size_t>(phase) * static_cast<size_t>(mNumTaps);
+    double sum = 0.0;
+
+    for (int tap = 0; tap < mNumTaps; ++tap)
+    {
+      // Distance (in Input Samples) of the Tap from the Read Position
+      const double x = (mFirstTap + tap) - fraction;
+      const double windowPosition = x / halfWidth;
+
+      if (std::abs(windowPosition) >= 1.0)
+        continue;
+
+      const double sinc = (std::abs(x) < 1e-9) ? 1.0 : std::sin(pi * cutoff * x) / (pi * cutoff * x);
+      const double window = BesselI0(KaiserBeta * std::sqrt(1.0 - windowPosition * windowPosition)) * windowNormal;
+      const double weight = sinc * window;
+
+      filter[tap] = static_cast<float>(weight);
+      sum += weight;
+    }
+
+    // Unity Gain at DC for Every Phase
+    for (int tap = 0; tap < mNumTaps; ++tap)
+      filter[tap] = static_cast<float>(filter[tap] / sum);
+  }
+}
+
+// ------------------------------------------------------------------------------------
+
+int64 PolyphaseResampler::GetOutputLength(int64 inputLength) const
+{
+  return (inputLength * mOutputStep + mInputStep - 1) / mInputStep;
+}
+
+// ------------------------------------------------------------------------------------
+
+void PolyphaseResampler::Process(const float* input, int64 inputLength, float* output) const
+{
+  const int64 outputLength = GetOutputLength(inputLength);
+
+  // The Read Position is base + (phase / L), Tracked Exactly in Integers
+  int64 base = 0;
+  int64 phase = 0;
+
+  for (int64 i = 0; i < outputLength; ++i)
+  {
+    const int64 row = (mNumPhases == mOutputStep) ? phase : (phase * mNumPhases) / mOutputStep;
+    const float* filter = mFilters.data() + row * mNumTaps;
+    const float* samples = input + base + mFirstTap;
+
+    float sum = 0.0f;
+    for (int tap = 0; tap < mNumTaps; ++tap)
+      sum += filter[tap] * samples[tap];
+
+    output[i] = sum;
+
+    phase += mInputStep;
+    base += phase / mOutputStep;
+    phase %= mOutputStep;
+  }
+}
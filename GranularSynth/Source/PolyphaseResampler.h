@@ -0,0 +1,82 @@
+/*****************************************************************************/
+/*!
+\file   PolyphaseResampler.h
+\author Anthony Brigante
+\par    email: anthonypbrigante\@gmail.com
+\par    GitHub Repository: https://github.com/abrigante1/GranularSynth
+\brief
+  Definition of the PolyphaseResampler Class.
+  Converts whole sources between sample rates with a bank of Kaiser
+  windowed sinc filters, one per phase of the rate ratio.
+*/
+/*****************************************************************************/
+#pragma once
+#include <JuceHeader.h>
+#include <vector>
+
+/**
+ *\class: PolyphaseResampler
+ *\author: Anthony Brigante
+ *\brief:
+    The PolyphaseResampler Class converts audio from one sample rate to
+    another. The ratio is reduced to Output / Input = L / M, and each of the
+    L phases of the ratio gets its own precomputed filter, so every output
+    sample is a single dot product with no trigonometry. Ratios with more
+    than MaxPhases phases quantise the filter phase (never the read
+    position, so the pitch stays exact). When downsampling, the filters are
+    widened and their cutoff lowered below the new Nyquist frequency.
+
+    Meant for converting a source once, off the audio thread.
+ */
+class PolyphaseResampler
+{
+public:
+
+  //! Zero Crossings of the Filters on Each Side, when Upsampling (Downsampling Widens them)
+  static constexpr int HalfTaps = 16;
+
+  //! Largest Number of Filters in the Bank
+  static constexpr int MaxPhases = 4096;
+
+  /**
+   *\fn: PolyphaseResampler
+   *\brief: Constructor for a PolyphaseResampler, Builds the Filter Bank
+   *\param: double inputRate - Sample Rate of the Input (in Hz)
+   *\param: double outputRate - Sample Rate of the Output (in Hz)
+   */
+  PolyphaseResampler(double inputRate, double outputRate);
+
+  /**
+   *\fn: GetOutputLength
+   *\brief: Gets the Number of Samples Process Writes for an Input
+   *\param: int64 inputLength - Number of Input Samples
+   *\return: int64 - Number of Output Samples
+   */
+  int64 GetOutputLength(int64 inputLength) const;
+
+  /**
+   *\fn: GetPadding
+   *\brief: Gets the Number of Zero Samples Process Reads Before and After the Input
+   *\return: int - Number of Padding Samples on Each Side
+   */
+  int GetPadding() const { return mNumTaps; }
+
+  /**
+   *\fn: Process
+   *\brief: Resamples One Channel
+   *\param: const float* input - First Input Sample, Preceded and Followed by GetPadding() Zeros
+   *\param: int64 inputLength - Number of Input Samples (Excluding the Padding)
+   *\param: float* output - Receives GetOutputLength(inputLength) Samples
+   */
+  void Process(const float* input, int64 inputLength, float* output) const;
+
+private:
+
+  int64 mInputStep = 1;   //!< M, Input Samples Advanced per L Output Samples
+  int64 mOutputStep = 1;  //!< L, Number of Phases of the Ratio
+  int mNumPhases = 1;     //!< Number of Filters in the Bank (L, at most MaxPhases)
+  int mNumTaps = 0;       //!< Length of Each Filter
+  int mFirstTap = 0;      //!< Offset of the First Tap from the Truncated Read Position
+
+  std::vector<float> mFilters; //!< Filter Bank, mNumPhases Rows of mNumTaps Weights
+};
@@ -0,0 +1,41 @@
+/*****************************************************************************/
+/*!
+\file   SourceBuffer.cpp
+\author Anthony Brigante
+\par    email: anthonypbrigante\@gmail.com
+\par    GitHub Repository: https://github.com/abrigante1/GranularSynth
+\brief
+  Implementation of the SourceBuffer Class.
+*/
+/*****************************************************************************/
+
+#include "SourceBuffer.h"
+#include <cstdint>
+
+// ------------------------------------------------------------------------------------
+// ------------------------------------------------------------------------------------
+// ------------------------------------------------------------------------------------
+
+void SourceBuffer::Allocate(int numChannels, int64 length)
+{
+  jassert(numChannels >= 1 && numChannels <= 2 && length >= 0);
+  static_assert((GuardSamples * sizeof(float)) % Alignment == 0, "The Guards Must Keep the Samples Aligned");
+
+  const size_t alignmentFloats = Alignment / sizeof(float);
+
+  // Each Channel is [Guard | Samples | Guard], Rounded up to Whole Cache Lines
+  const size_t channelFloats = ((static_cast<size_t>(length) + 2 * GuardSamples + alignmentFloats - 1)
+                                / alignmentFloats) * alignmentFloats;
+
+  // Zero Initialised, which Silences the Guards
+  mStorage.reset(new float[channelFloats * static_cast<size_t>(numChannels) + alignmentFloats]());
+
+  const uintptr_t address = reinterpret_cast<uintptr_t>(mStorage.get());
+  float* aligned = mStorage.get() + ((Alignment - (address % Alignment)) % Alignment) / sizeof(float);
+
+  mNumChannels = numChannels;
+  mLength = length;
+
+  for (int channel = 0; channel < 2; ++channel)
+    mChannels[channel] = aligned + channelFloats * static_cast<size_t>(jmin(channel, numChannels - 1)) + GuardSamples;
+}
@@ -0,0 +1,81 @@
+/*****************************************************************************/
+/*!
+\file   SourceBuffer.h
+\author Anthony Brigante
+\par    email: anthonypbrigante\@gmail.com
+\par    GitHub Repository: https://github.com/abrigante1/GranularSynth
+\brief
+  Definition of the SourceBuffer Class, the In-Memory Layout of the Audio
+  a GrainCloud Reads: Float Channels, 64 Byte Aligned and Surrounded by
+  Silent Guard Samples.
+*/
+/*****************************************************************************/
+#pragma once
+#include <JuceHeader.h>
+#include <memory>
+
+/**
+ *\class: SourceBuffer
+ *\author: Anthony Brigante
+ *\brief:
+    The SourceBuffer Class holds the decoded audio of a source as one or two
+    float channels. Each channel starts on a 64 byte boundary and is preceded
+    and followed by GuardSamples zeros, so interpolators may read a few
+    samples past either end of the audio without being clamped. A mono
+    buffer returns its one channel for both channel indices.
+ */
+class SourceBuffer
+{
+public:
+
+  //! Zero Samples Before and After Each Channel (One Cache Line, Covers Every Interpolator's Reach)
+  static constexpr int GuardSamples = 16;
+
+  //! Alignment of the First Sample of Each Channel (in bytes)
+  static constexpr int Alignment = 64;
+
+  /**
+   *\fn: Allocate
+   *\brief: Allocates Silent Channels, Discarding the Old Audio
+   *\param: int numChannels - Number of Channels (1 or 2)
+   *\param: int64 length - Number of Samples per Channel
+   */
+  void Allocate(int numChannels, int64 length);
+
+  /**
+   *\fn: GetWritePointer
+   *\brief: Gets the First Sample of a Channel, to Write the Audio Into
+   *\param: int channel - Channel (Mono Buffers Return Channel 0 for Channel 1)
+   *\return: float* - First Sample, GuardSamples After the Start of the Leading Guard
+   */
+  float* GetWritePointer(int channel) { return mChannels[channel]; }
+
+  /**
+   *\fn: GetReadPointer
+   *\brief: Gets the First Sample of a Channel
+   *\param: int channel - Channel (Mono Buffers Return Channel 0 for Channel 1)
+   *\return: const float* - First Sample, GuardSamples After the Start of the Leading Guard
+   */
+  const float* GetReadPointer(int channel) const { return mChannels[channel]; }
+
+  /**
+   *\fn: GetNumChannels
+   *\brief: Gets the Number of Channels Allocated
+   *\return: int - Number of Channels (0 if Empty)
+   */
+  int GetNumChannels() const { return mNumChannels; }
+
+  /**
+   *\fn: GetLength
+   *\brief: Gets the Number of Samples per Channel, Excluding the Guards
+   *\return: int64 - Number of Samples per Channel
+   */
+  int64 GetLength() const { return mLength; }
+
+private:
+
+  std::unique_ptr<float[]> mStorage;           //!< Unaligned Allocation Holding Every Channel
+  float* mChannels[2] = { nullptr, nullptr };  //!< First Sample of Each Channel (Both the Same when Mono)
+  int mNumChannels = 0;                        //!< Number of Channels Allocated
+  int64 mLength = 0;                           //!< Number of Samples per Channel
+};
@@ -0,0 +1,141 @@
+/*****************************************************************************/
+/*!
+\file   SourceLoader.cpp
+\author Anthony Brigante
+\par    email: anthonypbrigante\@gmail.com
+\par    GitHub Repository: https://github.com/abrigante1/GranularSynth
+\brief
+  Implementation of the SourceLoader Class.
+*/
+/*****************************************************************************/
+
+#include "SourceLoader.h"
+
+// ------------------------------------------------------------------------------------
+// ------------------------------------------------------------------------------------
+// ------------------------------------------------------------------------------------
+
+SourceLoader::SourceLoader(AudioFormatManager& formatManager)
+  : mFormatManager(formatManager),
+    mPeakPool(jmax(1, SystemStats::getNumCpus() - 1)),
+    mLoadPool(NumLoadThreads)
+{
+}
+
+// ------------------------------------------------------------------------------------
+
+SourceLoader::~SourceLoader()
+{
+  // Abandon Every Load, then Wait for them, as they Use the Loader's Members
+  ++mGeneration;
+  mLoadPool.removeAllJobs(true, -1);
+  cancelPendingUpdate();
+}
+
+// ------------------------------------------------------------------------------------
+
+void SourceLoader::Load(const File& file, bool memoryMap, double sampleRate, Callback onLoaded)
+{
+  // Abandon the Load in Progress, it Finishes on its Own Thread and its Result is Discarded
+  const int generation = ++mGeneration;
+  cancelPendingUpdate();
+
+  mFile = file;
+  mOnLoaded = std::move(onLoaded);
+  mIsLoading = true;
+
+  mLoadPool.addJob(new LoadJob(*this, file, memoryMap, sampleRate, generation), true);
+}
+
+// ------------------------------------------------------------------------------------
+
+void SourceLoader::handleAsyncUpdate()
+{
+  std::unique_ptr<SourceAudio> audio;
+  std::unique_ptr<PeakPyramid> peaks;
+  String error;
+
+  {
+    const ScopedLock lock(mResultLock);
+    audio = std::move(mResult);
+    peaks = std::move(mPeaks);
+    error = mError;
+
+    // A Load Abandoned Since it Handed Over its Result
+    if (mResultGeneration != mGeneration.load())
+      return;
+  }
+
+  mIsLoading = false;
+
+  if (mOnLoaded)
+    mOnLoaded(mFile, std::move(audio), std::move(peaks), error);
+}
+
+// ------------------------------------------------------------------------------------
+
+SourceLoader::LoadJob::LoadJob(SourceLoader& loader, const File& file, bool memoryMap, double sampleRate,
+                               int generation)
+  : ThreadPoolJob("Source Loader"), mLoader(loader), mFile(file), mMemoryMap(memoryMap),
+    mSampleRate(sampleRate), mGeneration(generation)
+{
+}
+
+// ------------------------------------------------------------------------------------
+
+ThreadPoolJob::JobStatus SourceLoader::LoadJob::runJob()
+{
+  if (IsAbandoned())
+    return jobHasFinished;
+
+  std::unique_ptr<SourceAudio> audio;
+  String error;
+
+  // Memory Map WAV Files if Requested, Falling Back to Decoding Formats that can not be Mapped
+  if (mMemoryMap && mFile.hasFileExtension("wav"))
+    audio = SourceAudio::Map(mFile, error);
+
+  if (audio == nullptr)
+  {
+    std::unique_ptr<AudioFormatReader> reader(mLoader.mFormatManager.createReaderFor(mFile));
+
+    if (reader != nullptr)
+      audio = SourceAudio::Decode(*reader);
+    else
+      error = "Unable to read " + mFile.getFullPathName();
+  }
+
+  // Convert to the Device's Rate Once Here, Rather than Scaling Every Grain Read by the Ratio
+  if (audio != nullptr && mSampleRate > 0.0 && audio->GetSampleRate() != mSampleRate && !IsAbandoned())
+    audio = SourceAudio::Resample(*audio, mSampleRate);
+
+  // Summarise the Audio for the Waveform View While it is at Hand, Unless it was Summarised Before
+  std::unique_ptr<PeakPyramid> peaks;
+
+  if (audio != nullptr && !IsAbandoned())
+  {
+    peaks = mLoader.mPeakCache.Load(mFile, audio->GetSampleRate());
+
+    if (peaks == nullptr || peaks->GetLength() != audio->GetLength())
+    {
+      peaks = PeakPyramid::Build(*audio, mLoader.mPeakPool);
+      mLoader.mPeakCache.Store(mFile, *peaks);
+    }
+  }
+
+  // Hand the Result to the Message Thread, Unless a Newer Load has Started
+  {
+    const ScopedLock lock(mLoader.mResultLock);
+
+    if (IsAbandoned())
+      return jobHasFinished;
+
+    mLoader.mResult = std::move(audio);
+    mLoader.mPeaks = std::move(peaks);
+    mLoader.mError = (mLoader.mResult == nullptr) ? error : String();
+    mLoader.mResultGeneration = mGeneration;
+  }
+
+  mLoader.triggerAsyncUpdate();
+  return jobHasFinished;
+}
@@ -0,0 +1,142 @@
+/*****************************************************************************/
+/*!
+\file   SourceLoader.h
+\author Anthony Brigante
+\par    email: anthonypbrigante\@gmail.com
+\par    GitHub Repository: https://github.com/abrigante1/GranularSynth
+\brief
+  Definition of the SourceLoader Class.
+  The SourceLoader decodes (or memory maps) audio files on a background
+  thread, converts them to the device's sample rate and summarises them
+  for the waveform view, so opening a file never stalls the GUI or the
+  audio device.
+*/
+/*****************************************************************************/
+#pragma once
+#include <JuceHeader.h>
+#include "GrainSource.h"
+#include "PeakCache.h"
+
+/**
+ *\class: SourceLoader
+ *\author: Anthony Brigante
+ *\brief:
+    The SourceLoader Class loads audio files as jobs on its own ThreadPool
+    and delivers the newest one to a callback on the message thread. Starting
+    a new load abandons the one in progress without waiting for it: every
+    load is stamped with a generation, an abandoned job stops at its next
+    check (a decode can not be interrupted, so that may take a while) on its
+    own thread, and its result is discarded.
+
+    The waveform's PeakPyramid is scanned from the loaded audio while it is
+    still in memory, so the file is only ever read from disk once, and is
+    kept in a PeakCache so reopening the file skips the scan altogether.
+ */
+class SourceLoader : private AsyncUpdater
+{
+public:
+
+  //! Receives the Loaded Audio and its Peaks (nullptr and an Error if the File could not be Loaded), on the Message Thread
+  using Callback = std::function<void(const File& file, std::unique_ptr<SourceAudio> audio,
+                                      std::unique_ptr<PeakPyramid> peaks, const String& error)>;
+
+  /**
+   *\fn: SourceLoader
+   *\brief: Constructor for a SourceLoader
+   *\param: AudioFormatManager& formatManager - Formats the Loader can Decode (Must Outlive the Loader)
+   */
+  explicit SourceLoader(AudioFormatManager& formatManager);
+
+  /**
+   *\fn: ~SourceLoader
+   *\brief: Destructor for a SourceLoader, Waits for Every Load in Progress to Finish
+   */
+  ~SourceLoader();
+
+  /**
+   *\fn: Load
+   *\brief: Starts Loading a File in the Background (Message Thread)
+   *\param: const File& file - File to Load
+   *\param: bool memoryMap - True to Memory Map Uncompressed WAV Files Instead of Decoding them
+   *\param: double sampleRate - Sample Rate to Convert the File to (0 Keeps the File's Own Rate).
+            Converted Files are Held in Memory, Even if Memory Mapping was Requested.
+   *\param: Callback onLoaded - Called on the Message Thread Once the File is Loaded
+   */
+  void Load(const File& file, bool memoryMap, double sampleRate, Callback onLoaded);
+
+  /**
+   *\fn: IsLoading
+   *\brief: Checks if a File is Being Loaded
+   *\return: bool - True Until the Callback of the Newest Load has been Called
+   */
+  bool IsLoading() const { return mIsLoading; }
+
+private:
+
+  //! Number of Loads that can Run at Once (an Abandoned Load Finishing, and the Newest One)
+  static constexpr int NumLoadThreads = 2;
+
+  /**
+   *\class: LoadJob
+   *\brief: Loads One File on a Thread of the SourceLoader's Pool
+   */
+  class LoadJob : public ThreadPoolJob
+  {
+  public:
+
+    /**
+     *\fn: LoadJob
+     *\brief: Constructor for a LoadJob
+     *\param: SourceLoader& loader - Loader that Receives the Result
+     *\param: const File& file - File to Load
+     *\param: bool memoryMap - True to Memory Map WAV Files
+     *\param: double sampleRate - Sample Rate to Convert the File to (0 Keeps the File's Own Rate)
+     *\param: int generation - Generation of the Load
+     */
+    LoadJob(SourceLoader& loader, const File& file, bool memoryMap, double sampleRate, int generation);
+
+    /**
+     *\fn: runJob
+     *\brief: Loads the File and Hands it to the Loader, Unless the Load was Abandoned (Pool Thread)
+     *\return: JobStatus - Always jobHasFinished
+     */
+    JobStatus runJob() override;
+
+  private:
+
+    /**
+     *\fn: IsAbandoned
+     *\brief: Checks if a Newer Load was Started, or the Loader is Being Destroyed
+     *\return: bool - True if the Result would be Discarded
+     */
+    bool IsAbandoned() const { return shouldExit() || mGeneration != mLoader.mGeneration.load(); }
+
+    SourceLoader& mLoader;             //!< Loader that Receives the Result
+    File mFile;                        //!< File to Load
+    bool mMemoryMap;                   //!< True to Memory Map WAV Files
+    double mSampleRate;                //!< Sample Rate to Convert the File to (0 Keeps the File's Own Rate)
+    int mGeneration;                   //!< Generation of the Load
+  };
+
+  /**
+   *\fn: handleAsyncUpdate
+   *\brief: Delivers the Loaded File to the Callback (Message Thread)
+   */
+  void handleAsyncUpdate() override;
+
+  AudioFormatManager& mFormatManager;  //!< Formats the Loader can Decode
+  ThreadPool mPeakPool;                //!< Threads that Help the Loader Scan the Peaks
+  PeakCache mPeakCache;                //!< Peaks of Recently Loaded Files, Kept Between Sessions
+  ThreadPool mLoadPool;                //!< Threads the Loads Run on
+
+  File mFile;                          //!< File of the Newest Load
+  Callback mOnLoaded;                  //!< Receives the Newest Loaded File
+  bool mIsLoading = false;             //!< True Until the Callback of the Newest Load has been Called
+  std::atomic<int> mGeneration{ 0 };   //!< Generation of the Newest Load, Older Loads are Abandoned
+
+  CriticalSection mResultLock;         //!< Guards the Result, Handed from a Load Thread to the Message Thread
+  std::unique_ptr<SourceAudio> mResult; //!< Loaded Audio (nullptr on Failure)
+  std::unique_ptr<PeakPyramid> mPeaks; //!< Peaks of the Loaded Audio (nullptr on Failure)
+  String mError;                       //!< Reason the File could not be Loaded
+  int mResultGeneration = 0;           //!< Generation of the Load the Result Came From
+};
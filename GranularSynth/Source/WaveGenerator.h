@@ -4,19 +4,22 @@ author Anthony Brigante
 Brief Description:
   Implementation and Description File for a Waveform Generator and a
   WaveTableGenerator
-  
-  WaveGenerator: 
-    Generates a Sine Wave with modifiable frequency, pitch offset
-    and volume.
+
+  WaveGenerator:
+    Generates a Sine, Square, Saw or Triangle Wave with modifiable
+    frequency, pitch offset and volume, by reading a WaveTableGenerator.
+    Samples come one at a time or a block at a time.
 
   WaveTableGenerater:
-    Given a WaveGenerator, generates and stores a WaveTable of R samples.
-    (Where R is the Sampling Rate of the WaveGenerator)
+    Stores one cycle of a Waveform as a mipmap of band-limited tables,
+    one per octave, so a wave read at any pitch stays free of aliasing.
 **************************************************************************/
 
 #pragma once
-#define _USE_MATH_DEFINES 
+#define _USE_MATH_DEFINES
 #include <math.h>
+#include <algorithm>
+#include <limits>
 #include <vector>
 
 
@@ -29,66 +32,216 @@ enum Waveform
   NUMBER_OF_WAVEFORMS
 };
 
-// WaveGenerator class - Generates a Sine Wave with modifiable
+// WaveTableGenerator Class
+// Generates a Band-Limited WaveTable per Octave (Level) for a Waveform.
+// Level 0 holds MaxHarmonics partials and each level after it holds half
+// as many as the one before, down to a lone sine in the last level.
+class WaveTableGenerator
+{
+
+public:
+
+  static constexpr int TableSize = 4096;                 // Samples in One Cycle of Each Level
+  static constexpr int MaxHarmonics = TableSize / 4;     // Partials in Level 0 (4x Oversampled, for Linear Interpolation)
+  static constexpr int NumLevels = 11;                   // Levels, MaxHarmonics >> level Partials Each
+
+  // Create a WaveTable
+  WaveTableGenerator(Waveform waveform)
+  {
+    UpdateWaveTable(waveform);
+  }
+
+  // Gets the Shared Tables of a Waveform. The First Call Builds all of them
+  // (a few milliseconds), so make it before Playback, off the Audio Thread.
+  static const WaveTableGenerator& Get(Waveform waveform)
+  {
+    static const WaveTableGenerator tables[NUMBER_OF_WAVEFORMS] =
+    {
+      WaveTableGenerator(SINE), WaveTableGenerator(SQUARE),
+      WaveTableGenerator(SAW),  WaveTableGenerator(TRIANGLE)
+    };
+
+    return tables[waveform];
+  }
+
+  // Update the WaveTable with a new Waveform
+  void UpdateWaveTable(Waveform waveform_)
+  {
+    waveform = waveform_;
+    waveTable.assign(static_cast<size_t>(LevelStride) * NumLevels, 0.0f);
+
+    // One Cycle of a Sine. Partial h at Sample i is sine[(h * i) % TableSize], so Every Partial is Exact
+    std::vector<double> sine(TableSize);
+    for (int i = 0; i < TableSize; ++i)
+      sine[i] = sin(2.0 * M_PI * i / TableSize);
+
+    // Build the Levels from the Sparsest Up, Adding Only the Partials Each Level Gains
+    std::vector<double> sum(TableSize, 0.0);
+    int harmonic = 1;
+
+    for (int level = NumLevels - 1; level >= 0; --level)
+    {
+      for (; harmonic <= (MaxHarmonics >> level); ++harmonic)
+      {
+        const double amplitude = HarmonicAmplitude(waveform, harmonic);
+
+        if (amplitude != 0.0)
+          for (int i = 0; i < TableSize; ++i)
+            sum[i] += amplitude * sine[(harmonic * i) & (TableSize - 1)];
+      }
+
+      float* table = &waveTable[static_cast<size_t>(level) * LevelStride];
+
+      for (int i = 0; i < TableSize; ++i)
+        table[i] = static_cast<float>(sum[i]);
+
+      // Guard Sample, so Interpolation Never Wraps
+      table[TableSize] = table[0];
+    }
+
+    // Normalise Every Level by the Same Peak, the Largest of Any Level, so the Volume Holds Steady
+    // Across Levels and no Level Overshoots Full Scale (Sparse Squares Ring Higher than Rich Ones)
+    float peak = 0.0f;
+    for (const float sample : waveTable)
+      peak = fmaxf(peak, fabsf(sample));
+
+    for (float& sample : waveTable)
+      sample /= peak;
+  }
+
+  // Picks the Richest Level whose Partials all Stay Below Nyquist
+  // at a Phase Increment (in cycles per sample)
+  int GetLevel(double increment) const
+  {
+    increment = fabs(increment);
+
+    int level = 0;
+    while (level < NumLevels - 1 && (MaxHarmonics >> level) * increment > 0.5)
+      ++level;
+
+    return level;
+  }
+
+  // Reads a Level at a Phase [0, 1), Interpolating Linearly
+  float Read(int level, double phase) const
+  {
+    const double position = phase * TableSize;
+    const int index = static_cast<int>(position);
+    const float fraction = static_cast<float>(position - index);
+    const float* table = &waveTable[static_cast<size_t>(level) * LevelStride + index];
+
+    return table[0] + fraction * (table[1] - table[0]);
+  }
+
+  // Gets the First Sample of a Level (TableSize Samples, then a Guard Equal to the First)
+  const float* GetLevelTable(int level) const
+  { return &waveTable[static_cast<size_t>(level) * LevelStride]; }
+
+  Waveform GetWaveform() const
+  { return waveform; }
+
+  int GetTableSize() const
+  { return TableSize; }
+
+private:
+
+  static constexpr int LevelStride = TableSize + 1;      // Samples per Level, Including the Guard
+
+  // Fourier Series Amplitude of a Partial of a Waveform (Sine Terms, Unit Fundamental Swing)
+  static double HarmonicAmplitude(Waveform waveform, int harmonic)
+  {
+    const bool odd = (harmonic % 2) == 1;
+
+    switch (waveform)
+    {
+      case SINE:
+        return (harmonic == 1) ? 1.0 : 0.0;
+
+      case SQUARE:
+        return odd ? 4.0 / (M_PI * harmonic) : 0.0;
+
+      case SAW:
+        return (odd ? 2.0 : -2.0) / (M_PI * harmonic);
+
+      case TRIANGLE:
+        if (!odd)
+          return 0.0;
+        return (((harmonic - 1) / 2) % 2 == 0 ? 8.0 : -8.0) / (M_PI * M_PI * harmonic * harmonic);
+
+      default:
+        return 0.0;
+    }
+  }
+
+  Waveform waveform = SINE;
+
+  // Every Level Back to Back, LevelStride Samples Each
+  std::vector<float> waveTable;
+};
+
+
+// WaveGenerator class - Generates a Waveform with modifiable
 // frequency, pitchOffset, and volume.
 class WaveGenerator
 {
   public:
 
     // Creates an AudioData Class with an Inital Frequency and Sampling Rate
-    WaveGenerator(double initialFrequency_, double samplingRate_, Waveform waveform_) 
+    WaveGenerator(double initialFrequency_, double samplingRate_, Waveform waveform_)
+      : table(&WaveTableGenerator::Get(waveform_))
     {
       waveform = waveform_;
       initialFrequency = initialFrequency_;
       currentFrequency = initialFrequency_;
       mSamplingRate = samplingRate_;
-      increment = 2 * M_PI * currentFrequency / mSamplingRate;
-      pitchOffset = 1.0; 
+      pitchOffset = 1.0;
+      updateIncrement();
     }
 
-    // Calculates and Returns the next sample in a sine wave
+    // Calculates and Returns the next sample in the Waveform
     double operator()(void)
     {
-      double output = 0;
+      double output = table->Read(level, phase) * gain;
 
-      switch (waveform)
+      // Clip Check (the Tables Stay Within Full Scale, so Only Gain Above Unity can Clip)
+      if (gain > 1.0)
       {
-        case SINE:
-          output = sin(data);
-          output *= gain;
-
-          // Clip Check
-          if (output > 1.0f)
-            output = 1.0f;
-          else if (output < -1.0f)
-            output = -1.0f;
-
-          data += increment * pitchOffset;
-          break;
-
-        case SQUARE:
-          output = sign(sin(data));
-          data += increment;
-          break;
-
-        default:
-          break;
+        if (output > 1.0f)
+          output = 1.0f;
+        else if (output < -1.0f)
+          output = -1.0f;
       }
 
+      phase += increment;
+      if (phase >= 1.0)
+        phase -= floor(phase);
+
       return output;
     }
 
-    // Updates the Frequency of the Sine Wave
+    // Writes the next n samples of the Waveform, picking the loop once per
+    // block rather than once per sample. Sines come from a recursive
+    // oscillator instead of the table.
+    void generateBlock(float* out, int n)
+    {
+      if (waveform == SINE)
+        generateSine(out, n);
+      else
+        generateTable(out, n);
+    }
+
+    // Updates the Frequency of the Wave
     void updateFrequency(double freq)
     {
       currentFrequency = freq;
-      increment = 2 * M_PI * currentFrequency / mSamplingRate;
+      updateIncrement();
     }
 
-    // Updates the Pitch Offset of the Sine Wave [-1200, 1200]
+    // Updates the Pitch Offset of the Wave [-1200, 1200]
     void updatePitchOffset(double cents)
     {
       pitchOffset = pow(2.0, cents / 1200.0);
+      updateIncrement();
     }
 
     // Update Gain [-24, 24]
@@ -97,7 +250,7 @@ class WaveGenerator
       gain = pow(10.0, db / 20.0);
     }
 
-    double getInitalFrequency() 
+    double getInitalFrequency()
     { return initialFrequency; }
 
     double getCurrentFrequency()
@@ -106,68 +259,83 @@ class WaveGenerator
     double getSamplingRate()
     { return mSamplingRate; }
 
+    Waveform getWaveform()
+    { return waveform; }
+
   private:
 
-    double sign(double value)
+    // Samples the Sine Recursion Runs Before it is Reseeded from the Phase (Bounds its Drift)
+    static constexpr int SineReseedInterval = 1024;
+
+    // Sine Block: y[i + 1] = 2cos(w) y[i] - y[i - 1], Seeded with Two sin() Calls per Interval
+    void generateSine(float* out, int n)
     {
-      if(value >= 0.0f)
-        return 1.0f;
-      else
-        return -1.0f;
-    }
+      const double w = 2.0 * M_PI * increment;
+      const double k = 2.0 * cos(w);
 
-    Waveform waveform;
+      for (int start = 0; start < n; start += SineReseedInterval)
+      {
+        const int count = std::min(SineReseedInterval, n - start);
+        double previous = sin(2.0 * M_PI * phase - w);
+        double current = sin(2.0 * M_PI * phase);
 
-    double initialFrequency,
-           currentFrequency,
-           pitchOffset = 1.0,
-           gain = 1.0,
-           mSamplingRate = 44100;
-    double data = 0,
-           increment = currentFrequency / mSamplingRate;
+        for (int i = 0; i < count; ++i)
+        {
+          out[start + i] = static_cast<float>(std::min(1.0, std::max(-1.0, current * gain)));
 
-};
+          const double next = k * current - previous;
+          previous = current;
+          current = next;
+        }
 
+        phase += increment * count;
+        phase -= floor(phase);
+      }
+    }
 
-// WaveTableGenerator Class
-// Generates a WaveTable from a WaveGenerator
-class WaveTableGenerator
-{
+    // Table Block: the Same Interpolated Lookup as operator(), with the Level and State Held in Locals
+    void generateTable(float* out, int n)
+    {
+      const float* cycle = table->GetLevelTable(level);
+      const double size = WaveTableGenerator::TableSize;
+      const float blockGain = static_cast<float>(gain);
+      const float limit = (gain > 1.0) ? 1.0f : std::numeric_limits<float>::max();
+      double position = phase * size;
+      const double step = increment * size;
+
+      for (int i = 0; i < n; ++i)
+      {
+        const int index = static_cast<int>(position);
+        const float fraction = static_cast<float>(position - index);
+        const float value = (cycle[index] + fraction * (cycle[index + 1] - cycle[index])) * blockGain;
 
-public:
+        out[i] = std::min(limit, std::max(-limit, value));
 
-  // Create a WaveTable
-  WaveTableGenerator(Waveform waveform)
-  {
-    UpdateWaveTable(WaveGenerator(440.0, 48000.0, waveform));
-  }
+        position += step;
+        if (position >= size)
+          position -= size * floor(position / size);
+      }
 
-  WaveTableGenerator(WaveGenerator wave)
-  {
-    UpdateWaveTable(wave);
-  }
+      phase = position / size;
+    }
 
-  // Update the WaveTable with a new Waveform
-  void UpdateWaveTable(WaveGenerator wave)
-  {
-    waveTable.reserve(static_cast<size_t>(wave.getSamplingRate()));
-    
-    for(size_t i = 0; i < static_cast<size_t>(wave.getSamplingRate()); ++i)
-      waveTable.push_back(static_cast<float>(wave()));
-  }
+    // Recomputes the Phase Increment and the Table Level it Needs
+    void updateIncrement()
+    {
+      increment = currentFrequency * pitchOffset / mSamplingRate;
+      level = table->GetLevel(increment);
+    }
 
-  int GetSamplingRate()
-  { return static_cast<int>(waveTable.size()); }
+    Waveform waveform;
+    const WaveTableGenerator* table;
 
-  // Index into the WaveArray
-  // (Using Operator Overload for Read-only Access)
-  float operator[](int index)
-  {
-    return waveTable[index];
-  }
-  
-private:
+    double initialFrequency,
+           currentFrequency,
+           pitchOffset = 1.0,
+           gain = 1.0,
+           mSamplingRate = 44100;
+    double phase = 0,       // Position in the Cycle [0, 1)
+           increment = 0;   // Cycles per Sample
+    int level = 0;          // Table Level Band-Limited for the Increment
 
-  // WaveTable Object
-  std::vector<float> waveTable;
-};
\ No newline at end of file
+};
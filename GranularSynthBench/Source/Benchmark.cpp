@@ -0,0 +1,753 @@
+/*****************************************************************************/
+/*!
+\file   Benchmark.cpp
+\author Anthony Brigante
+\par    email: anthonypbrigante\@gmail.com
+\par    GitHub Repository: https://github.com/abrigante1/GranularSynth
+\brief
+  This is the Implementation of the BenchmarkRunner Class and the
+  GranularSynth Benchmarks
+*/
+/*****************************************************************************/
+
+#include "Benchmark.h"
+#include "../../GranularSynth/Source/Grain.h"
+#include "../../GranularSynth/Source/GrainKernel.h"
+#include "../../GranularSynth/Source/GrainEngine.h"
+#include "../../GranularSynth/Source/GrainVoices.h"
+#include "../../GranularSynth/Source/OutputStage.h"
+
+namespace
+{
+  const double BenchSampleRate = 48000.0;   //!< Sampling Rate of the Synthetic Source (in Hz)
+  const int BenchSourceLength = 96000;      //!< Length of the Synthetic Source (in samples)
+
+  const int CloudSizes[] = { 1, 16, 128, 1024 }; //!< Cloud Sizes of the renderBlock Cases
+  const int BlockSizes[] = { 64, 512 };          //!< Block Sizes of the renderBlock Cases
+  const int PoolSize = 1024;                     //!< Grains per Run of the Per-Grain Cases
+  const int EngineCloudSizes[] = { 1024, 4096 }; //!< Cloud Sizes of the GrainEngine Cases
+  const int EngineBlockSize = 512;               //!< Block Size of the GrainEngine Cases
+  const int VoiceCounts[] = { 16, 32 };          //!< Held Notes of the Voice Cases
+  const int VoiceCloudSize = 64;                 //!< Grains per Voice of the Voice Cases
+
+  const char* WaveformNames[] = { "sine", "square", "saw", "triangle" };
+  const char* InterpolationNames[] = { "linear", "hermite", "sinc" };
+  const char* ScheduleNames[] = { "continuous", "synchronous", "asynchronous" };
+  const char* LimitingNames[] = { "softClip", "limiter" };
+
+  volatile float gSink = 0.0f;              //!< Receives DoNotOptimise Values
+
+  /**
+   *\fn: MakeParameters
+   *\brief: Builds the JSON Object Describing a Benchmark Case
+   *\param: std::initializer_list<std::pair<const char*, var>> values - Key/Value Pairs in Name Order
+   *\return: var - The Case's Parameters
+   */
+  var MakeParameters(std::initializer_list<std::pair<const char*, var>> values)
+  {
+    DynamicObject::Ptr parameters = new DynamicObject();
+
+    for (auto& value : values)
+      parameters->setProperty(value.first, value.second);
+
+    return var(parameters.get());
+  }
+
+  /**
+   *\fn: MakeSource
+   *\brief: Builds a Deterministic Source (a Chirp with a Little Noise) for the Clouds
+   *\param: int numChannels - Number of Channels of the Source
+   *\return: AudioBuffer<float> - The Source Audio
+   */
+  AudioBuffer<float> MakeSource(int numChannels)
+  {
+    AudioBuffer<float> source(numChannels, BenchSourceLength);
+    Random random(42);
+
+    for (int channel = 0; channel < numChannels; ++channel)
+    {
+      float* samples = source.getWritePointer(channel);
+      double phase = 0.0;
+
+      for (int i = 0; i < BenchSourceLength; ++i)
+      {
+        const double frequency = 110.0 + 880.0 * i / BenchSourceLength;
+        phase += MathConstants<double>::twoPi * frequency / BenchSampleRate;
+
+        samples[i] = 0.5f * static_cast<float>(std::sin(phase)) + 0.05f * (random.nextFloat() - 0.5f);
+      }
+    }
+
+    return source;
+  }
+
+  /**
+   *\fn: MakeCloudParameters
+   *\brief: Builds the Cloud Parameters Shared by the Cloud Cases
+   *\param: int cloudSize - Number of Grains
+   *\param: bool pitch - True to Randomise the Pitch of Each Grain
+   *\param: bool panning - True to Randomly Pan Each Grain
+   *\return: GrainParameters - Parameters of the Cloud
+   */
+  GrainParameters MakeCloudParameters(int cloudSize, bool pitch, bool panning)
+  {
+    GrainParameters parameters;
+    parameters.mCentroidSample = BenchSourceLength / 2;
+    parameters.mDuration = 50;
+    parameters.mStartingOffset = BenchSourceLength / 4;
+    parameters.mCloudSize = cloudSize;
+    parameters.mPitchOffsetMin = pitch ? -12.0 : 0.0;
+    parameters.mPitchOffsetMax = pitch ? 12.0 : 0.0;
+    parameters.mGainOffsetDbMin = -6;
+    parameters.mGainOffsetDbMax = 0;
+    parameters.mEnvelopeAttack = 10.0;
+    parameters.mEnvelopeRelease = 10.0;
+    parameters.mRandomPanning = panning;
+    return parameters;
+  }
+
+  /**
+   *\fn: PrepareCloud
+   *\brief: Sets up a Cloud for Benchmarking and Runs it Until it Reaches a Steady State
+   *\param: GrainCloud& cloud - Cloud to Set Up
+   *\param: const AudioBuffer<float>& source - Source Audio of the Cloud
+   *\param: const GrainParameters& parameters - Parameters of the Cloud
+   */
+  void PrepareCloud(GrainCloud& cloud, const AudioBuffer<float>& source, const GrainParameters& parameters)
+  {
+    cloud.SetAudioSource(source, BenchSampleRate);
+    cloud.Prepare(parameters.mCloudSize);
+    cloud.SetSeed(1);
+    cloud.GetParameters() = parameters;
+    cloud.PublishParameters();
+    cloud.mIsPlaying = true;
+
+    // Render a Grain's Duration so Grains are Spread Through their Envelopes
+    AudioBuffer<float> warmUp(2, 512);
+    const int warmUpSamples = static_cast<int>(BenchSampleRate * parameters.mDuration / 1000.0);
+
+    for (int i = 0; i < warmUpSamples; i += warmUp.getNumSamples())
+      cloud.renderBlock(warmUp, 0, warmUp.getNumSamples());
+  }
+
+  /**
+   *\fn: RunRenderBlock
+   *\brief: Times GrainCloud::renderBlock over Cloud Size, Block Size, Source Channels, Pitch and Panning
+   *\param: BenchmarkRunner& runner - Runner that Times and Records the Cases
+   */
+  void RunRenderBlock(BenchmarkRunner& runner)
+  {
+    for (int numChannels = 1; numChannels <= 2; ++numChannels)
+    {
+      const AudioBuffer<float> source = MakeSource(numChannels);
+
+      for (int cloudSize : CloudSizes)
+        for (int blockSize : BlockSizes)
+          for (int pitch = 0; pitch < 2; ++pitch)
+            for (int panning = 0; panning < 2; ++panning)
+            {
+              const var parameters = MakeParameters({ { "grains", cloudSize },
+                                                      { "block", blockSize },
+                                                      { "source", numChannels == 1 ? "mono" : "stereo" },
+                                                      { "pitch", pitch != 0 },
+                                                      { "pan", panning != 0 } });
+
+              GrainCloud cloud;
+              AudioBuffer<float> output(2, blockSize);
+              bool prepared = false;
+
+              runner.Run("renderBlock", parameters, "ns/sample/grain", static_cast<double>(blockSize) * cloudSize, [&]()
+              {
+                // Set Up on the First Run, so Filtered Out Cases Cost Nothing
+                if (!prepared)
+                {
+                  PrepareCloud(cloud, source, MakeCloudParameters(cloudSize, pitch != 0, panning != 0));
+                  prepared = true;
+                }
+
+                cloud.renderBlock(output, 0, blockSize);
+                Benchmarks::DoNotOptimise(output.getSample(0, blockSize - 1));
+              });
+            }
+    }
+  }
+
+  /**
+   *\fn: RunEngine
+   *\brief: Times GrainEngine::Render on the Calling Thread Alone and with the Default Number of Workers
+   *\param: BenchmarkRunner& runner - Runner that Times and Records the Cases
+   */
+  void RunEngine(BenchmarkRunner& runner)
+  {
+    const AudioBuffer<float> source = MakeSource(2);
+    const int workerCounts[] = { 0, GrainEngine::GetDefaultNumWorkers() };
+
+    for (int cloudSize : EngineCloudSizes)
+      for (int numWorkers : workerCounts)
+      {
+        const var parameters = MakeParameters({ { "grains", cloudSize },
+                                                { "block", EngineBlockSize },
+                                                { "workers", numWorkers } });
+
+        GrainCloud cloud;
+        GrainCloud* clouds[] = { &cloud };
+        GrainEngine engine;
+        AudioBuffer<float> output(2, EngineBlockSize);
+        bool prepared = false;
+
+        runner.Run("engine", parameters, "ns/sample/grain", static_cast<double>(EngineBlockSize) * cloudSize, [&]()
+        {
+          if (!prepared)
+          {
+            PrepareCloud(cloud, source, MakeCloudParameters(cloudSize, true, true));
+            engine.Prepare(numWorkers);
+            prepared = true;
+          }
+
+          engine.Render(clouds, 1, output, 0, EngineBlockSize);
+          Benchmarks::DoNotOptimise(output.getSample(0, EngineBlockSize - 1));
+        });
+      }
+  }
+
+  /**
+   *\fn: RunMappedSource
+   *\brief: Times GrainCloud::renderBlock Reading from a Memory Mapped WAV File, per Sample Format
+   *\param: BenchmarkRunner& runner - Runner that Times and Records the Cases
+   */
+  void RunMappedSource(BenchmarkRunner& runner)
+  {
+    const AudioBuffer<float> source = MakeSource(2);
+    const int bitDepths[] = { 16, 24, 32 };
+    const int cloudSize = 1024;
+    const int blockSize = 512;
+
+    for (int bitsPerSample : bitDepths)
+    {
+      const var parameters = MakeParameters({ { "grains", cloudSize },
+                                              { "block", blockSize },
+                                              { "format", (bitsPerSample == 32) ? "float32" : "int" + String(bitsPerSample) } });
+
+      TemporaryFile wavFile(".wav");
+      GrainCloud cloud;
+      AudioBuffer<float> output(2, blockSize);
+      bool prepared = false;
+
+      runner.Run("mappedSource", parameters, "ns/sample/grain", static_cast<double>(blockSize) * cloudSize, [&]()
+      {
+        if (!prepared)
+        {
+          // Write the Source at the Case's Bit Depth (JUCE Writes 32 bit WAV Files as Float)
+          std::unique_ptr<AudioFormatWriter> writer(WavAudioFormat().createWriterFor(new FileOutputStream(wavFile.getFile()),
+                                                                                     BenchSampleRate, 2, bitsPerSample, {}, 0));
+          writer->writeFromAudioSampleBuffer(source, 0, source.getNumSamples());
+          writer.reset();
+
+          PrepareCloud(cloud, source, MakeCloudParameters(cloudSize, true, true));
+
+          String error;
+          if (!cloud.MapAudioSource(wavFile.getFile(), error))
+            ConsoleApplication::fail(error);
+
+          prepared = true;
+        }
+
+        cloud.renderBlock(output, 0, blockSize);
+        Benchmarks::DoNotOptimise(output.getSample(0, blockSize - 1));
+      });
+    }
+  }
+
+  /**
+   *\fn: RunInterpolation
+   *\brief: Times GrainCloud::renderBlock with Pitched Grains, per Interpolation Quality
+   *\param: BenchmarkRunner& runner - Runner that Times and Records the Cases
+   */
+  void RunInterpolation(BenchmarkRunner& runner)
+  {
+    const AudioBuffer<float> source = MakeSource(2);
+    const int cloudSize = 1024;
+    const int blockSize = 512;
+
+    for (int quality = 0; quality < NUMBER_OF_INTERPOLATION_QUALITIES; ++quality)
+    {
+      const var parameters = MakeParameters({ { "grains", cloudSize },
+                                              { "block", blockSize },
+                                              { "interpolation", InterpolationNames[quality] } });
+
+      GrainCloud cloud;
+      AudioBuffer<float> output(2, blockSize);
+      bool prepared = false;
+
+      runner.Run("interpolation", parameters, "ns/sample/grain", static_cast<double>(blockSize) * cloudSize, [&]()
+      {
+        if (!prepared)
+        {
+          GrainParameters cloudParameters = MakeCloudParameters(cloudSize, true, true);
+          cloudParameters.mInterpolation = static_cast<InterpolationQuality>(quality);
+
+          PrepareCloud(cloud, source, cloudParameters);
+          prepared = true;
+        }
+
+        cloud.renderBlock(output, 0, blockSize);
+        Benchmarks::DoNotOptimise(output.getSample(0, blockSize - 1));
+      });
+    }
+  }
+
+  /**
+   *\fn: RunScheduler
+   *\brief: Times GrainCloud::renderBlock for Density Driven Clouds of Short Grains
+   *\param: BenchmarkRunner& runner - Runner that Times and Records the Cases
+   */
+  void RunScheduler(BenchmarkRunner& runner)
+  {
+    const AudioBuffer<float> source = MakeSource(2);
+    const double densities[] = { 1000.0, 10000.0 };
+    const int blockSize = 512;
+
+    for (int schedule = SYNCHRONOUS; schedule <= ASYNCHRONOUS; ++schedule)
+      for (double density : densities)
+      {
+        const var parameters = MakeParameters({ { "schedule", ScheduleNames[schedule] },
+                                                { "density", density },
+                                                { "block", blockSize } });
+
+        GrainCloud cloud;
+        AudioBuffer<float> output(2, blockSize);
+        bool prepared = false;
+
+        runner.Run("scheduler", parameters, "ns/sample", blockSize, [&]()
+        {
+          if (!prepared)
+          {
+            // 10 ms Grains, so about Density / 100 Grains Sound at Once
+            GrainParameters cloudParameters = MakeCloudParameters(GrainCloud::DefaultMaxCloudSize, true, true);
+            cloudParameters.mDuration = 10;
+            cloudParameters.mSchedule = static_cast<GrainSchedule>(schedule);
+            cloudParameters.mDensity = density;
+            cloudParameters.mJitter = 0.5;
+
+            PrepareCloud(cloud, source, cloudParameters);
+            prepared = true;
+          }
+
+          cloud.renderBlock(output, 0, blockSize);
+          Benchmarks::DoNotOptimise(output.getSample(0, blockSize - 1));
+        });
+      }
+  }
+
+  /**
+   *\fn: RunVoices
+   *\brief: Times a Chord of Held Notes Rendered by the GrainEngine through the GrainVoiceManager
+   *\param: BenchmarkRunner& runner - Runner that Times and Records the Cases
+   */
+  void RunVoices(BenchmarkRunner& runner)
+  {
+    const AudioBuffer<float> source = MakeSource(2);
+
+    for (int numVoices : VoiceCounts)
+    {
+      const var parameters = MakeParameters({ { "voices", numVoices },
+                                              { "grains", VoiceCloudSize },
+                                              { "block", EngineBlockSize } });
+
+      GrainCloud owner;
+      GrainVoiceManager voices(numVoices, VoiceCloudSize);
+      GrainCloud* clouds[GrainVoiceManager::MaxVoices];
+      GrainEngine engine;
+      AudioBuffer<float> output(2, EngineBlockSize);
+      bool prepared = false;
+
+      runner.Run("voices", parameters, "ns/sample/voice", static_cast<double>(EngineBlockSize) * numVoices, [&]()
+      {
+        if (!prepared)
+        {
+          // The Voices Read the Owner's Source, One Held Note per Voice (a Chord of Semitones)
+          owner.SetAudioSource(source, BenchSampleRate);
+          voices.Prepare(VoiceCloudSize, EngineBlockSize);
+          voices.SetParameters(MakeCloudParameters(VoiceCloudSize, true, true));
+          engine.Prepare(GrainEngine::GetDefaultNumWorkers());
+
+          for (int voice = 0; voice < numVoices; ++voice)
+            voices.PostMidiMessage(MidiMessage::noteOn(1, GrainVoiceManager::RootNote - numVoices / 2 + voice, 0.8f));
+
+          prepared = true;
+        }
+
+        const int numClouds = voices.BeginBlock(owner.UpdateAudioSource(), clouds);
+        engine.Render(clouds, numClouds, output, 0, EngineBlockSize);
+        Benchmarks::DoNotOptimise(output.getSample(0, EngineBlockSize - 1));
+      });
+    }
+  }
+
+  /**
+   *\fn: RunResample
+   *\brief: Times SourceAudio::Resample, the Load-Time Conversion to the Device's Sample Rate
+   *\param: BenchmarkRunner& runner - Runner that Times and Records the Cases
+   */
+  void RunResample(BenchmarkRunner& runner)
+  {
+    const double outputRates[] = { 44100.0, 96000.0 };
+    std::unique_ptr<SourceAudio> source = SourceAudio::Copy(MakeSource(2), BenchSampleRate);
+
+    for (double outputRate : outputRates)
+    {
+      runner.Run("resample", MakeParameters({ { "from", BenchSampleRate }, { "to", outputRate } }),
+                 "ns/sample", static_cast<double>(BenchSourceLength), [&]()
+      {
+        std::unique_ptr<SourceAudio> resampled = SourceAudio::Resample(*source, outputRate);
+        Benchmarks::DoNotOptimise(static_cast<float>(resampled->GetLength()));
+      });
+    }
+  }
+
+  /**
+   *\fn: RunSpawnGrains
+   *\brief: Times the Per-Grain Randomisation (GrainCloud::RetriggerGrains Spawns a Full Cloud)
+   *\param: BenchmarkRunner& runner - Runner that Times and Records the Cases
+   */
+  void RunSpawnGrains(BenchmarkRunner& runner)
+  {
+    const AudioBuffer<float> source = MakeSource(2);
+
+    for (int pitch = 0; pitch < 2; ++pitch)
+      for (int panning = 0; panning < 2; ++panning)
+      {
+        const var parameters = MakeParameters({ { "grains", PoolSize },
+                                                { "pitch", pitch != 0 },
+                                                { "pan", panning != 0 } });
+
+        GrainCloud cloud;
+        bool prepared = false;
+
+        runner.Run("SpawnGrains", parameters, "ns/grain", PoolSize, [&]()
+        {
+          if (!prepared)
+          {
+            PrepareCloud(cloud, source, MakeCloudParameters(PoolSize, pitch != 0, panning != 0));
+            prepared = true;
+          }
+
+          cloud.RetriggerGrains();
+        });
+      }
+  }
+
+  /**
+   *\fn: RunEnvelope
+   *\brief: Times the Envelope Evaluation of a Full Pool of Grains for Each Window Shape
+   *\param: BenchmarkRunner& runner - Runner that Times and Records the Cases
+   */
+  void RunEnvelope(BenchmarkRunner& runner)
+  {
+    const char* shapeNames[] = { "trapezoid", "hann", "tukey", "gaussian", "exponential-decay" };
+    const int windowFrames = 2400;
+
+    GrainPool pool;
+    pool.Allocate(PoolSize);
+    Random random(7);
+    Envelope envelope;
+
+    // Spread the Grains Across their Windows, with Every Eighth Grain Released
+    for (int i = 0; i < PoolSize; ++i)
+    {
+      const int grain = pool.ActivateGrain();
+      pool.mLifetime[grain] = static_cast<float>(windowFrames);
+      pool.mEnvelopeScale[grain] = static_cast<float>(windowFrames - 1) / windowFrames;
+      pool.mEnvelopePosition[grain] = random.nextFloat() * pool.mLifetime[grain];
+
+      if ((i % 8) == 0)
+        pool.mReleaseStart[grain] = pool.mEnvelopePosition[grain];
+    }
+
+    std::vector<float> envelopes(static_cast<size_t>(pool.GetNumLanes()));
+    const float releaseRate = 1.0f / 480.0f;
+
+    for (int shape = 0; shape < NUMBER_OF_ENVELOPE_SHAPES; ++shape)
+    {
+      envelope.Update(static_cast<EnvelopeShape>(shape), windowFrames, 0.2f, 0.2f);
+
+      runner.Run("envelope", MakeParameters({ { "grains", PoolSize }, { "shape", shapeNames[shape] } }), "ns/grain", PoolSize, [&]()
+      {
+        GrainKernel::EvaluateEnvelopes(pool, envelope, releaseRate, envelopes.data());
+        Benchmarks::DoNotOptimise(envelopes[static_cast<size_t>(PoolSize - 1)]);
+      });
+    }
+  }
+
+  /**
+   *\fn: RunOutputStage
+   *\brief: Times OutputStage::Process on a Stereo Mix Peaking Well Past Full Scale, for Each Limiting
+   *\param: BenchmarkRunner& runner - Runner that Times and Records the Cases
+   */
+  void RunOutputStage(BenchmarkRunner& runner)
+  {
+    const AudioBuffer<float> source = MakeSource(2);
+
+    for (int limiting = 0; limiting < NUMBER_OF_OUTPUT_LIMITINGS; ++limiting)
+    {
+      OutputStage output;
+      output.SetLimiting(static_cast<OutputLimiting>(limiting));
+      output.Prepare(BenchSampleRate);
+
+      AudioBuffer<float> block(2, EngineBlockSize);
+      int position = 0;
+
+      runner.Run("OutputStage", MakeParameters({ { "limiting", LimitingNames[limiting] },
+                                                 { "block", EngineBlockSize } }), "ns/sample", EngineBlockSize, [&]()
+      {
+        // Walk Through the Source at 4x Gain, so there is Always Something to Clip
+        for (int channel = 0; channel < 2; ++channel)
+          FloatVectorOperations::copyWithMultiply(block.getWritePointer(channel), source.getReadPointer(channel, position),
+                                                  4.0f, EngineBlockSize);
+
+        position = (position + EngineBlockSize) % (BenchSourceLength - EngineBlockSize);
+
+        output.Process(block, 0, EngineBlockSize);
+        Benchmarks::DoNotOptimise(block.getSample(0, EngineBlockSize - 1));
+      });
+    }
+  }
+
+  /**
+   *\fn: RunWaveGenerator
+   *\brief: Times WaveGenerator::operator() and WaveGenerator::generateBlock for Each Waveform
+   *\param: BenchmarkRunner& runner - Runner that Times and Records the Cases
+   */
+  void RunWaveGenerator(BenchmarkRunner& runner)
+  {
+    const int numSamples = 4096;
+    std::vector<float> block(numSamples);
+
+    for (int waveform = 0; waveform < NUMBER_OF_WAVEFORMS; ++waveform)
+    {
+      WaveGenerator wave(440.0, BenchSampleRate, static_cast<Waveform>(waveform));
+
+      runner.Run("WaveGenerator", MakeParameters({ { "waveform", WaveformNames[waveform] } }), "ns/sample", numSamples, [&]()
+      {
+        double sum = 0.0;
+
+        for (int i = 0; i < numSamples; ++i)
+          sum += wave();
+
+        Benchmarks::DoNotOptimise(static_cast<float>(sum));
+      });
+
+      runner.Run("WaveGeneratorBlock", MakeParameters({ { "waveform", WaveformNames[waveform] } }), "ns/sample", numSamples, [&]()
+      {
+        wave.generateBlock(block.data(), numSamples);
+        Benchmarks::DoNotOptimise(block[numSamples - 1]);
+      });
+    }
+  }
+
+  /**
+   *\fn: RunWaveTable
+   *\brief: Times WaveTableGenerator::UpdateWaveTable (Every Level of the Mipmap) for Each Waveform
+   *\param: BenchmarkRunner& runner - Runner that Times and Records the Cases
+   */
+  void RunWaveTable(BenchmarkRunner& runner)
+  {
+    WaveTableGenerator table(SINE);
+    const int numSamples = WaveTableGenerator::TableSize * WaveTableGenerator::NumLevels;
+
+    for (int waveform = 0; waveform < NUMBER_OF_WAVEFORMS; ++waveform)
+    {
+      runner.Run("UpdateWaveTable", MakeParameters({ { "waveform", WaveformNames[waveform] } }), "ns/sample", numSamples, [&]()
+      {
+        table.UpdateWaveTable(static_cast<Waveform>(waveform));
+        Benchmarks::DoNotOptimise(table.Read(0, 0.25));
+      });
+    }
+  }
+}
+
+// ------------------------------------------------------------------------------------
+// ------------------------------------------------------------------------------------
+// ------------------------------------------------------------------------------------
+
+BenchmarkRunner::BenchmarkRunner(double minSeconds, int repetitions, const String& filter)
+  : mMinSeconds(minSeconds), mRepetitions(jmax(1, repetitions)), mFilter(filter)
+{
+}
+
+// ------------------------------------------------------------------------------------
+
+void BenchmarkRunner::Run(const String& group, const var& parameters, const String& unit,
+                          double workPerIteration, const Body& body)
+{
+  const String name = MakeName(group, parameters);
+
+  if (mFilter.isNotEmpty() && !name.contains(mFilter))
+    return;
+
+  // Untimed First Run (Lazy Setup, Cold Caches)
+  body();
+
+  // Find a Batch Size that Lasts at Least the Minimum Time
+  int64 batchSize = 1;
+  double batchSeconds = 0.0;
+
+  for (;;)
+  {
+    const int64 startTicks = Time::getHighResolutionTicks();
+
+    for (int64 i = 0; i < batchSize; ++i)
+      body();
+
+    batchSeconds = Time::highResolutionTicksToSeconds(Time::getHighResolutionTicks() - startTicks);
+
+    if (batchSeconds >= mMinSeconds || batchSize >= (int64(1) << 40))
+      break;
+
+    batchSize *= 2;
+  }
+
+  // Time Each Repetition at that Batch Size
+  std::vector<double> costs;
+  costs.reserve(static_cast<size_t>(mRepetitions));
+
+  for (int repetition = 0; repetition < mRepetitions; ++repetition)
+  {
+    const int64 startTicks = Time::getHighResolutionTicks();
+
+    for (int64 i = 0; i < batchSize; ++i)
+      body();
+
+    const double seconds = Time::highResolutionTicksToSeconds(Time::getHighResolutionTicks() - startTicks);
+    costs.push_back(seconds * 1.0e9 / (static_cast<double>(batchSize) * workPerIteration));
+  }
+
+  std::sort(costs.begin(), costs.end());
+
+  BenchmarkResult result;
+  result.mName = name;
+  result.mGroup = group;
+  result.mUnit = unit;
+  result.mParameters = parameters;
+  result.mMedian = costs[costs.size() / 2];
+  result.mMinimum = costs.front();
+  result.mIterations = batchSize * mRepetitions;
+
+  std::cout << name.paddedRight(' ', 64) << String(result.mMedian, 3) << " " << unit << std::endl;
+
+  mResults.push_back(result);
+}
+
+// ------------------------------------------------------------------------------------
+
+var BenchmarkRunner::ToJSON() const
+{
+  // Describe the Machine and the Build, so Reports are Only Compared Like for Like
+  DynamicObject::Ptr machine = new DynamicObject();
+  machine->setProperty("cpu", SystemStats::getCpuModel());
+  machine->setProperty("cpus", SystemStats::getNumCpus());
+  machine->setProperty("os", SystemStats::getOperatingSystemName());
+  machine->setProperty("juce", SystemStats::getJUCEVersion());
+ #if JUCE_DEBUG
+  machine->setProperty("build", "debug");
+ #else
+  machine->setProperty("build", "release");
+ #endif
+  machine->setProperty("simd", GRAIN_KERNEL_USE_SSE2 ? "sse2" : "scalar");
+
+  Array<var> results;
+
+  for (const BenchmarkResult& result : mResults)
+  {
+    DynamicObject::Ptr entry = new DynamicObject();
+    entry->setProperty("name", result.mName);
+    entry->setProperty("group", result.mGroup);
+    entry->setProperty("parameters", result.mParameters);
+    entry->setProperty("unit", result.mUnit);
+    entry->setProperty("median", result.mMedian);
+    entry->setProperty("min", result.mMinimum);
+    entry->setProperty("iterations", result.mIterations);
+    results.add(var(entry.get()));
+  }
+
+  DynamicObject::Ptr report = new DynamicObject();
+  report->setProperty("machine", var(machine.get()));
+  report->setProperty("minSeconds", mMinSeconds);
+  report->setProperty("repetitions", mRepetitions);
+  report->setProperty("results", results);
+  return var(report.get());
+}
+
+// ------------------------------------------------------------------------------------
+
+void BenchmarkRunner::CompareWithBaseline(const var& baseline) const
+{
+  // Index the Baseline by Case Name
+  std::map<String, double> baselineCosts;
+
+  if (const Array<var>* results = baseline["results"].getArray())
+    for (const var& entry : *results)
+      baselineCosts[entry["name"].toString()] = entry["median"];
+
+  std::cout << std::endl << "Change against baseline (negative is faster):" << std::endl;
+
+  for (const BenchmarkResult& result : mResults)
+  {
+    const auto match = baselineCosts.find(result.mName);
+
+    if (match == baselineCosts.end() || match->second <= 0.0)
+    {
+      std::cout << result.mName.paddedRight(' ', 64) << "(new)" << std::endl;
+      continue;
+    }
+
+    const double change = 100.0 * (result.mMedian - match->second) / match->second;
+    std::cout << result.mName.paddedRight(' ', 64) << (change >= 0.0 ? "+" : "") << String(change, 1) << " %" << std::endl;
+  }
+}
+
+// ------------------------------------------------------------------------------------
+
+String BenchmarkRunner::MakeName(const String& group, const var& parameters)
+{
+  String name = group;
+
+  if (DynamicObject* object = parameters.getDynamicObject())
+    for (auto& property : object->getProperties())
+    {
+      // Booleans Read as "pitch" / "no-pitch", Everything Else as "key=value"
+      if (property.value.isBool())
+        name << "/" << (static_cast<bool>(property.value) ? "" : "no-") << property.name.toString();
+      else
+        name << "/" << property.name.toString() << "=" << property.value.toString();
+    }
+
+  return name;
+}
+
+// ------------------------------------------------------------------------------------
+// ------------------------------------------------------------------------------------
+// ------------------------------------------------------------------------------------
+
+void Benchmarks::RunAll(BenchmarkRunner& runner)
+{
+  RunRenderBlock(runner);
+  RunEngine(runner);
+  RunMappedSource(runner);
+  RunInterpolation(runner);
+  RunScheduler(runner);
+  RunVoices(runner);
+  RunResample(runner);
+  RunSpawnGrains(runner);
+  RunEnvelope(runner);
+  RunOutputStage(runner);
+  RunWaveGenerator(runner);
+  RunWaveTable(runner);
+}
+
+// ------------------------------------------------------------------------------------
+
+void Benchmarks::DoNotOptimise(float value)
+{
+  gSink = gSink + value;
+}
@@ -0,0 +1,126 @@
+/*****************************************************************************/
+/*!
+\file   Benchmark.h
+\author Anthony Brigante
+\par    email: anthonypbrigante\@gmail.com
+\par    GitHub Repository: https://github.com/abrigante1/GranularSynth
+\brief
+  Definition of the BenchmarkRunner Class and the GranularSynth Benchmarks.
+  Each benchmark times one hot path of the engine and reports the cost
+  normalised to a unit of work (e.g. nanoseconds per sample per grain),
+  so results from different configurations and machines can be compared.
+*/
+/*****************************************************************************/
+#pragma once
+
+#include <JuceHeader.h>
+
+/**
+ *\struct: BenchmarkResult
+ *\author: Anthony Brigante
+ *\brief:
+    The BenchmarkResult Struct holds the timing of a single benchmark case.
+ */
+struct BenchmarkResult
+{
+  String mName;                 //!< Unique Name of the Case (e.g. "renderBlock/grains=16/block=512/...")
+  String mGroup;                //!< Hot Path the Case Measures (e.g. "renderBlock")
+  String mUnit;                 //!< Unit of mMedian and mMinimum (e.g. "ns/sample/grain")
+  var mParameters;              //!< Configuration of the Case (JSON Object)
+
+  double mMedian = 0.0;         //!< Median Cost per Unit of Work over all Repetitions
+  double mMinimum = 0.0;        //!< Lowest Cost per Unit of Work over all Repetitions
+  int64 mIterations = 0;        //!< Total Number of Times the Body was Run
+};
+
+/**
+ *\class: BenchmarkRunner
+ *\author: Anthony Brigante
+ *\brief:
+    The BenchmarkRunner times a benchmark body. The body is run in batches
+    until each repetition has lasted at least the minimum time, and the
+    median of the repetitions is reported to reject scheduling noise.
+ */
+class BenchmarkRunner
+{
+public:
+
+  //! Runs the Measured Work Once
+  using Body = std::function<void()>;
+
+  /**
+   *\fn: BenchmarkRunner
+   *\brief: Constructor for a BenchmarkRunner
+   *\param: double minSeconds - Minimum Duration of a Single Repetition
+   *\param: int repetitions - Number of Repetitions per Case
+   *\param: const String& filter - Only Cases whose Name Contains this are Run (empty runs all)
+   */
+  BenchmarkRunner(double minSeconds, int repetitions, const String& filter);
+
+  /**
+   *\fn: Run
+   *\brief: Times a Benchmark Case and Records the Result
+   *\param: const String& group - Hot Path the Case Measures
+   *\param: const var& parameters - Configuration of the Case (JSON Object)
+   *\param: const String& unit - Unit of Work the Result is Normalised to
+   *\param: double workPerIteration - Units of Work Done by One Run of the Body
+   *\param: const Body& body - The Work to Measure
+   */
+  void Run(const String& group, const var& parameters, const String& unit,
+           double workPerIteration, const Body& body);
+
+  /**
+   *\fn: GetResults
+   *\brief: Gets the Results of Every Case Run so Far
+   *\return: const std::vector<BenchmarkResult>& - Results in the Order they were Run
+   */
+  const std::vector<BenchmarkResult>& GetResults() const { return mResults; }
+
+  /**
+   *\fn: ToJSON
+   *\brief: Builds the Report of Every Case Run so Far (Including the Machine Description)
+   *\return: var - The Report as a JSON Object
+   */
+  var ToJSON() const;
+
+  /**
+   *\fn: CompareWithBaseline
+   *\brief: Prints the Change of Every Case Against a Previous Report
+   *\param: const var& baseline - A Report Previously Written by ToJSON()
+   */
+  void CompareWithBaseline(const var& baseline) const;
+
+  /**
+   *\fn: MakeName
+   *\brief: Builds the Unique Name of a Case from its Group and Parameters
+   *\param: const String& group - Hot Path the Case Measures
+   *\param: const var& parameters - Configuration of the Case (JSON Object)
+   *\return: String - "group/key=value/key=value..."
+   */
+  static String MakeName(const String& group, const var& parameters);
+
+private:
+
+  double mMinSeconds;                   //!< Minimum Duration of a Single Repetition
+  int mRepetitions;                     //!< Number of Repetitions per Case
+  String mFilter;                       //!< Only Cases whose Name Contains this are Run
+
+  std::vector<BenchmarkResult> mResults; //!< Results of Every Case Run so Far
+};
+
+namespace Benchmarks
+{
+  /**
+   *\fn: RunAll
+   *\brief: Runs Every GranularSynth Benchmark
+   *\param: BenchmarkRunner& runner - Runner that Times and Records the Cases
+   */
+  void RunAll(BenchmarkRunner& runner);
+
+  /**
+   *\fn: DoNotOptimise
+   *\brief: Consumes a Value so the Compiler Cannot Remove the Work that Produced it
+   *\param: float value - Value to Consume
+   */
+  void DoNotOptimise(float value);
+}
@@ -0,0 +1,83 @@
+/*****************************************************************************/
+/*!
+\file   Main.cpp
+\author Anthony Brigante
+\par    email: anthonypbrigante\@gmail.com
+\par    GitHub Repository: https://github.com/abrigante1/GranularSynth
+\brief
+  Entry Point of the GranularSynth Benchmarks.
+  Times the engine's hot paths, optionally writes the results as JSON and
+  compares them against a previous run.
+*/
+/*****************************************************************************/
+
+#include <JuceHeader.h>
+#include "Benchmark.h"
+
+namespace
+{
+  /**
+   *\fn: BenchmarkCommand
+   *\brief: Handles "--run": Runs the Benchmarks and Reports the Results
+   *\param: const ArgumentList& args - Command Line Arguments
+   */
+  void BenchmarkCommand(const ArgumentList& args)
+  {
+    const double minSeconds = args.containsOption("--min-time") ? args.getValueForOption("--min-time").getDoubleValue() : 0.1;
+    const int repetitions = args.containsOption("--repetitions") ? args.getValueForOption("--repetitions").getIntValue() : 5;
+    const String filter = args.getValueForOption("--filter");
+
+    // Read the Baseline First, so a Bad Path Fails Before the Run
+    var baseline;
+
+    if (args.containsOption("--baseline"))
+    {
+      const File baselineFile = args.getExistingFileForOption("--baseline");
+      baseline = JSON::parse(baselineFile);
+
+      if (!baseline.isObject())
+        ConsoleApplication::fail("Baseline is not a benchmark report: " + baselineFile.getFullPathName());
+    }
+
+    BenchmarkRunner runner(minSeconds, repetitions, filter);
+    Benchmarks::RunAll(runner);
+
+    if (runner.GetResults().empty())
+      ConsoleApplication::fail("No benchmark matches the filter: " + filter);
+
+    if (args.containsOption("--output"))
+    {
+      const File outputFile = args.getFileForOption("--output");
+
+      if (!outputFile.replaceWithText(JSON::toString(runner.ToJSON())))
+        ConsoleApplication::fail("Unable to write " + outputFile.getFullPathName());
+
+      std::cout << "Wrote " << outputFile.getFullPathName() << std::endl;
+    }
+
+    if (baseline.isObject())
+      runner.CompareWithBaseline(baseline);
+  }
+}
+
+//==============================================================================
+int main (int argc, char* argv[])
+{
+  ConsoleApplication app;
+
+  app.addHelpCommand("--help|-h", "Usage:", true);
+
+  app.addDefaultCommand({ "--run",
+                          "--run [--filter <text>] [--min-time <seconds>] [--repetitions <count>] [--output <file.json>] [--baseline <file.json>]",
+                          "Times the engine's hot paths.",
+                          "Runs GrainCloud::renderBlock (over cloud size, block size, mono/stereo source, pitch and panning),\n"
+                          "GrainEngine::Render (single threaded and with the default number of workers), chords of MIDI voices,\n"
+                          "memory mapped sources, grain randomisation, envelope evaluation, the output stage, WaveGenerator and\n"
+                          "WaveTableGenerator. Costs are normalised to the work done (ns/sample/grain, ns/grain or ns/sample)\n"
+                          "and the median of the repetitions is reported. --output writes a JSON report, --baseline prints\n"
+                          "the change of every case against a previous report. Build the Release configuration for\n"
+                          "meaningful numbers.",
+                          BenchmarkCommand });
+
+  return app.findAndRunCommand(argc, argv);
+}
@@ -0,0 +1,205 @@
+/*****************************************************************************/
+/*!
+\file   Main.cpp
+\author Anthony Brigante
+\par    email: anthonypbrigante\@gmail.com
+\par    GitHub Repository: https://github.com/abrigante1/GranularSynth
+\brief
+  Entry Point of the Headless GranularSynth Renderer.
+  Renders a Grain Cloud from a source file and a parameter file to disk,
+  faster than real time and without an audio device or a window.
+*/
+/*****************************************************************************/
+
+#include <JuceHeader.h>
+#include "OfflineRenderer.h"
+#include "RegressionSuite.h"
+
+namespace
+{
+  /**
+   *\fn: RenderCommand
+   *\brief: Handles "--render": Renders a Cloud and Writes it to Disk
+   *\param: const ArgumentList& args - Command Line Arguments
+   */
+  void RenderCommand(const ArgumentList& args)
+  {
+    const File sourceFile = args.getExistingFileForOption("--input");
+    const File parameterFile = args.getExistingFileForOption("--params");
+    const File outputFile = args.getFileForOption("--output");
+
+    // Read the Parameter File, the Command Line Can Override the Length
+    OfflineRenderSettings settings;
+    String error;
+
+    if (!OfflineRenderer::LoadSettings(parameterFile, settings, error))
+      ConsoleApplication::fail(error);
+
+    if (args.containsOption("--length"))
+      settings.mLengthSeconds = args.getValueForOption("--length").getDoubleValue();
+
+    if (args.containsOption("--block-size"))
+      settings.mBlockSize = jmax(1, args.getValueForOption("--block-size").getIntValue());
+
+    if (args.containsOption("--threads"))
+      settings.mNumThreads = jmax(0, args.getValueForOption("--threads").getIntValue());
+
+    // Load the Source
+    AudioFormatManager formatManager;
+    formatManager.registerBasicFormats();
+
+    std::unique_ptr<AudioFormatReader> reader(formatManager.createReaderFor(sourceFile));
+    if (reader == nullptr)
+      ConsoleApplication::fail("Unable to read source file: " + sourceFile.getFullPathName());
+
+    // Memory Mapped Sources Open Instantly and Only Load what the Grains Read
+    std::unique_ptr<SourceAudio> audio = args.containsOption("--memory-map") ? SourceAudio::Map(sourceFile, error)
+                                                                            : SourceAudio::Decode(*reader);
+    if (audio == nullptr)
+      ConsoleApplication::fail(error);
+
+    // Convert the Source Once if the Output is at Another Rate
+    const double sampleRate = args.containsOption("--sample-rate") ? args.getValueForOption("--sample-rate").getDoubleValue()
+                                                                   : audio->GetSampleRate();
+    if (sampleRate <= 0.0)
+      ConsoleApplication::fail("Invalid sample rate: " + args.getValueForOption("--sample-rate"));
+
+    if (sampleRate != audio->GetSampleRate())
+      audio = SourceAudio::Resample(*audio, sampleRate);
+
+    GrainCloud cloud;
+    cloud.SetAudioSource(std::move(audio));
+
+    // Create the Writer for the Output File
+    AudioFormat* outputFormat = formatManager.findFormatForFileExtension(outputFile.getFileExtension());
+    if (outputFormat == nullptr)
+      ConsoleApplication::fail("Unsupported output format: " + outputFile.getFileName());
+
+    const int bitsPerSample = args.containsOption("--bits") ? args.getValueForOption("--bits").getIntValue() : 24;
+
+    // Integer Output can be Dithered (Float Output Needs None)
+    if (args.containsOption("--dither") && bitsPerSample < 32)
+      settings.mDitherBits = bitsPerSample;
+
+    outputFile.deleteFile();
+    std::unique_ptr<FileOutputStream> outputStream(outputFile.createOutputStream());
+    if (outputStream == nullptr)
+      ConsoleApplication::fail("Unable to open output file: " + outputFile.getFullPathName());
+
+    std::unique_ptr<AudioFormatWriter> writer(outputFormat->createWriterFor(outputStream.get(), cloud.mSamplingRate,
+                                                                            static_cast<unsigned int>(settings.mNumChannels),
+                                                                            bitsPerSample, {}, 0));
+    if (writer == nullptr)
+      ConsoleApplication::fail("Unable to create a " + String(bitsPerSample) + " bit writer for " + outputFile.getFileName());
+
+    // The Writer Now Owns the Stream
+    outputStream.release();
+
+    // Render and Write Each Block
+    const OfflineRenderStats stats = OfflineRenderer::Render(cloud, settings,
+      [&writer](const AudioBuffer<float>& block, int numSamples)
+      {
+        writer->writeFromAudioSampleBuffer(block, 0, numSamples);
+      });
+
+    writer.reset();
+
+    std::cout << "Rendered " << String(stats.mAudioSeconds, 2) << " s of audio in "
+              << String(stats.mRenderSeconds, 3) << " s ("
+              << String(stats.GetRealTimeFactor(), 1) << "x real time)" << std::endl;
+    std::cout << "Wrote " << outputFile.getFullPathName() << std::endl;
+  }
+
+  /**
+   *\fn: SuiteCommand
+   *\brief: Handles "--record" and "--verify": Runs Every Case of a Regression Suite
+   *\param: const ArgumentList& args - Command Line Arguments
+   *\param: bool record - True to Record New References, False to Compare Against Them
+   */
+  void SuiteCommand(const ArgumentList& args, bool record)
+  {
+    // Verify can Render with Workers, to Check they do not Change the Output
+    const int numThreads = args.containsOption("--threads") ? jmax(0, args.getValueForOption("--threads").getIntValue()) : -1;
+    const RegressionSuite suite(args.getExistingFolderForOption("--suite"), numThreads);
+    const Array<File> cases = suite.GetCases(args.getValueForOption("--filter"));
+
+    if (cases.isEmpty())
+      ConsoleApplication::fail("No cases found in " + args.getValueForOption("--suite"));
+
+    int numFailed = 0;
+
+    for (const File& caseFile : cases)
+    {
+      const RegressionResult result = record ? suite.Record(caseFile) : suite.Verify(caseFile);
+
+      // Outcome of the Comparison, or Why there was None
+      String outcome;
+
+      if (result.mError.isNotEmpty())
+        outcome = result.mError;
+      else if (record)
+        outcome = "recorded";
+      else if (result.mBitExact)
+        outcome = "bit exact";
+      else
+        outcome = "SNR " + String(result.mSnrDb, 1) + " dB (min " + String(result.mMinSnrDb, 1) + " dB), max error "
+                  + String(result.mMaxError, 8);
+
+      std::cout << (result.mPassed ? "PASS  " : "FAIL  ") << result.mName.paddedRight(' ', 24)
+                << String(result.mStats.mRenderSeconds, 3) << " s ("
+                << String(result.mStats.GetRealTimeFactor(), 1) << "x real time)  " << outcome << std::endl;
+
+      if (!result.mPassed)
+        ++numFailed;
+    }
+
+    std::cout << (cases.size() - numFailed) << " of " << cases.size() << " cases "
+              << (record ? "recorded" : "passed") << std::endl;
+
+    if (numFailed > 0)
+      ConsoleApplication::fail(String(numFailed) + " cases failed");
+  }
+}
+
+//==============================================================================
+int main (int argc, char* argv[])
+{
+  ConsoleApplication app;
+
+  app.addHelpCommand("--help|-h", "Usage:", true);
+
+  app.addDefaultCommand({ "--render",
+                          "--render --input <source> --params <file.json> --output <file.wav> [--length <seconds>] [--block-size <samples>] [--threads <workers>] [--sample-rate <hz>] [--bits <16|24|32>] [--dither] [--memory-map]",
+                          "Renders a grain cloud to disk faster than real time.",
+                          "Reads a WAV/FLAC source and a JSON parameter file (centroidSample, duration, startingOffset,\n"
+                          "cloudSize, schedule (continuous, synchronous or asynchronous), density, jitter, pitchOffsetMin/Max, gainOffsetDbMin/Max, globalGainDb, randomPanning, envelopeShape,\n"
+                          "envelopeAttack, envelopeRelease, interpolation (linear, hermite or sinc, default sinc), output (softClip or limiter),\n"
+                          "modulators (up to 4 of { shape, target, rate, depth }, see Examples/ModulatedCloud.json),\n"
+                          "seed, length, blockSize, channels, threads), renders the cloud offline and writes it to the output file.\n"
+                          "The render is identical for any number of worker threads (the default leaves one core free).\n"
+                          "--memory-map reads an uncompressed WAV source straight from disk instead of decoding it into memory.\n"
+                          "--sample-rate renders at another rate than the source's, converting the source into memory first.\n"
+                          "--dither adds triangular dither before 16 or 24 bit output is written.\n"
+                          "Reports the render speed as a multiple of real time.",
+                          RenderCommand });
+
+  app.addCommand({ "--verify",
+                   "--verify --suite <directory> [--filter <name>] [--threads <workers>]",
+                   "Checks that the engine still renders the regression suite's references.",
+                   "Renders every JSON parameter file in the suite from a built-in synthetic source and compares it against\n"
+                   "the .wav reference recorded beside it. A case passes when it is bit exact, or when its SNR against the\n"
+                   "reference is at least the case's minSnrDb (default 100 dB). Prints the render time of each case.\n"
+                   "The references are rendered on one thread, --threads renders with workers instead, which must not\n"
+                   "change the output.\n"
+                   "Fails if any case fails, or has no reference.",
+                   [](const ArgumentList& args) { SuiteCommand(args, false); } });
+
+  app.addCommand({ "--record",
+                   "--record --suite <directory> [--filter <name>]",
+                   "Records new references for the regression suite.",
+                   "Renders every JSON parameter file in the suite and writes each render beside it as a 32 bit float .wav,\n"
+                   "replacing the old reference. Only record after checking that a change is meant to alter the sound.",
+                   [](const ArgumentList& args) { SuiteCommand(args, true); } });
+
+  return app.findAndRunCommand(argc, argv);
+}
@@ -0,0 +1,179 @@
+/*****************************************************************************/
+/*!
+\file   OfflineRenderer.cpp
+\author Anthony Brigante
+\par    email: anthonypbrigante\@gmail.com
+\par    GitHub Repository: https://github.com/abrigante1/GranularSynth
+\brief
+  This is the Implementation of the OfflineRenderer Class
+*/
+/*****************************************************************************/
+
+#include "OfflineRenderer.h"
+
+// ------------------------------------------------------------------------------------
+// ------------------------------------------------------------------------------------
+// ------------------------------------------------------------------------------------
+
+bool OfflineRenderer::LoadSettings(const File& file, OfflineRenderSettings& settings, String& error)
+{
+  if (!file.existsAsFile())
+  {
+    error = "Parameter file not found: " + file.getFullPathName();
+    return false;
+  }
+
+  const var json = JSON::parse(file);
+
+  if (!json.isObject())
+  {
+    error = "Parameter file is not a JSON object: " + file.getFullPathName();
+    return false;
+  }
+
+  ParseSettings(json, settings);
+  return true;
+}
+
+// ------------------------------------------------------------------------------------
+
+void OfflineRenderer::ParseSettings(const var& json, OfflineRenderSettings& settings)
+{
+  GrainParameters& parameters = settings.mParameters;
+
+  // Cloud Parameters (Same Units as the GUI)
+  parameters.mCentroidSample  = static_cast<int>(json.getProperty("centroidSample", parameters.mCentroidSample));
+  parameters.mDuration        = static_cast<int>(json.getProperty("duration", parameters.mDuration));
+  parameters.mStartingOffset  = static_cast<int>(json.getProperty("startingOffset", parameters.mStartingOffset));
+  parameters.mCloudSize       = static_cast<int>(json.getProperty("cloudSize", parameters.mCloudSize));
+  parameters.mPitchOffsetMin  = static_cast<double>(json.getProperty("pitchOffsetMin", parameters.mPitchOffsetMin));
+  parameters.mPitchOffsetMax  = static_cast<double>(json.getProperty("pitchOffsetMax", parameters.mPitchOffsetMax));
+  parameters.mGainOffsetDbMin = static_cast<int>(json.getProperty("gainOffsetDbMin", parameters.mGainOffsetDbMin));
+  parameters.mGainOffsetDbMax = static_cast<int>(json.getProperty("gainOffsetDbMax", parameters.mGainOffsetDbMax));
+  parameters.mEnvelopeAttack  = static_cast<double>(json.getProperty("envelopeAttack", parameters.mEnvelopeAttack));
+  parameters.mEnvelopeRelease = static_cast<double>(json.getProperty("envelopeRelease", parameters.mEnvelopeRelease));
+  parameters.mRandomPanning   = static_cast<bool>(json.getProperty("randomPanning", parameters.mRandomPanning));
+  parameters.mDensity         = static_cast<double>(json.getProperty("density", parameters.mDensity));
+  parameters.mJitter          = static_cast<double>(json.getProperty("jitter", parameters.mJitter));
+
+  // Envelope Shape by Name (e.g. "hann")
+  const String shapeNames[] = { "trapezoid", "hann", "tukey", "gaussian", "exponentialDecay" };
+  const String shape = json.getProperty("envelopeShape", shapeNames[parameters.mEnvelopeShape]).toString();
+
+  for (int i = 0; i < NUMBER_OF_ENVELOPE_SHAPES; ++i)
+    if (shape.equalsIgnoreCase(shapeNames[i]))
+      parameters.mEnvelopeShape = static_cast<EnvelopeShape>(i);
+
+  // Grain Schedule by Name (e.g. "asynchronous")
+  const String scheduleNames[] = { "continuous", "synchronous", "asynchronous" };
+  const String schedule = json.getProperty("schedule", scheduleNames[parameters.mSchedule]).toString();
+
+  for (int i = 0; i < NUMBER_OF_GRAIN_SCHEDULES; ++i)
+    if (schedule.equalsIgnoreCase(scheduleNames[i]))
+      parameters.mSchedule = static_cast<GrainSchedule>(i);
+
+  // Interpolation by Name, Offline Renders Default to the Highest Quality
+  const String interpolationNames[] = { "linear", "hermite", "sinc" };
+  const String interpolation = json.getProperty("interpolation", interpolationNames[SINC]).toString();
+
+  for (int i = 0; i < NUMBER_OF_INTERPOLATION_QUALITIES; ++i)
+    if (interpolation.equalsIgnoreCase(interpolationNames[i]))
+      parameters.mInterpolation = static_cast<InterpolationQuality>(i);
+
+  // Modulators as an Array of Objects (e.g. { "shape": "triangle", "target": "pitch", "rate": 0.5, "depth": 0.25 })
+  const String modulationShapeNames[] = { "sine", "triangle", "saw", "square", "randomWalk", "envelopeRise", "envelopeFall" };
+  const String modulationTargetNames[] = { "none", "centroid", "startingOffset", "pitch", "grainGain", "globalGain", "density" };
+
+  if (const Array<var>* modulators = json.getProperty("modulators", var()).getArray())
+  {
+    for (int m = 0; m < jmin(modulators->size(), ModulationMatrix::NumModulators); ++m)
+    {
+      const var modulator = (*modulators)[m];
+      ModulatorParameters& routing = parameters.mModulators[m];
+
+      const String modulationShape = modulator.getProperty("shape", modulationShapeNames[routing.mShape]).toString();
+      const String modulationTarget = modulator.getProperty("target", modulationTargetNames[routing.mTarget]).toString();
+
+      for (int i = 0; i < NUMBER_OF_MODULATION_SHAPES; ++i)
+        if (modulationShape.equalsIgnoreCase(modulationShapeNames[i]))
+          routing.mShape = static_cast<ModulationShape>(i);
+
+      for (int i = 0; i < NUMBER_OF_MODULATION_TARGETS; ++i)
+        if (modulationTarget.equalsIgnoreCase(modulationTargetNames[i]))
+          routing.mTarget = static_cast<ModulationTarget>(i);
+
+      routing.mRate  = static_cast<double>(modulator.getProperty("rate", routing.mRate));
+      routing.mDepth = jlimit(0.0, 1.0, static_cast<double>(modulator.getProperty("depth", routing.mDepth)));
+    }
+  }
+
+  const double globalGainDb = json.getProperty("globalGainDb", Decibels::gainToDecibels(parameters.mGlobalGain));
+  parameters.mGlobalGain = Decibels::decibelsToGain(globalGainDb);
+
+  // Output Limiting by Name
+  const String limitingNames[] = { "softClip", "limiter" };
+  const String limiting = json.getProperty("output", limitingNames[settings.mLimiting]).toString();
+
+  for (int i = 0; i < NUMBER_OF_OUTPUT_LIMITINGS; ++i)
+    if (limiting.equalsIgnoreCase(limitingNames[i]))
+      settings.mLimiting = static_cast<OutputLimiting>(i);
+
+  // Render Settings
+  settings.mSeed          = static_cast<int64>(json.getProperty("seed", settings.mSeed));
+  settings.mLengthSeconds = static_cast<double>(json.getProperty("length", settings.mLengthSeconds));
+  settings.mBlockSize     = jmax(1, static_cast<int>(json.getProperty("blockSize", settings.mBlockSize)));
+  settings.mNumChannels   = jlimit(1, 2, static_cast<int>(json.getProperty("channels", settings.mNumChannels)));
+  settings.mNumThreads    = static_cast<int>(json.getProperty("threads", settings.mNumThreads));
+}
+
+// ------------------------------------------------------------------------------------
+
+OfflineRenderStats OfflineRenderer::Render(GrainCloud& cloud, const OfflineRenderSettings& settings,
+                                           const BlockCallback& onBlock)
+{
+  OfflineRenderStats stats;
+
+  const double sampleRate = cloud.mSamplingRate;
+  stats.mNumSamples = static_cast<int64>(settings.mLengthSeconds * sampleRate);
+  stats.mAudioSeconds = static_cast<double>(stats.mNumSamples) / jmax(1.0, sampleRate);
+
+  // Size the Pool for the Requested Cloud and Apply the Parameters
+  cloud.Prepare(jmax(GrainCloud::DefaultMaxCloudSize, settings.mParameters.mCloudSize), settings.mBlockSize);
+  cloud.SetSeed(settings.mSeed);
+  cloud.GetParameters() = settings.mParameters;
+  cloud.PublishParameters();
+  cloud.mIsPlaying = true;
+
+  // The Output does not Depend on the Number of Workers, Only the Speed Does
+  GrainEngine engine;
+  engine.Prepare((settings.mNumThreads < 0) ? GrainEngine::GetDefaultNumWorkers() : settings.mNumThreads);
+
+  GrainCloud* clouds[] = { &cloud };
+
+  OutputStage output;
+  output.SetLimiting(settings.mLimiting);
+  output.Prepare(sampleRate);
+
+  AudioBuffer<float> block(settings.mNumChannels, settings.mBlockSize);
+  int64 renderTicks = 0;
+
+  for (int64 position = 0; position < stats.mNumSamples; position += settings.mBlockSize)
+  {
+    const int numSamples = static_cast<int>(jmin(static_cast<int64>(settings.mBlockSize), stats.mNumSamples - position));
+
+    // Only the Engine is Timed, Not the Consumer of the Block
+    const int64 startTicks = Time::getHighResolutionTicks();
+    engine.Render(clouds, 1, block, 0, numSamples);
+    output.Process(block, 0, numSamples);
+    renderTicks += Time::getHighResolutionTicks() - startTicks;
+
+    if (settings.mDitherBits > 0)
+      output.Dither(block, 0, numSamples, settings.mDitherBits);
+
+    if (onBlock)
+      onBlock(block, numSamples);
+  }
+
+  stats.mRenderSeconds = Time::highResolutionTicksToSeconds(renderTicks);
+  return stats;
+}
@@ -0,0 +1,106 @@
+/*****************************************************************************/
+/*!
+\file   OfflineRenderer.h
+\author Anthony Brigante
+\par    email: anthonypbrigante\@gmail.com
+\par    GitHub Repository: https://github.com/abrigante1/GranularSynth
+\brief
+  Definition of the OfflineRenderer Class. The OfflineRenderer drives a
+  GrainCloud without an audio device, as fast as the machine allows.
+*/
+/*****************************************************************************/
+#pragma once
+
+#include <JuceHeader.h>
+#include "../../GranularSynth/Source/Grain.h"
+#include "../../GranularSynth/Source/GrainEngine.h"
+#include "../../GranularSynth/Source/OutputStage.h"
+
+/**
+ *\struct: OfflineRenderSettings
+ *\author: Anthony Brigante
+ *\brief:
+    The OfflineRenderSettings Struct describes a single offline render,
+    as read from a parameter file.
+ */
+struct OfflineRenderSettings
+{
+  GrainParameters mParameters;  //!< Parameters of the Grain Cloud
+  int64 mSeed = 1;              //!< Seed of the Cloud's Random Number Generator
+  double mLengthSeconds = 10.0; //!< Length of the Render (in seconds)
+  int mBlockSize = 512;         //!< Number of Samples Rendered per Block
+  int mNumChannels = 2;         //!< Number of Output Channels
+  int mNumThreads = -1;         //!< Number of Worker Threads (-1 Uses GrainEngine::GetDefaultNumWorkers)
+  OutputLimiting mLimiting = SOFT_CLIP; //!< How the Output is Kept Within Full Scale
+  int mDitherBits = 0;          //!< Bit Depth to Dither the Output for (0 for no Dither)
+};
+
+/**
+ *\struct: OfflineRenderStats
+ *\author: Anthony Brigante
+ *\brief:
+    The OfflineRenderStats Struct reports how long an offline render took.
+ */
+struct OfflineRenderStats
+{
+  int64 mNumSamples = 0;        //!< Number of Samples Rendered (per channel)
+  double mAudioSeconds = 0.0;   //!< Length of the Rendered Audio (in seconds)
+  double mRenderSeconds = 0.0;  //!< Time Spent Inside the Engine (in seconds)
+
+  /**
+   *\fn: GetRealTimeFactor
+   *\brief: Gets the Render Speed as a Multiple of Real Time
+   *\return: double - Seconds of Audio Rendered per Second of Processing
+   */
+  double GetRealTimeFactor() const
+  {
+    return (mRenderSeconds > 0.0) ? (mAudioSeconds / mRenderSeconds) : 0.0;
+  }
+};
+
+/**
+ *\class: OfflineRenderer
+ *\author: Anthony Brigante
+ *\brief:
+    The OfflineRenderer loads an audio source into a GrainCloud, applies a
+    set of OfflineRenderSettings and renders the cloud block by block
+    through an OutputStage, handing each block to a callback (e.g. to
+    write it to disk).
+ */
+class OfflineRenderer
+{
+public:
+
+  //! Called with Each Rendered Block and the Number of Valid Samples in it
+  using BlockCallback = std::function<void(const AudioBuffer<float>& block, int numSamples)>;
+
+  /**
+   *\fn: LoadSettings
+   *\brief: Reads OfflineRenderSettings from a JSON Parameter File.
+            Keys that are Missing Keep their Default Values.
+   *\param: const File& file - Parameter File to Read
+   *\param: OfflineRenderSettings& settings - Receives the Settings
+   *\param: String& error - Receives a Description of the Problem on Failure
+   *\return: bool - True if the File was Read Successfully
+   */
+  static bool LoadSettings(const File& file, OfflineRenderSettings& settings, String& error);
+
+  /**
+   *\fn: ParseSettings
+   *\brief: Reads OfflineRenderSettings from a Parsed JSON Object
+   *\param: const var& json - Parsed Parameter Object
+   *\param: OfflineRenderSettings& settings - Receives the Settings
+   */
+  static void ParseSettings(const var& json, OfflineRenderSettings& settings);
+
+  /**
+   *\fn: Render
+   *\brief: Renders a Grain Cloud Offline
+   *\param: GrainCloud& cloud - Cloud to Render, its Audio Source must Already be Set
+   *\param: const OfflineRenderSettings& settings - Settings of the Render
+   *\param: const BlockCallback& onBlock - Called with Every Rendered Block (may be null)
+   *\return: OfflineRenderStats - Timing of the Render (excluding the callback)
+   */
+  static OfflineRenderStats Render(GrainCloud& cloud, const OfflineRenderSettings& settings,
+                                   const BlockCallback& onBlock);
+};
@@ -0,0 +1,227 @@
+/*****************************************************************************/
+/*!
+\file   RegressionSuite.cpp
+\author Anthony Brigante
+\par    email: anthonypbrigante\@gmail.com
+\par    GitHub Repository: https://github.com/abrigante1/GranularSynth
+\brief
+  Implementation of the RegressionSuite Class.
+*/
+/*****************************************************************************/
+
+#include "RegressionSuite.h"
+#include <cmath>
+#include <cstring>
+#include <limits>
+
+// ------------------------------------------------------------------------------------
+// ------------------------------------------------------------------------------------
+// ------------------------------------------------------------------------------------
+
+RegressionSuite::RegressionSuite(const File& directory, int numThreads)
+  : mDirectory(directory), mNumThreads(numThreads)
+{
+}
+
+// ------------------------------------------------------------------------------------
+
+Array<File> RegressionSuite::GetCases(const String& filter) const
+{
+  Array<File> cases;
+
+  for (const File& file : mDirectory.findChildFiles(File::findFiles, false, "*.json"))
+    if (filter.isEmpty() || file.getFileNameWithoutExtension().containsIgnoreCase(filter))
+      cases.add(file);
+
+  cases.sort();
+  return cases;
+}
+
+// ------------------------------------------------------------------------------------
+
+RegressionResult RegressionSuite::Record(const File& caseFile) const
+{
+  RegressionResult result;
+  AudioBuffer<float> rendered;
+
+  if (!RenderCase(caseFile, -1, rendered, result))
+    return result;
+
+  const File referenceFile = GetReferenceFile(caseFile);
+  referenceFile.deleteFile();
+
+  std::unique_ptr<FileOutputStream> stream(referenceFile.createOutputStream());
+  if (stream == nullptr)
+  {
+    result.mError = "Unable to open " + referenceFile.getFullPathName();
+    return result;
+  }
+
+  // 32 Bit WAVs are Float, so the Reference Holds the Render Exactly
+  WavAudioFormat wav;
+  std::unique_ptr<AudioFormatWriter> writer(wav.createWriterFor(stream.get(), SourceSampleRate,
+                                                                static_cast<unsigned int>(rendered.getNumChannels()),
+                                                                32, {}, 0));
+  if (writer == nullptr)
+  {
+    result.mError = "Unable to create a writer for " + referenceFile.getFullPathName();
+    return result;
+  }
+
+  // The Writer Now Owns the Stream
+  stream.release();
+
+  result.mPassed = writer->writeFromAudioSampleBuffer(rendered, 0, rendered.getNumSamples());
+  if (!result.mPassed)
+    result.mError = "Unable to write " + referenceFile.getFullPathName();
+
+  return result;
+}
+
+// ------------------------------------------------------------------------------------
+
+RegressionResult RegressionSuite::Verify(const File& caseFile) const
+{
+  RegressionResult result;
+  AudioBuffer<float> rendered;
+
+  if (!RenderCase(caseFile, mNumThreads, rendered, result))
+    return result;
+
+  const File referenceFile = GetReferenceFile(caseFile);
+
+  WavAudioFormat wav;
+  std::unique_ptr<AudioFormatReader> reader(referenceFile.existsAsFile()
+                                            ? wav.createReaderFor(new FileInputStream(referenceFile), true)
+                                            : nullptr);
+  if (reader == nullptr)
+  {
+    result.mError = "No reference, record one with --record";
+    return result;
+  }
+
+  AudioBuffer<float> reference(static_cast<int>(reader->numChannels), static_cast<int>(reader->lengthInSamples));
+  reader->read(&reference, 0, reference.getNumSamples(), 0, true, true);
+
+  Compare(rendered, reference, result);
+  return result;
+}
+
+// ------------------------------------------------------------------------------------
+
+bool RegressionSuite::RenderCase(const File& caseFile, int numThreads, AudioBuffer<float>& output,
+                                 RegressionResult& result)
+{
+  result.mName = caseFile.getFileNameWithoutExtension();
+
+  OfflineRenderSettings settings;
+
+  if (!OfflineRenderer::LoadSettings(caseFile, settings, result.mError))
+    return false;
+
+  if (numThreads >= 0)
+    settings.mNumThreads = numThreads;
+
+  // Keys Only the Suite Reads
+  const var json = JSON::parse(caseFile);
+  const int sourceChannels = jlimit(1, 2, static_cast<int>(json.getProperty("sourceChannels", 2)));
+  result.mMinSnrDb = static_cast<double>(json.getProperty("minSnrDb", DefaultMinSnrDb));
+
+  GrainCloud cloud;
+  cloud.SetAudioSource(MakeSource(sourceChannels), SourceSampleRate);
+
+  output.setSize(settings.mNumChannels, static_cast<int>(settings.mLengthSeconds * SourceSampleRate));
+  output.clear();
+  int position = 0;
+
+  result.mStats = OfflineRenderer::Render(cloud, settings,
+    [&output, &position](const AudioBuffer<float>& block, int numSamples)
+    {
+      for (int channel = 0; channel < output.getNumChannels(); ++channel)
+        output.copyFrom(channel, position, block, channel, 0, numSamples);
+
+      position += numSamples;
+    });
+
+  return true;
+}
+
+// ------------------------------------------------------------------------------------
+
+AudioBuffer<float> RegressionSuite::MakeSource(int numChannels)
+{
+  AudioBuffer<float> source(numChannels, SourceLength);
+  GrainRandom random(42);
+
+  for (int channel = 0; channel < numChannels; ++channel)
+  {
+    float* samples = source.getWritePointer(channel);
+    double phase = 0.0;
+
+    // Channels Sweep Different Ranges, so Panning and Channel Mapping Show in the Output
+    for (int i = 0; i < SourceLength; ++i)
+    {
+      const double frequency = 110.0 * (channel + 1) + 880.0 * i / SourceLength;
+      phase += MathConstants<double>::twoPi * frequency / SourceSampleRate;
+
+      samples[i] = 0.5f * static_cast<float>(std::sin(phase)) + 0.05f * (random.NextFloat() - 0.5f);
+    }
+  }
+
+  return source;
+}
+
+// ------------------------------------------------------------------------------------
+
+void RegressionSuite::Compare(const AudioBuffer<float>& rendered, const AudioBuffer<float>& reference,
+                              RegressionResult& result)
+{
+  if (rendered.getNumChannels() != reference.getNumChannels() || rendered.getNumSamples() != reference.getNumSamples())
+  {
+    result.mError = "Reference is " + String(reference.getNumChannels()) + " x " + String(reference.getNumSamples())
+                    + " samples, render is " + String(rendered.getNumChannels()) + " x " + String(rendered.getNumSamples());
+    return;
+  }
+
+  const size_t channelBytes = sizeof(float) * static_cast<size_t>(rendered.getNumSamples());
+  result.mBitExact = true;
+
+  double referenceEnergy = 0.0;
+  double errorEnergy = 0.0;
+
+  for (int channel = 0; channel < rendered.getNumChannels(); ++channel)
+  {
+    const float* renderedSamples = rendered.getReadPointer(channel);
+    const float* referenceSamples = reference.getReadPointer(channel);
+
+    if (std::memcmp(renderedSamples, referenceSamples, channelBytes) == 0)
+    {
+      for (int i = 0; i < rendered.getNumSamples(); ++i)
+        referenceEnergy += static_cast<double>(referenceSamples[i]) * referenceSamples[i];
+
+      continue;
+    }
+
+    result.mBitExact = false;
+
+    for (int i = 0; i < rendered.getNumSamples(); ++i)
+    {
+      const double error = static_cast<double>(renderedSamples[i]) - referenceSamples[i];
+      referenceEnergy += static_cast<double>(referenceSamples[i]) * referenceSamples[i];
+      errorEnergy += error * error;
+      result.mMaxError = jmax(result.mMaxError, static_cast<float>(std::abs(error)));
+    }
+  }
+
+  if (result.mBitExact || errorEnergy == 0.0)
+  {
+    result.mSnrDb = std::numeric_limits<double>::infinity();
+    result.mPassed = true;
+    return;
+  }
+
+  // A Silent Reference Accepts no Difference at All (NaNs Fail the Comparison Too)
+  result.mSnrDb = (referenceEnergy > 0.0) ? 10.0 * std::log10(referenceEnergy / errorEnergy)
+                                          : -std::numeric_limits<double>::infinity();
+  result.mPassed = (result.mSnrDb >= result.mMinSnrDb);
+}
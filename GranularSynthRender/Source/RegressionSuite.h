@@ -0,0 +1,141 @@
+/*****************************************************************************/
+/*!
+\file   RegressionSuite.h
+\author Anthony Brigante
+\par    email: anthonypbrigante\@gmail.com
+\par    GitHub Repository: https://github.com/abrigante1/GranularSynth
+\brief
+  Definition of the RegressionSuite Class, which Renders Fixed Parameter
+  Files and Compares the Output Against Recorded Reference Renders.
+*/
+/*****************************************************************************/
+#pragma once
+
+#include <JuceHeader.h>
+#include "OfflineRenderer.h"
+
+/**
+ *\struct: RegressionResult
+ *\author: Anthony Brigante
+ *\brief:
+    The RegressionResult Struct reports how one case of a RegressionSuite
+    compared against its reference, and how long it took to render.
+ */
+struct RegressionResult
+{
+  String mName;                 //!< Name of the Case (its Parameter File, Without Extension)
+  bool mPassed = false;         //!< True if the Render Matched its Reference (or was Recorded)
+  bool mBitExact = false;       //!< True if Every Sample Matched its Reference Exactly
+  double mSnrDb = 0.0;          //!< Reference Energy over Difference Energy (in dB), when not Bit Exact
+  double mMinSnrDb = 0.0;       //!< Lowest SNR the Case Accepts (in dB)
+  float mMaxError = 0.0f;       //!< Largest Difference from the Reference
+  OfflineRenderStats mStats;    //!< Timing of the Render
+  String mError;                //!< Why the Case Failed, if it Failed Before Comparing
+};
+
+/**
+ *\class: RegressionSuite
+ *\author: Anthony Brigante
+ *\brief:
+    The RegressionSuite Class runs every JSON parameter file in a directory
+    as a case. Each case is rendered from the same synthetic source (a chirp
+    with a little noise, so no audio files have to be kept with the suite)
+    with the case's seed, and written next to it as a 32 bit float WAV by
+    Record, or compared against that WAV by Verify.
+
+    A case passes when its render is bit exact, or failing that when the
+    difference from the reference is at least minSnrDb below it, so a kernel
+    that only rounds differently (e.g. reassociated SIMD sums) still passes
+    while one that changes the sound does not. Besides the keys
+    OfflineRenderer reads, a case may set "minSnrDb" and "sourceChannels".
+
+    The cases pin "threads" to 0, so a reference never depends on how the
+    GrainEngine hands out partitions. Verify can override the worker count,
+    which checks that the output is the same for any number of workers.
+ */
+class RegressionSuite
+{
+public:
+
+  //! Sample Rate of the Synthetic Source and of Every Render (in Hz)
+  static constexpr double SourceSampleRate = 48000.0;
+
+  //! Length of the Synthetic Source (in samples)
+  static constexpr int SourceLength = 96000;
+
+  //! Lowest SNR a Case Accepts when it does not Set "minSnrDb" (in dB)
+  static constexpr double DefaultMinSnrDb = 100.0;
+
+  /**
+   *\fn: RegressionSuite
+   *\brief: Constructor for a RegressionSuite
+   *\param: const File& directory - Directory Holding the Cases and their References
+   *\param: int numThreads - Worker Threads Verify Renders With (-1 Uses Each Case's "threads")
+   */
+  explicit RegressionSuite(const File& directory, int numThreads = -1);
+
+  /**
+   *\fn: GetCases
+   *\brief: Finds the Parameter Files of the Suite, Sorted by Name
+   *\param: const String& filter - Only Cases Whose Name Contains this are Returned (Empty for All)
+   *\return: Array<File> - The Parameter Files
+   */
+  Array<File> GetCases(const String& filter) const;
+
+  /**
+   *\fn: Record
+   *\brief: Renders a Case with its Own Worker Count and Writes its Output as the New Reference
+   *\param: const File& caseFile - Parameter File of the Case
+   *\return: RegressionResult - Timing of the Render, and the Error if it could not be Written
+   */
+  RegressionResult Record(const File& caseFile) const;
+
+  /**
+   *\fn: Verify
+   *\brief: Renders a Case and Compares its Output Against the Reference
+   *\param: const File& caseFile - Parameter File of the Case
+   *\return: RegressionResult - Outcome and Timing of the Comparison
+   */
+  RegressionResult Verify(const File& caseFile) const;
+
+  /**
+   *\fn: GetReferenceFile
+   *\brief: Gets the Reference Render of a Case
+   *\param: const File& caseFile - Parameter File of the Case
+   *\return: File - The Reference (the Parameter File with a .wav Extension)
+   */
+  static File GetReferenceFile(const File& caseFile) { return caseFile.withFileExtension("wav"); }
+
+private:
+
+  File mDirectory;  //!< Directory Holding the Cases and their References
+  int mNumThreads;  //!< Worker Threads Verify Renders With (-1 Uses Each Case's Own)
+
+  /**
+   *\fn: RenderCase
+   *\brief: Renders a Case from the Synthetic Source into a Buffer
+   *\param: const File& caseFile - Parameter File of the Case
+   *\param: int numThreads - Worker Threads to Render With (-1 Uses the Case's "threads")
+   *\param: AudioBuffer<float>& output - Receives the Whole Render
+   *\param: RegressionResult& result - Receives the Timing, the Accepted SNR, or the Error
+   *\return: bool - True if the Case was Rendered
+   */
+  static bool RenderCase(const File& caseFile, int numThreads, AudioBuffer<float>& output, RegressionResult& result);
+
+  /**
+   *\fn: MakeSource
+   *\brief: Builds the Deterministic Source Every Case is Rendered From
+   *\param: int numChannels - Number of Channels of the Source
+   *\return: AudioBuffer<float> - The Source Audio
+   */
+  static AudioBuffer<float> MakeSource(int numChannels);
+
+  /**
+   *\fn: Compare
+   *\brief: Measures how far a Render is from its Reference
+   *\param: const AudioBuffer<float>& rendered - The New Render
+   *\param: const AudioBuffer<float>& reference - The Reference Render
+   *\param: RegressionResult& result - Receives the Outcome of the Comparison
+   */
+  static void Compare(const AudioBuffer<float>& rendered, const AudioBuffer<float>& reference, RegressionResult& result);
+};